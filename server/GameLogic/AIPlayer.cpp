@@ -0,0 +1,147 @@
+#include "AIPlayer.h"
+
+#include "Board.h"
+#include "Trace.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+// forward declare utilities in main.cpp
+void announce(const std::string& message);
+
+/**
+ * @return Returns the name of a square as the human player types it, e.g. "C3".
+ * @param square The playable square
+ */
+static std::string getSquareName(int square)
+{
+    coords_t coords = Board::getCoordsFromSquare(square);
+    return std::string(1, (char)('A' + coords[0])) + std::to_string(coords[1] + 1);
+}
+
+/**
+ * Gets a move, by searching for the best one, and applies it to the board.
+ * @param board The board to apply the move to
+ */
+void AIPlayer::getMove(Board& board)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    // search the position as this player sees it (it is always this player's turn when asked for a move)
+    BasicBoard<EnglishRules> position(board.getPieceMask(true), board.getPieceMask(false),
+                                      board.getKingMask(true) | board.getKingMask(false), isWhite);
+
+    // the opponent has moved, so any pondering is over (and the search is free again)
+    SearchResult pondered;
+    bool ponderHit = ponder != nullptr && ponder->finish(position, pondered);
+
+    gameHistory.push_back(board.getHash());
+    search.setGameHistory(gameHistory);
+    SearchLimits moveLimits = hasClock ? timeManager.allocate(clock, position, limits) : limits;
+
+    // a book move takes no searching at all
+    CompactMove bookMove;
+    BookEntry entry;
+    if (book != nullptr && book->chooseMove(position, random(), bookMove, &entry))
+    {
+        board.makeMove(bookMove);
+        gameHistory.push_back(board.getHash());
+        chargeClock(startTime);
+
+        std::ostringstream message;
+        message << getColor() << " (computer) moved " << getSquareName(bookMove.getFrom()) << " to "
+                << getSquareName(bookMove.getTo()) << " (opening book: " << entry.wins << " won, " << entry.draws
+                << " drawn, " << entry.losses << " lost)";
+        announce(message.str());
+        return;
+    }
+
+    // a ponder that has already searched as long as this move would have is as good as a search now;
+    // a shorter one has at least left its work in the table for the search to pick up
+    double softLimit = moveLimits.softMilliseconds > 0 ? moveLimits.softMilliseconds : moveLimits.maxMilliseconds / 2.0;
+    bool usePonder = ponderHit && pondered.hasMove && softLimit > 0 && pondered.seconds * 1000 >= softLimit;
+    SearchResult result = usePonder ? pondered : search.run(position, moveLimits);
+    if (!result.hasMove)
+    {
+        announce(getColor() + " (computer) has no moves.");
+        return;
+    }
+
+    // play it on the real board, so its pieces move too
+    board.makeMove(result.bestMove);
+    gameHistory.push_back(board.getHash());
+    chargeClock(startTime);
+
+    std::ostringstream message;
+    message << getColor() << " (computer) moved " << getSquareName(result.bestMove.getFrom())
+            << " to " << getSquareName(result.bestMove.getTo()) << " (" << (usePonder ? "pondered, " : "")
+            << "depth " << result.depth << ", ";
+    if (Search::isWinScore(result.score))
+        message << (result.score > 0 ? "wins" : "loses") << " in " << Search::WIN_SCORE - std::abs(result.score) << " plies";
+    else if (Search::isEndgameScore(result.score))
+        message << (result.score > 0 ? "wins" : "loses") << " by the endgame database";
+    else
+        message << "score " << std::showpos << std::fixed << std::setprecision(2) << result.score / 100.0 << std::noshowpos;
+    message << ", " << result.nodes << " nodes in " << std::fixed << std::setprecision(3) << result.seconds << " s";
+    if (hasClock)
+        message << ", " << std::setprecision(1) << clock.remainingMilliseconds / 1000.0 << " s left";
+    message << ")";
+    announce(message.str());
+    TRACE_DEBUG(message.str() << ", expecting a line of " << result.principalVariation.size() << " moves, "
+                << (int)(table.getHitRate() * 100) << "% table hits");
+
+    // think about the reply the search expects while the opponent does
+    if (ponder != nullptr && result.principalVariation.size() >= 2)
+    {
+        BasicBoard<EnglishRules> expected = position;
+        expected.makeMove(result.bestMove);
+        expected.makeMove(result.principalVariation[1]);
+        SearchLimits ponderLimits;
+        ponderLimits.maxDepth = limits.maxDepth;
+        ponder->start(expected, ponderLimits);
+    }
+}
+
+/**
+ * Puts the player on a clock: from now on, each move's time comes from what is left on it.
+ * @param clock The clock as it stands, which the player charges with the time it takes
+ */
+void AIPlayer::setClock(const GameClock& clock)
+{
+    this->clock = clock;
+    hasClock = true;
+}
+
+/**
+ * Turns thinking on the opponent's time on or off.
+ * @param enabled Whether to ponder
+ */
+void AIPlayer::setPondering(bool enabled)
+{
+    if (!enabled)
+        ponder.reset();
+    else if (ponder == nullptr)
+        ponder.reset(new PonderSearch(search));
+}
+
+/**
+ * Takes the time a move took off the clock, and adds the increment.
+ * @param startTime When the player was asked for the move
+ */
+void AIPlayer::chargeClock(std::chrono::steady_clock::time_point startTime)
+{
+    if (!hasClock)
+        return;
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+    clock.remainingMilliseconds += clock.incrementMilliseconds - (int)elapsed.count();
+}
+
+/**
+ * @return Returns a titlecase string representing this player's color
+ */
+std::string AIPlayer::getColor() const
+{
+    return isWhite ? "White" : "Black";
+}
@@ -0,0 +1,112 @@
+#ifndef AI_PLAYER_H
+#define AI_PLAYER_H
+
+#include "Player.h"
+#include "Typedefs.h"
+#include "Search.h"
+#include "ParallelSearch.h"
+#include "TranspositionTable.h"
+#include "OpeningBook.h"
+#include "PonderSearch.h"
+#include "TimeManager.h"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+class Board;
+
+/**
+ * A computer player, which picks its moves with an alpha-beta search (see Search.h)
+ * limited to a depth, a number of nodes or a time per move, run on one or more threads
+ * (see ParallelSearch.h). Given an opening book, it plays the book's moves while it has any,
+ * without searching.
+ *
+ * Given a clock, it keeps its own time: the time for each move comes from what it has left
+ * (see TimeManager.h) instead of a fixed limit. It can also ponder, searching the reply it
+ * expects while the opponent thinks (see PonderSearch.h).
+ */
+class AIPlayer : public Player
+{
+    private:
+	    const bool isWhite;
+	    SearchLimits limits;
+	    // kept from move to move, so each search starts with what the last ones learned
+	    TranspositionTable table;
+	    ParallelSearch search;
+	    // (may be null)
+	    const OpeningBook* book;
+	    // picks among the book's moves
+	    std::mt19937_64 random;
+
+	    // whether the player plays on a clock, and how it stands (its time is charged as it moves)
+	    bool hasClock;
+	    GameClock clock;
+	    TimeManager timeManager;
+	    // (null unless pondering is on; declared after search, so it stops before search goes)
+	    std::unique_ptr<PonderSearch> ponder;
+
+	    // the keys of the positions this player has seen in the game, so it can steer away from repeating them
+	    std::vector<hashkey_t> gameHistory;
+
+		/**
+		 * @return Returns a titlecase string representing this player's color
+		 */
+		std::string getColor() const;
+
+		/**
+		 * Takes the time a move took off the clock, and adds the increment.
+		 * @param startTime When the player was asked for the move
+		 */
+		void chargeClock(std::chrono::steady_clock::time_point startTime);
+
+	public:
+		/**
+		 * Constructor for the AIPlayer
+		 * @param isWhite Used to specify if this player is black or white.
+		 * @param limits How much to search for each move
+		 * @param hashMegabytes The size of the player's transposition table, in megabytes
+		 * @param threads How many threads to search with
+		 * @param weights The weights of the static evaluation
+		 */
+		AIPlayer(bool isWhite, const SearchLimits& limits, std::size_t hashMegabytes = 16, int threads = 1,
+		         const EvalWeights& weights = EvalWeights())
+			: isWhite(isWhite), limits(limits), table(hashMegabytes), search(table, threads, weights), book(nullptr),
+			  random(std::random_device()()), hasClock(false) {};
+
+		/**
+		 * Gets a move, by searching for the best one, and applies it to the board.
+		 * @param board The board to apply the move to
+		 */
+		virtual void getMove(Board& board);
+
+		/**
+		 * Sets the endgame database to look positions up in while searching.
+		 * @param endgames The database, which must outlive this player (or null for none)
+		 */
+		void setEndgameDatabase(const EndgameDatabase* endgames) { search.setEndgameDatabase(endgames); }
+
+		/**
+		 * Sets the opening book to play from before searching.
+		 * @param book The book, which must outlive this player (or null for none)
+		 */
+		void setOpeningBook(const OpeningBook* book) { this->book = book; }
+
+		/**
+		 * Puts the player on a clock: from now on, each move's time comes from what is left on it
+		 * (the depth and node limits still apply).
+		 * @param clock The clock as it stands, which the player charges with the time it takes
+		 */
+		void setClock(const GameClock& clock);
+
+		/**
+		 * Turns thinking on the opponent's time on or off.
+		 * @param enabled Whether to ponder
+		 */
+		void setPondering(bool enabled);
+};
+
+#endif
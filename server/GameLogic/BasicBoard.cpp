@@ -0,0 +1,453 @@
+#include "BasicBoard.h"
+
+#include "CompactMove.h"
+#include "WideMove.h"
+#include "Zobrist.h"
+
+/**
+ * Responsible for generating a brand new board, with each side's men on its first rows
+ * (white at the top, to move first).
+ */
+template <class Rules>
+BasicBoard<Rules>::BasicBoard() : kings(0), whiteToMove(true)
+{
+    // squares are numbered from the top left, so white's rows are the lowest squares and black's the highest
+    const int startingSquares = Rules::STARTING_ROWS * (SIZE / 2);
+    whitePieces = 0;
+    blackPieces = 0;
+    for (int square = 0; square < startingSquares; square++)
+    {
+        whitePieces |= getSquareMask(square);
+        blackPieces |= getSquareMask(PLAYABLE_SQUARES - 1 - square);
+    }
+
+    hash = computeHash();
+}
+
+/**
+ * Responsible for generating a board holding the given position.
+ * (Pieces may be on any playable square, so this can set up positions that never come up in a game)
+ * @param whitePieces The bitboard of the white pieces (kings included)
+ * @param blackPieces The bitboard of the black pieces (kings included)
+ * @param kings The bitboard of the kings of both colors
+ * @param whiteToMove Whether it is white's turn to move
+ */
+template <class Rules>
+BasicBoard<Rules>::BasicBoard(bitboard_type whitePieces, bitboard_type blackPieces, bitboard_type kings, bool whiteToMove)
+    : whitePieces(whitePieces), blackPieces(blackPieces & ~whitePieces),
+      kings(kings & (whitePieces | blackPieces)), whiteToMove(whiteToMove)
+{
+    hash = computeHash();
+}
+
+/**
+ * Applies the given move to this board in a way that can be taken back with unmakeMove.
+ * @param move The move to execute, which should be one generated for this board.
+ * @return Returns the record unmakeMove needs to take the move back.
+ */
+template <class Rules>
+typename BasicBoard<Rules>::undo_type BasicBoard<Rules>::makeMove(const move_type& move)
+{
+    return moveSquares(move.getFrom(), move.getTo(), move.getCaptureMask());
+}
+
+/**
+ * Takes back a move made with makeMove, putting the board back the way it was before it.
+ * Moves must be taken back in the reverse of the order they were made in.
+ * @param move The move to take back, which must be the last one made on this board.
+ * @param undo The record makeMove returned for that move.
+ */
+template <class Rules>
+void BasicBoard<Rules>::unmakeMove(const move_type& move, const undo_type& undo)
+{
+    unmoveSquares(move.getFrom(), move.getTo(), undo);
+}
+
+/**
+ * Moves the piece on one square to another, removing the captured pieces, crowning it if
+ * the move ends on the far row, and passing the turn.
+ * @param fromSquare The square of the piece to move
+ * @param toSquare The square it moves to
+ * @param captured The bitboard of the pieces to remove
+ * @return Returns the record needed to take the move back.
+ */
+template <class Rules>
+typename BasicBoard<Rules>::undo_type BasicBoard<Rules>::moveSquares(int fromSquare, int toSquare, bitboard_type captured)
+{
+    bitboard_type startingMask = getSquareMask(fromSquare);
+    bitboard_type endingMask = getSquareMask(toSquare);
+    bool isWhite = (whitePieces & startingMask) != 0;
+    bool wasKing = (kings & startingMask) != 0;
+
+    undo_type undo;
+    undo.captured = captured;
+    undo.capturedKings = captured & kings;
+    undo.previousHash = hash;
+
+    // remove any pieces jumped along the way
+    bitboard_type remaining = captured;
+    while (remaining)
+    {
+        int jumpedSquare = popLowestSquare(remaining);
+        hash ^= Zobrist::getPieceKey(!isWhite, (kings & getSquareMask(jumpedSquare)) != 0, jumpedSquare);
+    }
+    whitePieces &= ~captured;
+    blackPieces &= ~captured;
+    kings &= ~captured;
+
+    // men are only crowned where the move ends, never partway through a chain of jumps
+    bool isKing = wasKing || (endingMask & getCrowningRow(isWhite)) != 0;
+    undo.promoted = isKing && !wasKing;
+
+    hash ^= Zobrist::getPieceKey(isWhite, wasKing, fromSquare);
+    hash ^= Zobrist::getPieceKey(isWhite, isKing, toSquare);
+    if (isWhite)
+        whitePieces = (whitePieces & ~startingMask) | endingMask;
+    else
+        blackPieces = (blackPieces & ~startingMask) | endingMask;
+    kings &= ~startingMask;
+    if (isKing)
+        kings |= endingMask;
+
+    // and it's now the other side's turn
+    whiteToMove = !whiteToMove;
+    hash ^= Zobrist::getBlackToMoveKey();
+
+    return undo;
+}
+
+/**
+ * Takes back a move made with moveSquares.
+ * @param fromSquare The square the piece started on
+ * @param toSquare The square it moved to
+ * @param undo The record moveSquares returned
+ */
+template <class Rules>
+void BasicBoard<Rules>::unmoveSquares(int fromSquare, int toSquare, const undo_type& undo)
+{
+    bitboard_type startingMask = getSquareMask(fromSquare);
+    bitboard_type endingMask = getSquareMask(toSquare);
+    bool isWhite = (whitePieces & endingMask) != 0;
+    bool isKing = (kings & endingMask) != 0 && !undo.promoted;
+
+    // move the piece back to where it started, as a man again if the move crowned it
+    if (isWhite)
+    {
+        whitePieces = (whitePieces & ~endingMask) | startingMask;
+        blackPieces |= undo.captured;
+    }
+    else
+    {
+        blackPieces = (blackPieces & ~endingMask) | startingMask;
+        whitePieces |= undo.captured;
+    }
+    kings &= ~endingMask;
+    if (isKing)
+        kings |= startingMask;
+    kings |= undo.capturedKings;
+
+    whiteToMove = !whiteToMove;
+    hash = undo.previousHash;
+}
+
+/**
+ * Works out the Zobrist key of this position from scratch. (getHash() returns the same key,
+ * kept up to date move by move, so this is only needed to set it up or to check it)
+ * @return Returns the key of every piece on the board and the side to move.
+ */
+template <class Rules>
+hashkey_t BasicBoard<Rules>::computeHash() const
+{
+    hashkey_t key = whiteToMove ? 0 : Zobrist::getBlackToMoveKey();
+
+    bitboard_type pieces = getOccupiedMask();
+    while (pieces)
+    {
+        int square = popLowestSquare(pieces);
+        key ^= Zobrist::getPieceKey((whitePieces & getSquareMask(square)) != 0,
+                                    (kings & getSquareMask(square)) != 0, square);
+    }
+    return key;
+}
+
+/**
+ * @return Returns the bitboard of the row a man of the given color is crowned on.
+ * @param isWhite The color of the man
+ */
+template <class Rules>
+typename BasicBoard<Rules>::bitboard_type BasicBoard<Rules>::getCrowningRow(bool isWhite)
+{
+    // white moves toward +y, so it is crowned on the last row (the highest squares), and black on the first
+    bitboard_type row = ((bitboard_type)1 << (SIZE / 2)) - 1;
+    return isWhite ? row << (PLAYABLE_SQUARES - SIZE / 2) : row;
+}
+
+/**
+ * The order directions are tried in, for each color. Directions are numbered as in CompactMove
+ * (bit 0 set means +x, bit 1 set means +y), and the orders match the one Piece searches in:
+ * -x before +x, and forward before backward. A man only uses the first and third entries
+ * (stepping through the order two at a time), and a king uses all four.
+ */
+static const int DIRECTION_ORDER[2][4] = {
+    { 0, 2, 1, 3 }, // black moves toward -y
+    { 2, 0, 3, 1 }  // white moves toward +y
+};
+
+/**
+ * Generates every legal move for one side in a single pass over its pieces.
+ * Captures are mandatory, so if any jump is available only the jumps are returned
+ * (and under majority capture, only the chains taking the most pieces).
+ * @param isWhite The side to generate moves for
+ * @param moves The list to add the moves to
+ */
+template <class Rules>
+void BasicBoard<Rules>::getAllLegalMoves(bool isWhite, move_list_type& moves) const
+{
+    // finding out whether any jump exists is cheap, and tells us which kind of move to generate
+    if (hasAnyCapture(isWhite))
+    {
+        getAllCaptures(isWhite, moves);
+        return;
+    }
+
+    bitboard_type pieces = getPieceMask(isWhite);
+    while (pieces)
+    {
+        int square = popLowestSquare(pieces);
+        addSteps(square, isWhite, (kings & getSquareMask(square)) != 0, moves);
+    }
+}
+
+/**
+ * @return Returns true if any piece of the given side can jump.
+ * (Only checks single jumps, so it is much cheaper than generating the moves)
+ * @param isWhite The side to check
+ */
+template <class Rules>
+bool BasicBoard<Rules>::hasAnyCapture(bool isWhite) const
+{
+    bitboard_type opponentPieces = getPieceMask(!isWhite);
+    bitboard_type empty = ~getOccupiedMask();
+
+    bitboard_type pieces = getPieceMask(isWhite);
+    while (pieces)
+    {
+        int square = popLowestSquare(pieces);
+        bool isKing = (kings & getSquareMask(square)) != 0;
+
+        // men only jump forward, unless the rules let them jump backward too
+        int directionStride = (isKing || Rules::MEN_CAPTURE_BACKWARD) ? 1 : 2;
+        for (int i = 0; i < 4; i += directionStride)
+        {
+            int direction = DIRECTION_ORDER[isWhite][i];
+            int over = getStepSquare(square, direction);
+
+            // a flying king can jump a piece anywhere along the diagonal, past empty squares
+            if (Rules::FLYING_KINGS && isKing)
+            {
+                while (over != NO_SQUARE && (empty & getSquareMask(over)))
+                    over = getStepSquare(over, direction);
+            }
+
+            // (both masks are empty over the edge of the board, so this is false there)
+            if (over != NO_SQUARE && (opponentPieces & getSquareMask(over)) &&
+                (empty & getStepMask(over, direction)))
+                return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Adds the non-jumping moves of the piece on the given square to the list.
+ * @param square The square of the piece
+ * @param isWhite The color of the piece
+ * @param isKing Whether the piece is a king
+ * @param moves The list to add the moves to
+ */
+template <class Rules>
+void BasicBoard<Rules>::addSteps(int square, bool isWhite, bool isKing, move_list_type& moves) const
+{
+    bitboard_type empty = ~getOccupiedMask();
+
+    // men only move forward
+    int directionStride = isKing ? 1 : 2;
+    for (int i = 0; i < 4; i += directionStride)
+    {
+        int direction = DIRECTION_ORDER[isWhite][i];
+        int to = square;
+
+        // a flying king may stop on any empty square along the diagonal, other pieces just one step away
+        do
+        {
+            if (!(empty & getStepMask(to, direction)) || moves.full())
+                break;
+            to = getStepSquare(to, direction);
+            moves.push_back(move_type(square, to));
+        } while (Rules::FLYING_KINGS && isKing);
+    }
+}
+
+/**
+ * Recursively adds every jump (and every chain of jumps) available from a square.
+ * (EnglishRules only - every jump in a chain is its own move)
+ * @param square The square the jumping piece is on (or has landed on, partway through a chain)
+ * @param isWhite The color of the jumping piece
+ * @param isKing Whether the jumping piece is a king
+ * @param precedingJumps The move made of the jumps so far (with no jumps at first call)
+ * @param moves The list to add the jumps to
+ */
+template <>
+void BasicBoard<EnglishRules>::addJumps(int square, bool isWhite, bool isKing, const CompactMove& precedingJumps, MoveList& moves) const
+{
+    // as in Piece, jumped pieces stay on the board (and so block landings) until the move is over,
+    // and the jumping piece's starting square stays occupied
+    // only jump opponents, and never the same piece twice in one chain
+    bitboard_t jumpable = getPieceMask(!isWhite) & ~precedingJumps.getCaptureMask();
+    bitboard_t empty = ~getOccupiedMask();
+
+    // men only jump forward
+    int directionStride = isKing ? 1 : 2;
+    for (int i = 0; i < 4; i += directionStride)
+    {
+        // (both masks are empty over the edge of the board, so this fails there)
+        int direction = DIRECTION_ORDER[isWhite][i];
+        if (!(jumpable & getStepMask(square, direction)) || !(empty & getJumpLandingMask(square, direction)))
+            continue;
+
+        if (moves.full() || precedingJumps.getJumpCount() == CompactMove::MAX_JUMPS)
+            return;
+
+        // every jump is a move of its own, and may also be followed by more jumps
+        int landingSquare = getJumpLandingSquare(square, direction);
+        CompactMove jump = precedingJumps.withJump(direction, getStepSquare(square, direction), landingSquare);
+        moves.push_back(jump);
+        addJumps(landingSquare, isWhite, isKing, jump, moves);
+    }
+}
+
+/**
+ * Recursively follows every chain of captures from a square, adding the finished chains
+ * that capture the most pieces. (Majority capture rules only)
+ * @param square The square the jumping piece has reached
+ * @param isWhite The color of the jumping piece
+ * @param isKing Whether the jumping piece is a king
+ * @param chain The move made of the captures so far (with no captures at first call)
+ * @param empty The empty squares, counting the square the piece started on
+ * @param longest The most captures of any chain in the list so far (the list only holds chains this long)
+ * @param moves The list to add the chains to
+ */
+template <>
+void BasicBoard<InternationalRules>::addCaptureChains(int square, bool isWhite, bool isKing, const WideMove& chain,
+                                                      std::uint64_t empty, int& longest, move_list_type& moves) const
+{
+    // jumped pieces stay on the board (so they still block) until the chain is over,
+    // and may not be jumped twice
+    std::uint64_t jumpable = getPieceMask(!isWhite) & ~chain.getCaptureMask();
+    bool extended = false;
+
+    for (int direction = 0; direction < 4; direction++)
+    {
+        // a king may jump a piece anywhere along the diagonal, a man only the one next to it
+        int over = getStepSquare(square, direction);
+        if (isKing)
+        {
+            while (over != NO_SQUARE && (empty & getSquareMask(over)))
+                over = getStepSquare(over, direction);
+        }
+        if (over == NO_SQUARE || !(jumpable & getSquareMask(over)))
+            continue;
+
+        // and may then land on any empty square beyond it, where a man lands just past it
+        for (int landing = getStepSquare(over, direction);
+             landing != NO_SQUARE && (empty & getSquareMask(landing));
+             landing = getStepSquare(landing, direction))
+        {
+            extended = true;
+            addCaptureChains(landing, isWhite, isKing, chain.withCapture(over, landing), empty, longest, moves);
+            if (!isKing)
+                break;
+        }
+    }
+
+    // only finished chains are moves, and only the ones capturing the most pieces
+    if (extended || !chain.isJump() || chain.getJumpCount() < longest)
+        return;
+    if (chain.getJumpCount() > longest)
+    {
+        moves.clear();
+        longest = chain.getJumpCount();
+    }
+
+    // different paths (or landings) that end up capturing the same pieces are the same move
+    for (const WideMove& move : moves)
+    {
+        if (move == chain)
+            return;
+    }
+    if (!moves.full())
+        moves.push_back(chain);
+}
+
+/**
+ * Generates only the jumping moves for one side.
+ * (Under EnglishRules every jump in every chain; under majority capture the longest chains)
+ * @param isWhite The side to generate jumps for
+ * @param moves The list to add the jumps to
+ */
+template <class Rules>
+void BasicBoard<Rules>::getAllCaptures(bool isWhite, move_list_type& moves) const
+{
+    bitboard_type pieces = getPieceMask(isWhite);
+    int longest = 0;
+    while (pieces)
+    {
+        int square = popLowestSquare(pieces);
+        bool isKing = (kings & getSquareMask(square)) != 0;
+
+        if constexpr (Rules::MAJORITY_CAPTURE)
+        {
+            // the jumping piece has left its starting square, so a chain may pass over or end on it
+            bitboard_type empty = ~getOccupiedMask() | getSquareMask(square);
+            addCaptureChains(square, isWhite, isKing, move_type(square, square), empty, longest, moves);
+        }
+        else
+        {
+            addJumps(square, isWhite, isKing, move_type(square, square), moves);
+        }
+    }
+}
+
+/**
+ * Converts from x and y coordinates to a playable square number (see Bitboard.h)
+ * @param x The x coordinate
+ * @param y The y coordinate
+ * @return The square, from 0 to PLAYABLE_SQUARES - 1, or -1 if the coordinates are not a playable square.
+ */
+template <class Rules>
+int BasicBoard<Rules>::getSquareFromCoords(int x, int y)
+{
+    if (x < 0 || x >= SIZE || y < 0 || y >= SIZE || x % 2 != y % 2)
+        return -1;
+
+    // SIZE / 2 playable squares to a row, and x / 2 picks among them in either row parity
+    return y * (SIZE / 2) + x / 2;
+}
+
+/**
+ * Converts a playable square number (see Bitboard.h) to x and y coordinates.
+ * @param square The square, from 0 to PLAYABLE_SQUARES - 1
+ * @return A two part int array where [0] is the x coordinate and [1] is the y.
+ */
+template <class Rules>
+coords_t BasicBoard<Rules>::getCoordsFromSquare(int square)
+{
+    coords_t coords;
+    coords[1] = square / (SIZE / 2);
+    coords[0] = 2 * (square % (SIZE / 2)) + coords[1] % 2; // odd rows are shifted right by one
+    return coords;
+}
+
+// the only rule sets there are, so everything above is compiled here, once for each
+template class BasicBoard<EnglishRules>;
+template class BasicBoard<InternationalRules>;
@@ -0,0 +1,251 @@
+#ifndef BASIC_BOARD_H
+#define BASIC_BOARD_H
+
+#include "Typedefs.h"
+#include "Bitboard.h"
+#include "Rules.h"
+#include "MoveList.h"
+#include "SquareTables.h"
+
+/**
+ * What BasicBoard::makeMove remembers about a move, so that BasicBoard::unmakeMove can take it back.
+ */
+template <class Rules>
+struct BasicUndoRecord
+{
+	// the squares of the pieces the move captured
+	typename Rules::bitboard_type captured;
+	// which of those pieces were kings
+	typename Rules::bitboard_type capturedKings;
+	// whether the move crowned the piece that moved
+	bool promoted;
+	// the Zobrist key of the board before the move
+	hashkey_t previousHash;
+};
+
+/**
+ * The state of a game under one of the rule sets in Rules.h, held entirely as bitboards:
+ * which squares hold white pieces, black pieces and kings, whose turn it is, and the
+ * Zobrist key of all that (see Zobrist.h).
+ *
+ * The size of the board, the rules and the geometry tables are all fixed when compiling, and
+ * the move generator is specialized for each rule set, so neither variant pays for the other:
+ * BasicBoard<EnglishRules> generates exactly the moves the 8x8 Board always has, and
+ * BasicBoard<InternationalRules> adds flying kings and majority capture on 10x10.
+ *
+ * This is cheap to copy, and makeMove/unmakeMove allocate nothing, so it is what lookahead
+ * should use. (Board is the 8x8 board with Piece objects kept alongside for the game and its UI)
+ */
+template <class Rules>
+class BasicBoard
+{
+    public:
+    	typedef typename Rules::bitboard_type bitboard_type;
+    	typedef typename Rules::move_type move_type;
+    	typedef BasicMoveList<move_type> move_list_type;
+    	typedef BasicUndoRecord<Rules> undo_type;
+
+    	const static int SIZE = Rules::SIZE;
+    	const static int PLAYABLE_SQUARES = Rules::PLAYABLE_SQUARES;
+
+		/**
+		 * Responsible for generating a brand new board, with each side's men on its first rows
+		 * (white at the top, to move first).
+		 */
+		BasicBoard();
+
+		/**
+		 * Responsible for generating a board holding the given position.
+		 * (Pieces may be on any playable square, so this can set up positions that never come up in a game)
+		 * @param whitePieces The bitboard of the white pieces (kings included)
+		 * @param blackPieces The bitboard of the black pieces (kings included)
+		 * @param kings The bitboard of the kings of both colors
+		 * @param whiteToMove Whether it is white's turn to move
+		 */
+		BasicBoard(bitboard_type whitePieces, bitboard_type blackPieces, bitboard_type kings, bool whiteToMove);
+
+		/**
+		 * Applies the given move to this board in a way that can be taken back with unmakeMove.
+		 * @param move The move to execute, which should be one generated for this board.
+		 * @return Returns the record unmakeMove needs to take the move back.
+		 */
+		undo_type makeMove(const move_type& move);
+
+		/**
+		 * Takes back a move made with makeMove, putting the board back the way it was before it.
+		 * Moves must be taken back in the reverse of the order they were made in.
+		 * @param move The move to take back, which must be the last one made on this board.
+		 * @param undo The record makeMove returned for that move.
+		 */
+		void unmakeMove(const move_type& move, const undo_type& undo);
+
+		/**
+		 * Generates every legal move for one side in a single pass over its pieces.
+		 * Captures are mandatory, so if any jump is available only the jumps are returned
+		 * (and under majority capture, only the chains taking the most pieces).
+		 * @param isWhite The side to generate moves for
+		 * @param moves The list to add the moves to
+		 */
+		void getAllLegalMoves(bool isWhite, move_list_type& moves) const;
+
+		/**
+		 * Generates only the jumping moves for one side.
+		 * (Under EnglishRules every jump in every chain; under majority capture the longest chains)
+		 * @param isWhite The side to generate jumps for
+		 * @param moves The list to add the jumps to
+		 */
+		void getAllCaptures(bool isWhite, move_list_type& moves) const;
+
+		/**
+		 * @return Returns true if any piece of the given side can jump.
+		 * (Only checks single jumps, so it is much cheaper than generating the moves)
+		 * @param isWhite The side to check
+		 */
+		bool hasAnyCapture(bool isWhite) const;
+
+		/**
+		 * @return Returns the bitboard of all pieces (kings included) of the given color.
+		 * @param isWhite The color of the pieces
+		 */
+		bitboard_type getPieceMask(bool isWhite) const { return isWhite ? whitePieces : blackPieces; }
+
+		/**
+		 * @return Returns the bitboard of all kings of the given color.
+		 * @param isWhite The color of the kings
+		 */
+		bitboard_type getKingMask(bool isWhite) const { return getPieceMask(isWhite) & kings; }
+
+		/**
+		 * @return Returns the bitboard of every occupied square.
+		 */
+		bitboard_type getOccupiedMask() const { return whitePieces | blackPieces; }
+
+		/**
+		 * @return Returns the number of pieces (kings included) of the given color.
+		 * @param isWhite The color of the pieces
+		 */
+		int getPieceCount(bool isWhite) const { return popCount(getPieceMask(isWhite)); }
+
+		/**
+		 * @return Returns the number of kings of the given color.
+		 * @param isWhite The color of the kings
+		 */
+		int getKingCount(bool isWhite) const { return popCount(getKingMask(isWhite)); }
+
+		/**
+		 * @return Returns true if it is white's turn to move. (White moves first, and every move
+		 * applied to the board passes the turn to the other side)
+		 */
+		bool isWhiteToMove() const { return whiteToMove; }
+
+		/**
+		 * @return Returns the 64-bit Zobrist key of this position (its pieces and the side to move).
+		 * The key is updated as moves are made, so this costs nothing.
+		 */
+		hashkey_t getHash() const { return hash; }
+
+		/**
+		 * Works out the Zobrist key of this position from scratch. (getHash() returns the same key,
+		 * kept up to date move by move, so this is only needed to set it up or to check it)
+		 * @return Returns the key of every piece on the board and the side to move.
+		 */
+		hashkey_t computeHash() const;
+
+		/**
+		 * @return Returns a bitboard with only the given square set.
+		 * @param square The square, from 0 to PLAYABLE_SQUARES - 1
+		 */
+		static bitboard_type getSquareMask(int square) { return (bitboard_type)1 << square; }
+
+		/**
+		 * Converts from x and y coordinates to a playable square number (see Bitboard.h)
+		 * @param x The x coordinate
+		 * @param y The y coordinate
+		 * @return The square, from 0 to PLAYABLE_SQUARES - 1, or -1 if the coordinates are not a playable square.
+		 */
+		static int getSquareFromCoords(int x, int y);
+
+		/**
+		 * Converts a playable square number (see Bitboard.h) to x and y coordinates.
+		 * @param square The square, from 0 to PLAYABLE_SQUARES - 1
+		 * @return A two part int array where [0] is the x coordinate and [1] is the y.
+		 */
+		static coords_t getCoordsFromSquare(int square);
+
+	protected:
+		// the authoritative board state, one bit per playable square
+		bitboard_type whitePieces;
+		bitboard_type blackPieces;
+		bitboard_type kings;
+		bool whiteToMove;
+
+		// the Zobrist key of the state above (see Zobrist.h)
+		hashkey_t hash;
+
+		/**
+		 * Moves the piece on one square to another, removing the captured pieces, crowning it if
+		 * the move ends on the far row, and passing the turn.
+		 * @param fromSquare The square of the piece to move
+		 * @param toSquare The square it moves to
+		 * @param captured The bitboard of the pieces to remove
+		 * @return Returns the record needed to take the move back.
+		 */
+		undo_type moveSquares(int fromSquare, int toSquare, bitboard_type captured);
+
+		/**
+		 * Takes back a move made with moveSquares.
+		 * @param fromSquare The square the piece started on
+		 * @param toSquare The square it moved to
+		 * @param undo The record moveSquares returned
+		 */
+		void unmoveSquares(int fromSquare, int toSquare, const undo_type& undo);
+
+	private:
+		// the geometry tables for this size of board (see SquareTables.h)
+		static int getStepSquare(int square, int direction) { return BOARD_TABLES<SIZE, bitboard_type>.step[square][direction]; }
+		static int getJumpLandingSquare(int square, int direction) { return BOARD_TABLES<SIZE, bitboard_type>.jumpLanding[square][direction]; }
+		static bitboard_type getStepMask(int square, int direction) { return BOARD_TABLES<SIZE, bitboard_type>.stepMask[square][direction]; }
+		static bitboard_type getJumpLandingMask(int square, int direction) { return BOARD_TABLES<SIZE, bitboard_type>.jumpLandingMask[square][direction]; }
+
+		/**
+		 * @return Returns the bitboard of the row a man of the given color is crowned on.
+		 * @param isWhite The color of the man
+		 */
+		static bitboard_type getCrowningRow(bool isWhite);
+
+		/**
+		 * Adds the non-jumping moves of the piece on the given square to the list.
+		 * @param square The square of the piece
+		 * @param isWhite The color of the piece
+		 * @param isKing Whether the piece is a king
+		 * @param moves The list to add the moves to
+		 */
+		void addSteps(int square, bool isWhite, bool isKing, move_list_type& moves) const;
+
+		/**
+		 * Recursively adds every jump (and every chain of jumps) available from a square.
+		 * (EnglishRules only - every jump in a chain is its own move)
+		 * @param square The square the jumping piece is on (or has landed on, partway through a chain)
+		 * @param isWhite The color of the jumping piece
+		 * @param isKing Whether the jumping piece is a king
+		 * @param precedingJumps The move made of the jumps so far (with no jumps at first call)
+		 * @param moves The list to add the jumps to
+		 */
+		void addJumps(int square, bool isWhite, bool isKing, const move_type& precedingJumps, move_list_type& moves) const;
+
+		/**
+		 * Recursively follows every chain of captures from a square, adding the finished chains
+		 * that capture the most pieces. (Majority capture rules only)
+		 * @param square The square the jumping piece has reached
+		 * @param isWhite The color of the jumping piece
+		 * @param isKing Whether the jumping piece is a king
+		 * @param chain The move made of the captures so far (with no captures at first call)
+		 * @param empty The empty squares, counting the square the piece started on
+		 * @param longest The most captures of any chain in the list so far (the list only holds chains this long)
+		 * @param moves The list to add the chains to
+		 */
+		void addCaptureChains(int square, bool isWhite, bool isKing, const move_type& chain,
+		                      bitboard_type empty, int& longest, move_list_type& moves) const;
+};
+
+#endif
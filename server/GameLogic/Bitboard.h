@@ -0,0 +1,116 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "Typedefs.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * Helpers for working with bitboards over the 32 playable squares.
+ *
+ * Only the "black" checkerboard spaces (where x % 2 == y % 2) can ever hold a piece,
+ * so they are numbered 0 to 31 from the top left, four to a row:
+ *
+ *     square = y * 4 + x / 2
+ *
+ * and bit n of a bitboard_t represents square n.
+ *
+ * Boards of other sizes (see Rules.h) number their squares the same way, SIZE / 2 to a row,
+ * and the helpers below also take the 64-bit bitboards those need.
+ */
+
+const int PLAYABLE_SQUARES = 32;
+
+/**
+ * @return Returns the number of set bits (pieces) in the given bitboard.
+ * @param bits The bitboard to count
+ */
+inline int popCount(bitboard_t bits)
+{
+#if defined(_MSC_VER)
+    return (int)__popcnt(bits);
+#else
+    return __builtin_popcount(bits);
+#endif
+}
+
+/**
+ * @return Returns the number of set bits (pieces) in the given 64-bit bitboard.
+ * @param bits The bitboard to count
+ */
+inline int popCount(std::uint64_t bits)
+{
+#if defined(_MSC_VER)
+    return (int)__popcnt64(bits);
+#else
+    return __builtin_popcountll(bits);
+#endif
+}
+
+/**
+ * @return Returns the index of the lowest set bit (square) of the given bitboard.
+ * @param bits The bitboard to search, which must not be empty
+ */
+inline int lowestSquare(bitboard_t bits)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return (int)index;
+#else
+    return __builtin_ctz(bits);
+#endif
+}
+
+/**
+ * @return Returns the index of the lowest set bit (square) of the given 64-bit bitboard.
+ * @param bits The bitboard to search, which must not be empty
+ */
+inline int lowestSquare(std::uint64_t bits)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+/**
+ * Removes the lowest set bit of the given bitboard and returns its square.
+ * Used to iterate over pieces: while (bits) { int sq = popLowestSquare(bits); ... }
+ * @param bits The bitboard to modify, which must not be empty
+ * @return Returns the square that was removed.
+ */
+inline int popLowestSquare(bitboard_t& bits)
+{
+    int square = lowestSquare(bits);
+    bits &= bits - 1;
+    return square;
+}
+
+/**
+ * Removes the lowest set bit of the given 64-bit bitboard and returns its square.
+ * @param bits The bitboard to modify, which must not be empty
+ * @return Returns the square that was removed.
+ */
+inline int popLowestSquare(std::uint64_t& bits)
+{
+    int square = lowestSquare(bits);
+    bits &= bits - 1;
+    return square;
+}
+
+/**
+ * @return Returns a bitboard with only the given square set.
+ * @param square The square, from 0 to 31
+ */
+inline bitboard_t squareMask(int square)
+{
+    return (bitboard_t)1 << square;
+}
+
+#endif
@@ -2,77 +2,64 @@
 
 #include "Piece.h"
 #include "Move.h"
+#include "CompactMove.h"
+#include "MoveList.h"
 #include "Typedefs.h"
-#include <iostream>
+#include "Trace.h"
+#include <cassert>
 
 /**
  * Responsible for generating a brand new board
  * Fills the board with pieces in their starting positions.
  * Adds WHITE pieces at the top to start (so white should move first)
  */
-
-/**
- * Responsible for generating a brand new board
- * Fills the board with pieces in their starting positions.
- * Adds WHITE pieces at the top to start (so white should move first)
- */
-Board::Board()
+Board::Board() : capturedCount(0)
 {
-    // In this constructor, we dynamically allocate the pieces becasue
-    // we want to use pointers here (we want to move the references to a
-    // unique piece around the board array, instead of copying full objects
-    // around), but that means we must delete that memory later to avoid
-    // memory leaks. (See the deconstructor below)
-
-    for (int y = 0; y < SIZE; y++)
-    {
-        for (int x = 0; x < SIZE; x++)
-        {
-            // add white pieces to the top (in a checkerboard pattern of black spaces - not on white spaces)
-            if (y < 3 && isCheckerboardSpace(x, y))
-            {
-                setValueAt(x, y, new Piece(x, y, true));
-                std::cout << "Added white piece at (" << x << "," << y << ")" << std::endl;
-            }
-            // ... and black pieces to the bottom in the opposite pattern
-            else if (y >= SIZE - 3 && isCheckerboardSpace(x, y))
-            {
-                setValueAt(x, y, new Piece(x, y, false));
-                std::cout << "Added black piece at (" << x << "," << y << ")" << std::endl;
-            }
-            // AND ensure that all non-occupied spaces are null (we don't have
-            // a default constructor for Pieces, so the normal initilizations are weird here)
-            else
-            {
-                setValueAt(x, y, nullptr);
-            }
-        }
-    }
+    // BasicBoard sets up the bitboards, and the pieces are made to match them
+    createPieces();
 }
 
 /**
- * Responsible for generating a board based on another board
+ * Responsible for generating a board holding the given position.
+ * (Pieces may be on any playable square, so this can set up positions that never come up in a game)
+ * @param whitePieces The bitboard of the white pieces (kings included)
+ * @param blackPieces The bitboard of the black pieces (kings included)
+ * @param kings The bitboard of the kings of both colors
+ * @param whiteToMove Whether it is white's turn to move
  */
-Board::Board(const Board& board)
+Board::Board(bitboard_t whitePieces, bitboard_t blackPieces, bitboard_t kings, bool whiteToMove)
+    : BasicBoard(whitePieces, blackPieces, kings, whiteToMove), capturedCount(0)
 {
-	for (int pos = 0; pos < SIZE*SIZE; pos++)
-    {
-		setValueAt(pos, board.getValueAt(pos));  
-    }
+    createPieces();
 }
 
 /**
- * Responsible for deconstrucing the board (deleting Pieces) when done.
+ * Fills the Piece view with pieces matching the bitboards.
  */
-Board::~Board()
+void Board::createPieces()
 {
-	for (int pos = 0; pos < SIZE*SIZE; pos++)
+    // The pieces are kept in an array inside the board, rather than each
+    // allocated on its own, so that a board (pieces and all) is one object
+    // that is cheap to make and to copy. Pointers into the array are still
+    // handed out, and the squares only move indices to pieces around.
+    int pieceCount = 0;
+    for (int square = 0; square < PLAYABLE_SQUARES; square++)
     {
-    	delete getValueAt(pos);
-		setValueAt(pos, nullptr);  
+        squarePiece[square] = NO_PIECE;
+        if (!(getOccupiedMask() & squareMask(square)))
+            continue;
+
+        coords_t coords = getCoordsFromSquare(square);
+        bool isWhite = (whitePieces & squareMask(square)) != 0;
+        Piece& piece = pieces[pieceCount];
+        piece = Piece(coords[0], coords[1], isWhite);
+        if (kings & squareMask(square))
+            piece.setKing();
+        squarePiece[square] = (signed char)pieceCount++;
+        TRACE_DEBUG("Added " << (isWhite ? "white" : "black") << " piece at (" << coords[0] << "," << coords[1] << ")");
     }
 }
-    
+
 /**
  * Using the given move and piece, move the piece on the board and apply it to this board.
  * @param move The Move object to execute on the piece and board.
@@ -85,35 +72,132 @@ void Board::applyMoveToBoard(const move_ptr_t move, Piece* piece)
     // and therefore can only think back one jump. WE ARE PRESUMING that the piece given to this function
     // is the one which the move SHOULD be applied to, but due to this issue we can't test this.
     
-    coords_t moveStartingPos = piece->getCoordinates();
     coords_t moveEndingPos = move->getEndingPosition();
     
-    // find any pieces we've jumped in the process, and remove them as well
+    // find any pieces we've jumped in the process, so they can be removed as well
+    bitboard_t captured = 0;
     std::vector<Piece*> jumpedPieces = move->getJumpedPieces(*this);
-    if (!jumpedPieces.empty())
+    for (unsigned int i = 0; i < jumpedPieces.size(); i++)
     {
-        // loop over all jumped pieces and remove them
-        for (unsigned int i = 0; i < jumpedPieces.size(); i++)
+        if (jumpedPieces[i] != nullptr)
         {
-            if (jumpedPieces[i] != nullptr)
-            {
-                setValueAt(jumpedPieces[i]->getCoordinates()[0], 
-                			jumpedPieces[i]->getCoordinates()[1], nullptr);
-            }
+            coords_t jumpedPos = jumpedPieces[i]->getCoordinates();
+            captured |= squareMask(getSquareFromCoords(jumpedPos[0], jumpedPos[1]));
         }
     }
+    
+    movePiece(piece, getSquareFromCoords(moveEndingPos[0], moveEndingPos[1]), captured);
+}
+
+/**
+ * Applies the given move to this board, moving the piece on its starting square.
+ * (The captured pieces come straight from the move, so this does no searching)
+ * @param move The move to execute, which should be one generated for this board.
+ */
+void Board::applyMove(const CompactMove& move)
+{
+    makeMove(move);
+}
+
+/**
+ * Applies the given move to this board in a way that can be taken back with unmakeMove.
+ * Nothing is allocated or deleted: captured pieces are kept aside until the move is taken back.
+ * @param move The move to execute, which should be one generated for this board.
+ * @return Returns the record unmakeMove needs to take the move back.
+ */
+UndoRecord Board::makeMove(const CompactMove& move)
+{
+    coords_t start = getCoordsFromSquare(move.getFrom());
+    return movePiece(getValueAt(start[0], start[1]), move.getTo(), move.getCaptureMask());
+}
+
+/**
+ * Takes back a move made with makeMove, putting the board back the way it was before it.
+ * Moves must be taken back in the reverse of the order they were made in.
+ * @param move The move to take back, which must be the last one made on this board.
+ * @param undo The record makeMove returned for that move.
+ */
+void Board::unmakeMove(const CompactMove& move, const UndoRecord& undo)
+{
+    coords_t moveStartingPos = getCoordsFromSquare(move.getFrom());
+    coords_t moveEndingPos = getCoordsFromSquare(move.getTo());
+    Piece* piece = getValueAt(moveEndingPos[0], moveEndingPos[1]);
+    
+    unmoveSquares(move.getFrom(), move.getTo(), undo);
+    
+    // move the piece back to where it started, as a man again if this move crowned it
+    setValueAt(moveEndingPos[0], moveEndingPos[1], nullptr);
+    if (undo.promoted)
+        piece->isKing = false;
+    piece->moveTo(moveStartingPos[0], moveStartingPos[1]);
+    setValueAt(moveStartingPos[0], moveStartingPos[1], piece);
+    
+    // then put the captured pieces back, which were set aside in the same (square) order we walk them in
+    bitboard_t captured = undo.captured;
+    capturedCount -= popCount(captured);
+    int next = capturedCount;
+    while (captured)
+    {
+        coords_t jumpedPos = getCoordsFromSquare(popLowestSquare(captured));
+        setValueAt(jumpedPos[0], jumpedPos[1], &pieces[capturedPieces[next++]]);
+    }
+}
+
+/**
+ * Moves the given piece to a new square, removing the captured pieces and crowning it if it
+ * reached the end of the board. (Keeps both the bitboards and the Piece view up to date)
+ * @param piece The piece to move
+ * @param toSquare The square it moves to
+ * @param captured The bitboard of the pieces to remove
+ * @return Returns the record needed to take the move back.
+ */
+UndoRecord Board::movePiece(Piece* piece, int toSquare, bitboard_t captured)
+{
+    coords_t moveStartingPos = piece->getCoordinates();
+    coords_t moveEndingPos = getCoordsFromSquare(toSquare);
+    
+    // the bitboards (and the key) change first, and decide whether the piece is crowned
+    UndoRecord undo = moveSquares(getSquareFromCoords(moveStartingPos[0], moveStartingPos[1]), toSquare, captured);
+    
+    // remove any pieces we've jumped in the process (setting them aside, in square order, so they can be put back)
+    while (captured)
+    {
+        coords_t jumpedPos = getCoordsFromSquare(popLowestSquare(captured));
+        assert(capturedCount < PLAYABLE_SQUARES);
+        capturedPieces[capturedCount++] = squarePiece[getSquareFromCoords(jumpedPos[0], jumpedPos[1])];
+        setValueAt(jumpedPos[0], jumpedPos[1], nullptr);
+    }
         
     // and, move this piece (WE PRESUME that it's this piece) from its old spot (both on board and with the piece itself)
     setValueAt(moveStartingPos[0], moveStartingPos[1], nullptr);
     piece->moveTo(moveEndingPos[0], moveEndingPos[1]);
-    
-    // do a favor to the piece and check if it should now be a king (it'll change itself)
-    piece->checkIfShouldBeKing(*this);
+    if (undo.promoted)
+        piece->setKing();
     
     // finally, set the move's destination to the piece we're moving
     setValueAt(moveEndingPos[0], moveEndingPos[1], piece);
+    
+    return undo;
 }
     
+/**
+ * Sets the space at these coordinates to the given Piece object.
+ * @param x The x position of the Piece
+ * @param y The y position of the Piece
+ * @param piece The Piece to put in this space (one of this board's own), but can be null to make the space empty
+ */
+void Board::setValueAt(int x, int y, Piece* piece)
+{
+    // only the playable squares can ever hold a piece
+    int square = getSquareFromCoords(x, y);
+    if (square < 0)
+    {
+        assert(piece == nullptr);
+        return;
+    }
+    squarePiece[square] = piece == nullptr ? NO_PIECE : (signed char)(piece - pieces);
+}
+
 /**
  * Sets the space at this number position to the given Piece object.
  * @param position The number position, zero indexed at top left.
@@ -197,3 +281,16 @@ bool Board::isOverEdge(int position) const
     coords_t coords = getCoordsFromPos(position); // convert position to coordinates and use that
     return isOverEdge(coords[0], coords[1]); 
 }
+
+/**
+ * @return Returns true if there is a piece at these coordinates. (doesn't error check)
+ * @param x The x position
+ * @param y The y position
+ */
+bool Board::isOccupied(int x, int y) const
+{
+    int square = getSquareFromCoords(x, y);
+    
+    // only the playable squares can ever hold a piece
+    return square >= 0 && (getOccupiedMask() & squareMask(square)) != 0;
+}
@@ -3,17 +3,34 @@
 
 #include <array>
 #include "Typedefs.h"
+#include "Bitboard.h"
+#include "BasicBoard.h"
+#include "Piece.h"
 
-class Piece;
 class Move;
+
+/**
+ * What Board::makeMove remembers about a move, so that Board::unmakeMove can take it back.
+ */
+typedef BasicUndoRecord<EnglishRules> UndoRecord;
 	
 /**
  * Stores and handles interaction with the game board.
  * 
+ * The authoritative state is a set of bitboards over the 32 playable squares
+ * (see Bitboard.h), so counting and occupancy tests are single mask operations.
+ * Those, and the move generator, come from BasicBoard<EnglishRules> (see BasicBoard.h).
+ * Piece objects are still kept on the board as a read-only view for the callers
+ * that want to look at a square, such as getValueAt(x, y).
+ * 
+ * The pieces live by value in an array inside the board, with each playable square
+ * holding the index of its piece, so a board is one contiguous object: making or
+ * copying one never touches the allocator, and a copy is a plain memberwise copy.
+ * 
  * @author Mckenna Cisler
  * @version 5.23.2016
  */
-class Board
+class Board : public BasicBoard<EnglishRules>
 {
     public:
     	// this MUST be constant in order to allocate the required 2D array
@@ -26,15 +43,27 @@ class Board
 		 */
 		Board();
 
+		/**
+		 * Responsible for generating a board holding the given position.
+		 * (Pieces may be on any playable square, so this can set up positions that never come up in a game)
+		 * @param whitePieces The bitboard of the white pieces (kings included)
+		 * @param blackPieces The bitboard of the black pieces (kings included)
+		 * @param kings The bitboard of the kings of both colors
+		 * @param whiteToMove Whether it is white's turn to move
+		 */
+		Board(bitboard_t whitePieces, bitboard_t blackPieces, bitboard_t kings, bool whiteToMove);
+
 		/**
 		 * Responsible for generating a board based on another board
+		 * (The copy gets pieces of its own, so the two boards can be changed independently,
+		 * and it can take back the same moves the original could)
 		 */
-		Board(const Board& board);
-		
+		Board(const Board& board) = default;
+
 		/**
-		 * Responsible for deconstrucing the board (deleting Pieces) when done.
+		 * Makes this board a copy of another board. (See the copy constructor)
 		 */
-		~Board();
+		Board& operator=(const Board& board) = default;
    
 		/**
 		 * Using the given move and piece, move the piece on the board and apply it to this board.
@@ -42,14 +71,48 @@ class Board
 		 * @param piece The Piece object that will be moved.
 		 */
 		void applyMoveToBoard(const move_ptr_t move, Piece* piece);
-    
+
+		/**
+		 * Applies the given move to this board, moving the piece on its starting square.
+		 * (The captured pieces come straight from the move, so this does no searching)
+		 * @param move The move to execute, which should be one generated for this board.
+		 */
+		void applyMove(const CompactMove& move);
+
+		/**
+		 * Applies the given move to this board in a way that can be taken back with unmakeMove.
+		 * Nothing is allocated or deleted: captured pieces are kept aside until the move is taken back.
+		 * @param move The move to execute, which should be one generated for this board.
+		 * @return Returns the record unmakeMove needs to take the move back.
+		 */
+		UndoRecord makeMove(const CompactMove& move);
+
+		/**
+		 * Takes back a move made with makeMove, putting the board back the way it was before it.
+		 * Moves must be taken back in the reverse of the order they were made in.
+		 * @param move The move to take back, which must be the last one made on this board.
+		 * @param undo The record makeMove returned for that move.
+		 */
+		void unmakeMove(const CompactMove& move, const UndoRecord& undo);
+
     	/**
 		 * Get's the Piece object at this location. (doesn't error check)
 		 * @param x The x position of the Piece
 		 * @param y The y position of the Piece
 		 * @return The Piece here. (May be null)
 		 */
-		Piece* getValueAt(int x, int y) const { return this->boardArray[y][x]; }
+		Piece* getValueAt(int x, int y) const
+		{
+			int square = getSquareFromCoords(x, y);
+			return square < 0 || squarePiece[square] == NO_PIECE ? nullptr : &pieces[squarePiece[square]];
+		}
+
+		/**
+		 * @return Returns true if there is a piece at these coordinates. (doesn't error check)
+		 * @param x The x position
+		 * @param y The y position
+		 */
+		bool isOccupied(int x, int y) const;
     
 		/**
 		 * Get's the Piece object at this location, but using a single number,
@@ -90,7 +153,21 @@ class Board
 		bool isOverEdge(int position) const;
 		
 	private:
-    	Piece* boardArray[SIZE][SIZE];
+		// the index of an empty square in squarePiece
+		const static signed char NO_PIECE = -1;
+
+		// the Piece view of the same state, kept in sync with the bitboards: the pieces themselves
+		// (one for each playable square at most, since a set up position may fill them all), and the
+		// index of the piece on each playable square
+		// (mutable because callers are handed the pieces of a const board, as they always were)
+		mutable Piece pieces[PLAYABLE_SQUARES];
+		signed char squarePiece[PLAYABLE_SQUARES];
+
+		// the indices of the pieces captured by moves that can still be taken back, in the order they
+		// were captured (they stay in the array, and are put back on unmakeMove); no more pieces can be
+		// captured than a set up position holds, and that is one for each playable square at most
+		signed char capturedPieces[PLAYABLE_SQUARES];
+		int capturedCount;
 	
 		/**
 		 * Sets the space at these coordinates to the given Piece object.
@@ -98,8 +175,7 @@ class Board
 		 * @param y The y position of the Piece
 		 * @param piece The Piece to put in this space, but can be null to make the space empty
 		 */
-		void setValueAt(int x, int y, Piece* piece) 
-		{ this->boardArray[y][x] = piece; }
+		void setValueAt(int x, int y, Piece* piece);
 		
 		/**
 		 * Sets the space at this number position to the given Piece object.
@@ -107,7 +183,22 @@ class Board
 		 * @param piece The Piece to put in this space, but can be null to make the space empty
 		 */
 		void setValueAt(int position, Piece* piece);
-		
+
+		/**
+		 * Moves the given piece to a new square, removing the captured pieces and crowning it if it
+		 * reached the end of the board. (Keeps both the bitboards and the Piece view up to date)
+		 * @param piece The piece to move
+		 * @param toSquare The square it moves to
+		 * @param captured The bitboard of the pieces to remove
+		 * @return Returns the record needed to take the move back.
+		 */
+		UndoRecord movePiece(Piece* piece, int toSquare, bitboard_t captured);
+
+		/**
+		 * Fills the Piece view with pieces matching the bitboards.
+		 */
+		void createPieces();
+
 		/**
 		 * Converts a single position value to x and y coordinates.
 		 * @param position The single position value, zero indexed at top left.
@@ -0,0 +1,67 @@
+#include "CompactMove.h"
+
+#include "Bitboard.h"
+#include "SquareTables.h"
+#include "Typedefs.h"
+
+#include <cassert>
+
+/**
+ * @return Returns a copy of this move extended by one more jump.
+ * (This move must have fewer than MAX_JUMPS jumps)
+ * @param direction The direction of the jump, from 0 to 3
+ * @param capturedSquare The square of the piece being jumped
+ * @param landingSquare The square the jump lands on
+ */
+CompactMove CompactMove::withJump(int direction, int capturedSquare, int landingSquare) const
+{
+    int jumps = getJumpCount();
+    assert(jumps < MAX_JUMPS);
+
+    CompactMove move;
+    move.captures = captures | squareMask(capturedSquare);
+
+    // keep the starting square and the path so far, then replace the ending square and count
+    move.info = (info & ~((SQUARE_MASK << TO_SHIFT) | (COUNT_MASK << COUNT_SHIFT)))
+                | ((std::uint32_t)landingSquare << TO_SHIFT)
+                | ((std::uint32_t)(jumps + 1) << COUNT_SHIFT)
+                | ((std::uint32_t)direction << (PATH_SHIFT + 2 * jumps));
+    return move;
+}
+
+/**
+ * @return Returns the squares this move lands on, in order, ending with getTo().
+ * (A non-jumping move lands once, on getTo())
+ * @param landings An array with room for MAX_JUMPS squares to fill
+ * @return The number of squares filled in.
+ */
+int CompactMove::getLandingSquares(int landings[MAX_JUMPS]) const
+{
+    int jumps = getJumpCount();
+    if (jumps == 0)
+    {
+        landings[0] = getTo();
+        return 1;
+    }
+
+    // follow the path from the starting square, one jump at a time
+    int square = getFrom();
+    for (int i = 0; i < jumps; i++)
+    {
+        square = getJumpLandingSquare(square, getJumpDirection(i));
+        landings[i] = square;
+    }
+    return jumps;
+}
+
+/**
+ * @return Returns the move stored in a number made by toBits()
+ * @param bits The number to read
+ */
+CompactMove CompactMove::fromBits(std::uint64_t bits)
+{
+    CompactMove move;
+    move.captures = (bitboard_t)(bits & 0xffffffffu);
+    move.info = (std::uint32_t)(bits >> 32);
+    return move;
+}
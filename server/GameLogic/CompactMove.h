@@ -0,0 +1,116 @@
+#ifndef COMPACT_MOVE_H
+#define COMPACT_MOVE_H
+
+#include <cstdint>
+#include <type_traits>
+#include "Typedefs.h"
+
+/**
+ * A complete move of a piece packed into eight bytes, so it can be copied freely
+ * and stored in flat arrays (move lists, search tables, game history, network frames).
+ *
+ * Unlike a Move, which only knows its last jump and reaches the earlier ones through
+ * a chain of pointers, a CompactMove holds the whole move: its starting and ending
+ * squares, the direction of every jump along the way, and a bitboard of every square
+ * it captures (computed once, when the move is generated).
+ *
+ * Squares are the playable square numbers described in Bitboard.h.
+ * Jump directions are numbered 0 to 3, where bit 0 set means +x and bit 1 set means +y.
+ */
+class CompactMove
+{
+	public:
+		// the most jumps a single move can hold (the path has room for this many directions)
+		const static int MAX_JUMPS = 9;
+
+		// left uninitialized, so arrays of moves cost nothing to create
+		CompactMove() = default;
+
+		/**
+		 * Constructor for a non-jumping move (or the start of a jumping one)
+		 * @param from The starting square
+		 * @param to The ending square
+		 */
+		CompactMove(int from, int to) :
+			captures(0), info((std::uint32_t)from | ((std::uint32_t)to << TO_SHIFT))
+			{};
+
+		/**
+		 * @return Returns a copy of this move extended by one more jump.
+		 * (This move must have fewer than MAX_JUMPS jumps)
+		 * @param direction The direction of the jump, from 0 to 3
+		 * @param capturedSquare The square of the piece being jumped
+		 * @param landingSquare The square the jump lands on
+		 */
+		CompactMove withJump(int direction, int capturedSquare, int landingSquare) const;
+
+		/**
+		 * @return Returns the starting square of this move.
+		 */
+		int getFrom() const { return (int)(info & SQUARE_MASK); }
+
+		/**
+		 * @return Returns the ending square of this move.
+		 */
+		int getTo() const { return (int)((info >> TO_SHIFT) & SQUARE_MASK); }
+
+		/**
+		 * @return Returns the number of jumps in this move (0 if it is not a jump).
+		 */
+		int getJumpCount() const { return (int)((info >> COUNT_SHIFT) & COUNT_MASK); }
+
+		/**
+		 * @return Returns true if this move jumps (and so captures) any pieces.
+		 */
+		bool isJump() const { return captures != 0; }
+
+		/**
+		 * @return Returns a bitboard of the squares of every piece captured by this move.
+		 */
+		bitboard_t getCaptureMask() const { return captures; }
+
+		/**
+		 * @return Returns the direction (0 to 3) of one of the jumps in this move.
+		 * @param jump The jump, from 0 to getJumpCount() - 1
+		 */
+		int getJumpDirection(int jump) const { return (int)((info >> (PATH_SHIFT + 2 * jump)) & 3); }
+
+		/**
+		 * @return Returns the squares this move lands on, in order, ending with getTo().
+		 * (A non-jumping move lands once, on getTo())
+		 * @param landings An array with room for MAX_JUMPS squares to fill
+		 * @return The number of squares filled in.
+		 */
+		int getLandingSquares(int landings[MAX_JUMPS]) const;
+
+		/**
+		 * @return Returns the whole move as a single number, for storing or sending it.
+		 */
+		std::uint64_t toBits() const { return ((std::uint64_t)info << 32) | captures; }
+
+		/**
+		 * @return Returns the move stored in a number made by toBits()
+		 * @param bits The number to read
+		 */
+		static CompactMove fromBits(std::uint64_t bits);
+
+		bool operator==(const CompactMove& other) const
+		{ return captures == other.captures && info == other.info; }
+		bool operator!=(const CompactMove& other) const { return !(*this == other); }
+
+	private:
+		// info holds: from (5 bits) | to (5 bits) | jump count (4 bits) | 2 bits of direction per jump
+		const static int TO_SHIFT = 5;
+		const static int COUNT_SHIFT = 10;
+		const static int PATH_SHIFT = 14;
+		const static std::uint32_t SQUARE_MASK = 0x1f;
+		const static std::uint32_t COUNT_MASK = 0xf;
+
+		bitboard_t captures;
+		std::uint32_t info;
+};
+
+static_assert(sizeof(CompactMove) == 8, "CompactMove must stay eight bytes");
+static_assert(std::is_trivially_copyable<CompactMove>::value, "CompactMove must be trivially copyable");
+
+#endif
@@ -0,0 +1,501 @@
+#include "EndgameDatabase.h"
+
+#include "MappedFile.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <fstream>
+
+// A slice file starts with this header (all numbers little-endian):
+//   0  the magic bytes below
+//   8  the slice's four counts (white men, white kings, black men, black kings)
+//  12  the positions in each block (32 bits)
+//  16  the positions in the slice (64 bits)
+//  24  the number of blocks (32 bits), then four zero bytes
+//  32  where each block starts in the data, and then where the data ends (64 bits each)
+// followed by the compressed blocks.
+static const char FILE_MAGIC[8] = {'C', 'K', 'E', 'G', 'D', 'B', 'Z', '1'};
+static const int FILE_HEADER_SIZE = 32;
+
+static void appendVarint(std::vector<unsigned char>& out, std::uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((unsigned char)value);
+}
+
+/**
+ * @return Returns false if the data ends before the number does.
+ */
+static bool readVarint(const unsigned char*& data, const unsigned char* end, std::uint32_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 32 && data < end; shift += 7)
+    {
+        unsigned char byte = *data++;
+        value |= (std::uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// how a block is compressed: its first byte
+static const unsigned char RUNS_BLOCK = 0;
+static const unsigned char DICTIONARY_BLOCK = 1;
+
+/**
+ * Compresses a block as runs of equal values: each run is its length less one, then its value,
+ * both as variable-length numbers (seven bits a byte).
+ * @param values The values of the block
+ * @param count How many there are
+ * @param out The bytes to add the block to
+ */
+static void compressRuns(const std::uint16_t* values, int count, std::vector<unsigned char>& out)
+{
+    out.push_back(RUNS_BLOCK);
+    for (int i = 0; i < count;)
+    {
+        int run = 1;
+        while (i + run < count && values[i + run] == values[i])
+            run++;
+        appendVarint(out, (std::uint32_t)(run - 1));
+        appendVarint(out, values[i]);
+        i += run;
+    }
+}
+
+/**
+ * @return Returns the bits needed to tell apart the given number of things.
+ */
+static int getBitsFor(std::size_t count)
+{
+    int bits = 0;
+    while (((std::size_t)1 << bits) < count)
+        bits++;
+    return bits;
+}
+
+/**
+ * Compresses a block as the distinct values in it (in increasing order, as variable-length
+ * numbers), then for each position the number of its value among them, in as few bits as that
+ * takes. Blocks of wins and losses at many distances have few runs, but rarely more than a few
+ * dozen distinct values.
+ * @param values The values of the block
+ * @param count How many there are
+ * @param out The bytes to add the block to
+ */
+static void compressDictionary(const std::uint16_t* values, int count, std::vector<unsigned char>& out)
+{
+    std::vector<std::uint16_t> dictionary(values, values + count);
+    std::sort(dictionary.begin(), dictionary.end());
+    dictionary.erase(std::unique(dictionary.begin(), dictionary.end()), dictionary.end());
+
+    out.push_back(DICTIONARY_BLOCK);
+    appendVarint(out, (std::uint32_t)dictionary.size());
+    for (std::uint16_t value : dictionary)
+        appendVarint(out, value);
+
+    int bits = getBitsFor(dictionary.size());
+    std::uint32_t pending = 0;
+    int pendingBits = 0;
+    for (int i = 0; i < count; i++)
+    {
+        std::uint32_t code = (std::uint32_t)(std::lower_bound(dictionary.begin(), dictionary.end(), values[i]) - dictionary.begin());
+        pending |= code << pendingBits;
+        pendingBits += bits;
+        while (pendingBits >= 8)
+        {
+            out.push_back((unsigned char)pending);
+            pending >>= 8;
+            pendingBits -= 8;
+        }
+    }
+    if (pendingBits > 0)
+        out.push_back((unsigned char)pending);
+}
+
+/**
+ * Compresses a block whichever way makes it smaller.
+ * @param values The values of the block
+ * @param count How many there are
+ * @param out The bytes to add the block to
+ */
+static void compressBlock(const std::uint16_t* values, int count, std::vector<unsigned char>& out)
+{
+    std::vector<unsigned char> runs, dictionary;
+    compressRuns(values, count, runs);
+    compressDictionary(values, count, dictionary);
+    const std::vector<unsigned char>& smaller = runs.size() <= dictionary.size() ? runs : dictionary;
+    out.insert(out.end(), smaller.begin(), smaller.end());
+}
+
+/**
+ * @return Returns true if the block held exactly the given number of values.
+ * @param data The compressed block
+ * @param end Where it ends
+ * @param count How many values it holds
+ * @param values The array to decompress them into
+ */
+static bool decompressBlock(const unsigned char* data, const unsigned char* end, int count, std::uint16_t* values)
+{
+    if (data == end)
+        return false;
+    unsigned char kind = *data++;
+
+    if (kind == RUNS_BLOCK)
+    {
+        int filled = 0;
+        while (filled < count)
+        {
+            std::uint32_t run, value;
+            if (!readVarint(data, end, run) || !readVarint(data, end, value) || run >= (std::uint32_t)(count - filled) ||
+                value > 0xffff)
+                return false;
+            for (std::uint32_t i = 0; i <= run; i++)
+                values[filled++] = (std::uint16_t)value;
+        }
+        return data == end;
+    }
+
+    if (kind != DICTIONARY_BLOCK)
+        return false;
+    std::uint32_t size;
+    if (!readVarint(data, end, size) || size == 0 || size > (std::uint32_t)count)
+        return false;
+    std::uint16_t dictionary[EndgameDatabase::BLOCK_VALUES];
+    for (std::uint32_t i = 0; i < size; i++)
+    {
+        std::uint32_t value;
+        if (!readVarint(data, end, value) || value > 0xffff)
+            return false;
+        dictionary[i] = (std::uint16_t)value;
+    }
+
+    int bits = getBitsFor(size);
+    if (end - data != ((std::ptrdiff_t)count * bits + 7) / 8)
+        return false;
+    std::uint32_t mask = ((std::uint32_t)1 << bits) - 1;
+    std::uint32_t pending = 0;
+    int pendingBits = 0;
+    for (int i = 0; i < count; i++)
+    {
+        while (pendingBits < bits)
+        {
+            pending |= (std::uint32_t)*data++ << pendingBits;
+            pendingBits += 8;
+        }
+        std::uint32_t code = pending & mask;
+        if (code >= size)
+            return false;
+        values[i] = dictionary[code];
+        pending >>= bits;
+        pendingBits -= bits;
+    }
+    return true;
+}
+
+/**
+ * A slice file mapped into memory.
+ */
+struct EndgameDatabase::MappedSlice
+{
+    EndgameIndex index;
+    MappedFile file;
+    const unsigned char* bytes;
+    std::size_t length;
+    std::uint32_t blockCount;
+    const unsigned char* blockStarts;
+    const unsigned char* blocks;
+
+    explicit MappedSlice(const EndgameSlice& slice) : index(slice), bytes(nullptr), length(0), blockCount(0)
+    {
+    }
+
+    /**
+     * @return Returns true if the file was mapped, and its header matches the slice.
+     */
+    bool map(const std::string& path)
+    {
+        if (!file.open(path) || file.getSize() < (std::size_t)FILE_HEADER_SIZE)
+            return false;
+        bytes = file.getData();
+        length = file.getSize();
+
+        const EndgameSlice& slice = index.getSlice();
+        if (!std::equal(FILE_MAGIC, FILE_MAGIC + 8, (const char*)bytes) || bytes[8] != slice.whiteMen ||
+            bytes[9] != slice.whiteKings || bytes[10] != slice.blackMen || bytes[11] != slice.blackKings ||
+            readLittleEndian(bytes + 12, 4) != (std::uint64_t)BLOCK_VALUES || readLittleEndian(bytes + 16, 8) != index.getSize())
+            return false;
+
+        blockCount = (std::uint32_t)readLittleEndian(bytes + 24, 4);
+        blockStarts = bytes + FILE_HEADER_SIZE;
+        blocks = blockStarts + ((std::size_t)blockCount + 1) * 8;
+        return blockCount == (index.getSize() + BLOCK_VALUES - 1) / BLOCK_VALUES &&
+               (std::size_t)(blocks - bytes) <= length &&
+               readLittleEndian(blockStarts + (std::size_t)blockCount * 8, 8) == (std::uint64_t)(length - (blocks - bytes));
+    }
+
+    /**
+     * @return Returns true if a block decompressed into values (BLOCK_VALUES long).
+     */
+    bool decompress(std::uint32_t block, std::uint16_t* values) const
+    {
+        std::uint64_t start = readLittleEndian(blockStarts + (std::size_t)block * 8, 8);
+        std::uint64_t end = readLittleEndian(blockStarts + (std::size_t)block * 8 + 8, 8);
+        if (start > end || end > (std::uint64_t)(length - (blocks - bytes)))
+            return false;
+        std::uint64_t first = (std::uint64_t)block * BLOCK_VALUES;
+        int count = (int)std::min<std::uint64_t>(BLOCK_VALUES, index.getSize() - first);
+        return decompressBlock(blocks + start, blocks + end, count, values);
+    }
+};
+
+/**
+ * Constructor for an empty database (see open).
+ * @param cacheMegabytes The size of the cache of decompressed blocks, in megabytes
+ */
+EndgameDatabase::EndgameDatabase(std::size_t cacheMegabytes) : maxPieces(0), useClock(1), blocksDecompressed(0)
+{
+    const int base = EndgameIndex::MAX_PIECES + 1;
+    slices.resize(base * base * base * base);
+
+    // a power of two of sets, so a key picks its set with a mask
+    cacheSets = 1;
+    while (cacheSets * 2 * sizeof(CacheSet) <= cacheMegabytes * 1024 * 1024)
+        cacheSets *= 2;
+    setMask = cacheSets - 1;
+}
+
+EndgameDatabase::~EndgameDatabase()
+{
+}
+
+/**
+ * Maps every slice file in a directory (closing any opened before).
+ * @param directory The directory checkers_egdbgen wrote the slices to
+ * @return Returns the most pieces every position with up to that many is in the database for.
+ */
+int EndgameDatabase::open(const std::string& directory)
+{
+    for (std::unique_ptr<MappedSlice>& slice : slices)
+        slice.reset();
+    // (a fresh cache, since the blocks of the slices of the same names may differ now)
+    cache.reset();
+
+    maxPieces = 0;
+    int found = 0;
+    bool complete = true;
+    for (int pieces = 2; pieces <= EndgameIndex::MAX_PIECES; pieces++)
+    {
+        for (int whitePieces = 1; whitePieces < pieces; whitePieces++)
+        {
+            for (int whiteMen = 0; whiteMen <= whitePieces; whiteMen++)
+            {
+                for (int blackMen = 0; blackMen <= pieces - whitePieces; blackMen++)
+                {
+                    EndgameSlice slice{whiteMen, whitePieces - whiteMen, blackMen, pieces - whitePieces - blackMen};
+                    std::unique_ptr<MappedSlice> mapped(new MappedSlice(slice));
+                    if (!mapped->map(directory + "/" + getFileName(slice)))
+                    {
+                        complete = false;
+                        continue;
+                    }
+                    slices[getSliceCode(slice)] = std::move(mapped);
+                    found++;
+                }
+            }
+        }
+        if (complete)
+            maxPieces = pieces;
+    }
+    if (found > 0)
+        cache.reset(new CacheSet[cacheSets]);
+
+    TRACE_INFO("Endgame database: " << found << " slices in " << directory << ", complete up to " << maxPieces << " pieces");
+    return maxPieces;
+}
+
+/**
+ * Looks up a position.
+ * @param board The position
+ * @param distance Set to the plies until the game ends with best play, for a win or a loss (may be null)
+ * @return Returns the result for the side to move, or ENDGAME_UNKNOWN if the position isn't in the database.
+ */
+EndgameResult EndgameDatabase::probe(const BasicBoard<EnglishRules>& board, int* distance) const
+{
+    return probe(board.getPieceMask(true), board.getPieceMask(false), board.getKingMask(true) | board.getKingMask(false),
+                 board.isWhiteToMove(), distance);
+}
+
+/**
+ * Looks up a position given as bitboards.
+ * @param whitePieces The bitboard of the white pieces (kings included)
+ * @param blackPieces The bitboard of the black pieces (kings included)
+ * @param kings The bitboard of the kings of both colors
+ * @param whiteToMove Whether it is white's turn
+ * @param distance Set to the plies until the game ends with best play, for a win or a loss (may be null)
+ * @return Returns the result for the side to move, or ENDGAME_UNKNOWN if the position isn't in the database.
+ */
+EndgameResult EndgameDatabase::probe(bitboard_t whitePieces, bitboard_t blackPieces, bitboard_t kings, bool whiteToMove,
+                                     int* distance) const
+{
+    // the databases only hold positions with white to move, so turn black's around (see EndgameIndex::rotate)
+    bitboard_t mover = whiteToMove ? whitePieces : EndgameIndex::rotate(blackPieces);
+    bitboard_t other = whiteToMove ? blackPieces : EndgameIndex::rotate(whitePieces);
+    if (!whiteToMove)
+        kings = EndgameIndex::rotate(kings);
+
+    // a side with no pieces has no moves (and a position where the other side has none is already over)
+    if (mover == 0)
+    {
+        if (distance != nullptr)
+            *distance = 0;
+        return ENDGAME_LOSS;
+    }
+    if (other == 0 || popCount(mover | other) > EndgameIndex::MAX_PIECES)
+        return ENDGAME_UNKNOWN;
+
+    const MappedSlice* slice = slices[getSliceCode(EndgameSlice::fromPosition(mover, other, kings))].get();
+    if (slice == nullptr)
+        return ENDGAME_UNKNOWN;
+
+    std::uint16_t value = getValue(*slice, slice->index.getIndex(mover, other, kings));
+    if (distance != nullptr)
+        *distance = EndgameValue::getDistance(value);
+    return EndgameValue::getResult(value);
+}
+
+/**
+ * @return Returns the value of a position in a mapped slice, from the cache or else its block.
+ * @param slice The slice
+ * @param index The position's number in the slice
+ */
+std::uint16_t EndgameDatabase::getValue(const MappedSlice& slice, std::uint64_t index) const
+{
+    std::uint32_t block = (std::uint32_t)(index / BLOCK_VALUES);
+    int offset = (int)(index % BLOCK_VALUES);
+    std::uint64_t key = (((std::uint64_t)getSliceCode(slice.index.getSlice()) << 32) | block) + 1;
+    CacheSet& set = cache[(std::size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & setMask];
+    std::uint32_t now = useClock.load(std::memory_order_relaxed);
+
+    // a hit is only good if nothing refilled the entry while it was being read
+    for (CacheEntry& entry : set.entries)
+    {
+        std::uint32_t sequence = entry.sequence.load(std::memory_order_acquire);
+        if ((sequence & 1) || entry.key.load(std::memory_order_relaxed) != key)
+            continue;
+        std::uint16_t value = entry.values[offset].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.sequence.load(std::memory_order_relaxed) != sequence)
+            continue;
+        if (entry.lastUsed.load(std::memory_order_relaxed) != now)
+            entry.lastUsed.store(now, std::memory_order_relaxed);
+        return value;
+    }
+
+    std::uint16_t values[BLOCK_VALUES];
+    if (!slice.decompress(block, values))
+    {
+        TRACE_ERROR("Endgame database: block " << block << " of slice " << slice.index.getSlice().getName() << " is damaged");
+        return EndgameValue::pack(ENDGAME_UNKNOWN, 0);
+    }
+    blocksDecompressed.fetch_add(1, std::memory_order_relaxed);
+
+    // replace the least recently used entry of the set, unless another thread is filling it
+    CacheEntry* victim = &set.entries[0];
+    for (CacheEntry& entry : set.entries)
+    {
+        if (entry.key.load(std::memory_order_relaxed) == 0)
+        {
+            victim = &entry;
+            break;
+        }
+        if (entry.lastUsed.load(std::memory_order_relaxed) < victim->lastUsed.load(std::memory_order_relaxed))
+            victim = &entry;
+    }
+    std::uint32_t sequence = victim->sequence.load(std::memory_order_relaxed);
+    if (!(sequence & 1) && victim->sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_relaxed))
+    {
+        std::atomic_thread_fence(std::memory_order_release);
+        victim->key.store(key, std::memory_order_relaxed);
+        for (int i = 0; i < BLOCK_VALUES; i++)
+            victim->values[i].store(values[i], std::memory_order_relaxed);
+        victim->lastUsed.store(useClock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        victim->sequence.store(sequence + 2, std::memory_order_release);
+    }
+    return values[offset];
+}
+
+/**
+ * @return Returns a number for each slice, for finding it without searching.
+ * @param slice The slice
+ */
+int EndgameDatabase::getSliceCode(const EndgameSlice& slice)
+{
+    const int base = EndgameIndex::MAX_PIECES + 1;
+    return ((slice.whiteMen * base + slice.whiteKings) * base + slice.blackMen) * base + slice.blackKings;
+}
+
+/**
+ * Compresses a slice's values and writes them to a file.
+ * @param path The file to write
+ * @param slice The slice
+ * @param values The value of every position of the slice (see EndgameValue), by index
+ * @return Returns true if the file was written.
+ */
+bool EndgameDatabase::writeSlice(const std::string& path, const EndgameSlice& slice, const std::vector<std::uint16_t>& values)
+{
+    std::uint32_t blockCount = (std::uint32_t)((values.size() + BLOCK_VALUES - 1) / BLOCK_VALUES);
+    std::vector<unsigned char> header(FILE_HEADER_SIZE + ((std::size_t)blockCount + 1) * 8);
+    std::vector<unsigned char> data;
+    for (std::uint32_t block = 0; block < blockCount; block++)
+    {
+        writeLittleEndian(&header[FILE_HEADER_SIZE + (std::size_t)block * 8], data.size(), 8);
+        std::size_t first = (std::size_t)block * BLOCK_VALUES;
+        compressBlock(&values[first], (int)std::min<std::size_t>(BLOCK_VALUES, values.size() - first), data);
+    }
+    writeLittleEndian(&header[FILE_HEADER_SIZE + (std::size_t)blockCount * 8], data.size(), 8);
+
+    std::copy(FILE_MAGIC, FILE_MAGIC + 8, header.begin());
+    header[8] = (unsigned char)slice.whiteMen;
+    header[9] = (unsigned char)slice.whiteKings;
+    header[10] = (unsigned char)slice.blackMen;
+    header[11] = (unsigned char)slice.blackKings;
+    writeLittleEndian(&header[12], BLOCK_VALUES, 4);
+    writeLittleEndian(&header[16], values.size(), 8);
+    writeLittleEndian(&header[24], blockCount, 4);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write((const char*)header.data(), header.size());
+    file.write((const char*)data.data(), data.size());
+    return (bool)file;
+}
+
+/**
+ * Reads and decompresses all of a slice's file.
+ * @param path The file to read
+ * @param slice The slice the file should hold
+ * @param values Set to the value of every position of the slice, by index
+ * @return Returns true if the file was there, held that slice and was complete.
+ */
+bool EndgameDatabase::readSlice(const std::string& path, const EndgameSlice& slice, std::vector<std::uint16_t>& values)
+{
+    MappedSlice mapped(slice);
+    if (!mapped.map(path))
+        return false;
+
+    values.resize(mapped.index.getSize());
+    std::uint16_t block[BLOCK_VALUES];
+    for (std::uint32_t i = 0; i < mapped.blockCount; i++)
+    {
+        if (!mapped.decompress(i, block))
+            return false;
+        std::size_t first = (std::size_t)i * BLOCK_VALUES;
+        std::copy(block, block + std::min<std::size_t>(BLOCK_VALUES, values.size() - first), values.begin() + first);
+    }
+    return true;
+}
@@ -0,0 +1,157 @@
+#ifndef ENDGAME_DATABASE_H
+#define ENDGAME_DATABASE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Typedefs.h"
+#include "BasicBoard.h"
+#include "EndgameIndex.h"
+
+/**
+ * Looks up endgame positions in the databases tools/egdbgen.cpp generates: whether the side to
+ * move wins, loses or draws, and in how many moves.
+ *
+ * Each slice (see EndgameIndex.h) is one file, made of blocks of BLOCK_VALUES positions, each
+ * compressed on its own (as runs of equal values, or as a short list of the values in it and a
+ * few bits per position saying which), with a table of where every block starts.
+ * The files are memory-mapped rather than read, so only the blocks actually looked at are ever
+ * loaded, and the operating system shares them between processes. Decompressed blocks are kept
+ * in a cache of fixed size, four to a set, replacing the least recently used block of a set.
+ *
+ * Lookups take no locks, so any number of search threads can probe at once: a cache entry is
+ * guarded by a sequence number that is odd while the entry is being filled and bumped when it
+ * is done, and a reader that sees it change while reading simply decompresses the block itself.
+ *
+ * open must not be called while other threads are probing.
+ */
+class EndgameDatabase
+{
+	public:
+		/**
+		 * Constructor for an empty database (see open).
+		 * @param cacheMegabytes The size of the cache of decompressed blocks, in megabytes
+		 */
+		explicit EndgameDatabase(std::size_t cacheMegabytes = 32);
+
+		~EndgameDatabase();
+
+		EndgameDatabase(const EndgameDatabase&) = delete;
+		EndgameDatabase& operator=(const EndgameDatabase&) = delete;
+
+		/**
+		 * Maps every slice file in a directory (closing any opened before).
+		 * @param directory The directory checkers_egdbgen wrote the slices to
+		 * @return Returns the most pieces every position with up to that many is in the database
+		 * for (see getMaxPieces), so 0 if there are no usable files.
+		 */
+		int open(const std::string& directory);
+
+		/**
+		 * @return Returns the most pieces every position with up to that many pieces is in the
+		 * database for, or 0 if nothing is open.
+		 */
+		int getMaxPieces() const { return maxPieces; }
+
+		/**
+		 * Looks up a position.
+		 * @param board The position
+		 * @param distance Set to the plies until the game ends with best play, for a win or a loss (may be null)
+		 * @return Returns the result for the side to move, or ENDGAME_UNKNOWN if the position isn't in the database.
+		 */
+		EndgameResult probe(const BasicBoard<EnglishRules>& board, int* distance = nullptr) const;
+
+		/**
+		 * Looks up a position given as bitboards.
+		 * @param whitePieces The bitboard of the white pieces (kings included)
+		 * @param blackPieces The bitboard of the black pieces (kings included)
+		 * @param kings The bitboard of the kings of both colors
+		 * @param whiteToMove Whether it is white's turn
+		 * @param distance Set to the plies until the game ends with best play, for a win or a loss (may be null)
+		 * @return Returns the result for the side to move, or ENDGAME_UNKNOWN if the position isn't in the database.
+		 */
+		EndgameResult probe(bitboard_t whitePieces, bitboard_t blackPieces, bitboard_t kings, bool whiteToMove,
+		                    int* distance = nullptr) const;
+
+		/**
+		 * @return Returns how many blocks have been decompressed because they weren't in the cache.
+		 */
+		std::uint64_t getBlocksDecompressed() const { return blocksDecompressed.load(std::memory_order_relaxed); }
+
+		/**
+		 * @return Returns the name of a slice's file in the database's directory.
+		 * @param slice The slice
+		 */
+		static std::string getFileName(const EndgameSlice& slice) { return slice.getName() + ".egdb"; }
+
+		/**
+		 * Compresses a slice's values and writes them to a file.
+		 * @param path The file to write
+		 * @param slice The slice
+		 * @param values The value of every position of the slice (see EndgameValue), by index
+		 * @return Returns true if the file was written.
+		 */
+		static bool writeSlice(const std::string& path, const EndgameSlice& slice, const std::vector<std::uint16_t>& values);
+
+		/**
+		 * Reads and decompresses all of a slice's file.
+		 * @param path The file to read
+		 * @param slice The slice the file should hold
+		 * @param values Set to the value of every position of the slice, by index
+		 * @return Returns true if the file was there, held that slice and was complete.
+		 */
+		static bool readSlice(const std::string& path, const EndgameSlice& slice, std::vector<std::uint16_t>& values);
+
+		// the positions in each compressed block
+		const static int BLOCK_VALUES = 1024;
+
+	private:
+		struct MappedSlice;
+
+		struct CacheEntry
+		{
+			// odd while the entry is being filled
+			std::atomic<std::uint32_t> sequence{0};
+			// the slice and block the entry holds, plus one (0 for none)
+			std::atomic<std::uint64_t> key{0};
+			// when the entry was last used, by useClock
+			std::atomic<std::uint32_t> lastUsed{0};
+			std::atomic<std::uint16_t> values[BLOCK_VALUES];
+		};
+
+		const static int WAYS = 4;
+
+		struct CacheSet
+		{
+			CacheEntry entries[WAYS];
+		};
+
+		// by getSliceCode
+		std::vector<std::unique_ptr<MappedSlice>> slices;
+		int maxPieces;
+
+		// allocated by open, once there is something to cache
+		std::unique_ptr<CacheSet[]> cache;
+		std::size_t cacheSets;
+		std::size_t setMask;
+		mutable std::atomic<std::uint32_t> useClock;
+		mutable std::atomic<std::uint64_t> blocksDecompressed;
+
+		/**
+		 * @return Returns the value of a position in a mapped slice, from the cache or else its block.
+		 * @param slice The slice
+		 * @param index The position's number in the slice
+		 */
+		std::uint16_t getValue(const MappedSlice& slice, std::uint64_t index) const;
+
+		/**
+		 * @return Returns a number for each slice, for finding it without searching.
+		 * @param slice The slice
+		 */
+		static int getSliceCode(const EndgameSlice& slice);
+};
+
+#endif
@@ -0,0 +1,202 @@
+#include "EndgameIndex.h"
+
+#include <algorithm>
+
+// the squares men of each color can be on (never the row they would be crowned on)
+static const bitboard_t WHITE_MEN_SQUARES = 0x0FFFFFFF;
+static const bitboard_t BLACK_MEN_SQUARES = 0xFFFFFFF0;
+
+/**
+ * The binomial coefficients C(n, k) for every n up to the number of squares and every k up to
+ * the most pieces of a kind, which number the placements (see rankPlacement).
+ */
+struct BinomialTable
+{
+    std::uint64_t values[PLAYABLE_SQUARES + 1][EndgameIndex::MAX_PIECES + 1];
+};
+
+static constexpr BinomialTable buildBinomials()
+{
+    BinomialTable table = {};
+    for (int n = 0; n <= PLAYABLE_SQUARES; n++)
+    {
+        table.values[n][0] = 1;
+        for (int k = 1; k <= EndgameIndex::MAX_PIECES; k++)
+            table.values[n][k] = n == 0 ? 0 : table.values[n - 1][k - 1] + table.values[n - 1][k];
+    }
+    return table;
+}
+
+static constexpr BinomialTable BINOMIALS = buildBinomials();
+
+static_assert(BINOMIALS.values[32][3] == 4960 && BINOMIALS.values[28][8] == 3108105, "binomial table");
+
+/**
+ * @return Returns the number of ways to place some pieces on some squares.
+ * @param squares The number of squares
+ * @param pieces The number of pieces
+ */
+static std::uint64_t getPlacements(int squares, int pieces)
+{
+    return pieces > squares ? 0 : BINOMIALS.values[squares][pieces];
+}
+
+/**
+ * @return Returns the number of a placement of pieces among the given squares. The squares are
+ * counted from 0 in order, and a placement on counted squares c1 < c2 < ... < ck is numbered
+ * C(c1, 1) + C(c2, 2) + ... + C(ck, k), which numbers the placements of k pieces on n squares
+ * from 0 to C(n, k) - 1.
+ * @param pieces The bitboard of the pieces, all on the given squares
+ * @param squares The bitboard of the squares they may be on
+ */
+static std::uint64_t rankPlacement(bitboard_t pieces, bitboard_t squares)
+{
+    std::uint64_t rank = 0;
+    int count = 1;
+    while (pieces)
+    {
+        int square = popLowestSquare(pieces);
+        int counted = popCount(squares & (((bitboard_t)1 << square) - 1));
+        rank += BINOMIALS.values[counted][count++];
+    }
+    return rank;
+}
+
+/**
+ * @return Returns the placement with the given number (the opposite of rankPlacement).
+ * @param rank The number of the placement
+ * @param count The number of pieces
+ * @param squares The bitboard of the squares they may be on
+ */
+static bitboard_t unrankPlacement(std::uint64_t rank, int count, bitboard_t squares)
+{
+    // the counted squares of the pieces, highest first
+    int counted[EndgameIndex::MAX_PIECES];
+    int candidate = popCount(squares) - 1;
+    for (int k = count; k >= 1; k--)
+    {
+        while (BINOMIALS.values[candidate][k] > rank)
+            candidate--;
+        counted[k - 1] = candidate;
+        rank -= BINOMIALS.values[candidate][k];
+        candidate--;
+    }
+
+    // then the squares those counts are
+    bitboard_t pieces = 0;
+    int next = 0;
+    int index = 0;
+    while (squares && next < count)
+    {
+        int square = popLowestSquare(squares);
+        if (index++ == counted[next])
+        {
+            pieces |= (bitboard_t)1 << square;
+            next++;
+        }
+    }
+    return pieces;
+}
+
+/**
+ * @return Returns the slice's name, its four counts in order.
+ */
+std::string EndgameSlice::getName() const
+{
+    return std::to_string(whiteMen) + std::to_string(whiteKings) + std::to_string(blackMen) + std::to_string(blackKings);
+}
+
+/**
+ * @return Returns the slice the given position is in.
+ * @param whitePieces The bitboard of the white pieces (kings included)
+ * @param blackPieces The bitboard of the black pieces (kings included)
+ * @param kings The bitboard of the kings of both colors
+ */
+EndgameSlice EndgameSlice::fromPosition(bitboard_t whitePieces, bitboard_t blackPieces, bitboard_t kings)
+{
+    return EndgameSlice{popCount(whitePieces & ~kings), popCount(whitePieces & kings),
+                        popCount(blackPieces & ~kings), popCount(blackPieces & kings)};
+}
+
+/**
+ * Constructor for the index of a slice.
+ * @param slice The slice
+ */
+EndgameIndex::EndgameIndex(const EndgameSlice& slice) : slice(slice)
+{
+    int men = slice.whiteMen + slice.blackMen;
+    whiteKingPlacements = getPlacements(PLAYABLE_SQUARES - men, slice.whiteKings);
+    blackKingPlacements = getPlacements(PLAYABLE_SQUARES - men - slice.whiteKings, slice.blackKings);
+
+    // how many ways the black men can be placed depends on how many of their squares the white men take
+    std::uint64_t whiteMenPlacements = getPlacements(popCount(WHITE_MEN_SQUARES), slice.whiteMen);
+    whiteMenStarts.resize(whiteMenPlacements + 1);
+    whiteMenStarts[0] = 0;
+    for (std::uint64_t rank = 0; rank < whiteMenPlacements; rank++)
+    {
+        bitboard_t whiteMen = unrankPlacement(rank, slice.whiteMen, WHITE_MEN_SQUARES);
+        std::uint64_t blackMenPlacements = getPlacements(popCount(BLACK_MEN_SQUARES & ~whiteMen), slice.blackMen);
+        whiteMenStarts[rank + 1] = whiteMenStarts[rank] + blackMenPlacements * whiteKingPlacements * blackKingPlacements;
+    }
+    size = whiteMenStarts.back();
+}
+
+/**
+ * @return Returns the number of a position (with white to move), which must be in this slice.
+ * @param whitePieces The bitboard of the white pieces (kings included)
+ * @param blackPieces The bitboard of the black pieces (kings included)
+ * @param kings The bitboard of the kings of both colors
+ */
+std::uint64_t EndgameIndex::getIndex(bitboard_t whitePieces, bitboard_t blackPieces, bitboard_t kings) const
+{
+    bitboard_t whiteMen = whitePieces & ~kings;
+    bitboard_t blackMen = blackPieces & ~kings;
+    bitboard_t men = whiteMen | blackMen;
+
+    std::uint64_t index = whiteMenStarts[rankPlacement(whiteMen, WHITE_MEN_SQUARES)];
+    std::uint64_t rest = rankPlacement(blackMen, BLACK_MEN_SQUARES & ~whiteMen);
+    rest = rest * whiteKingPlacements + rankPlacement(whitePieces & kings, ~men);
+    rest = rest * blackKingPlacements + rankPlacement(blackPieces & kings, ~(men | (whitePieces & kings)));
+    return index + rest;
+}
+
+/**
+ * Works out the position with the given number.
+ * @param index The number, from 0 to getSize() - 1
+ * @param whitePieces Set to the bitboard of the white pieces (kings included)
+ * @param blackPieces Set to the bitboard of the black pieces (kings included)
+ * @param kings Set to the bitboard of the kings of both colors
+ */
+void EndgameIndex::getPosition(std::uint64_t index, bitboard_t& whitePieces, bitboard_t& blackPieces, bitboard_t& kings) const
+{
+    std::uint64_t whiteMenRank = std::upper_bound(whiteMenStarts.begin(), whiteMenStarts.end(), index) - whiteMenStarts.begin() - 1;
+    std::uint64_t rest = index - whiteMenStarts[whiteMenRank];
+    std::uint64_t blackKingRank = rest % blackKingPlacements;
+    rest /= blackKingPlacements;
+    std::uint64_t whiteKingRank = rest % whiteKingPlacements;
+    std::uint64_t blackMenRank = rest / whiteKingPlacements;
+
+    bitboard_t whiteMen = unrankPlacement(whiteMenRank, slice.whiteMen, WHITE_MEN_SQUARES);
+    bitboard_t blackMen = unrankPlacement(blackMenRank, slice.blackMen, BLACK_MEN_SQUARES & ~whiteMen);
+    bitboard_t men = whiteMen | blackMen;
+    bitboard_t whiteKings = unrankPlacement(whiteKingRank, slice.whiteKings, ~men);
+    bitboard_t blackKings = unrankPlacement(blackKingRank, slice.blackKings, ~(men | whiteKings));
+
+    whitePieces = whiteMen | whiteKings;
+    blackPieces = blackMen | blackKings;
+    kings = whiteKings | blackKings;
+}
+
+/**
+ * @return Returns a bitboard turned half way around (square n becomes square 31 - n).
+ * @param bits The bitboard
+ */
+bitboard_t EndgameIndex::rotate(bitboard_t bits)
+{
+    // reverse the bits, swapping ever larger halves
+    bits = ((bits >> 1) & 0x55555555) | ((bits & 0x55555555) << 1);
+    bits = ((bits >> 2) & 0x33333333) | ((bits & 0x33333333) << 2);
+    bits = ((bits >> 4) & 0x0F0F0F0F) | ((bits & 0x0F0F0F0F) << 4);
+    bits = ((bits >> 8) & 0x00FF00FF) | ((bits & 0x00FF00FF) << 8);
+    return (bits >> 16) | (bits << 16);
+}
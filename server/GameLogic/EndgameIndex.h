@@ -0,0 +1,174 @@
+#ifndef ENDGAME_INDEX_H
+#define ENDGAME_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Typedefs.h"
+#include "Bitboard.h"
+
+/**
+ * The numbering of endgame positions the endgame databases are stored in (see
+ * tools/egdbgen.cpp, which generates them).
+ *
+ * Positions are grouped into slices by how many men and kings each side has, and every
+ * position of a slice gets its own number, from 0 to the slice's size - 1, with no gaps:
+ * a perfect index. Only positions with white to move are numbered; a position with black to
+ * move is looked up as the same position turned around (see rotate), which has white to move
+ * and the colors swapped, so it is in the slice with the counts swapped.
+ *
+ * Men are never on the row they would be crowned on (white men are on squares 0 to 27, black
+ * men on 4 to 31), and no two pieces share a square, so every number is a position that could
+ * be on the board.
+ */
+
+/**
+ * How many men and kings each side has, which picks the slice a position is in.
+ */
+struct EndgameSlice
+{
+	int whiteMen;
+	int whiteKings;
+	int blackMen;
+	int blackKings;
+
+	/**
+	 * @return Returns the number of pieces on the board.
+	 */
+	int getPieceCount() const { return whiteMen + whiteKings + blackMen + blackKings; }
+
+	/**
+	 * @return Returns the number of men (of both colors) on the board.
+	 */
+	int getMenCount() const { return whiteMen + blackMen; }
+
+	/**
+	 * @return Returns the slice with the colors swapped (which holds this slice's positions with
+	 * black to move, turned around).
+	 */
+	EndgameSlice getSwapped() const { return EndgameSlice{blackMen, blackKings, whiteMen, whiteKings}; }
+
+	/**
+	 * @return Returns the slice's name, its four counts in order (e.g. "1201" for one white man,
+	 * two white kings and one black king), which is also the name of its file.
+	 */
+	std::string getName() const;
+
+	/**
+	 * @return Returns the slice the given position is in.
+	 * @param whitePieces The bitboard of the white pieces (kings included)
+	 * @param blackPieces The bitboard of the black pieces (kings included)
+	 * @param kings The bitboard of the kings of both colors
+	 */
+	static EndgameSlice fromPosition(bitboard_t whitePieces, bitboard_t blackPieces, bitboard_t kings);
+
+	bool operator==(const EndgameSlice& other) const
+	{
+		return whiteMen == other.whiteMen && whiteKings == other.whiteKings &&
+		       blackMen == other.blackMen && blackKings == other.blackKings;
+	}
+	bool operator!=(const EndgameSlice& other) const { return !(*this == other); }
+};
+
+/**
+ * The result of an endgame position for the side to move.
+ */
+enum EndgameResult
+{
+	// not in the database
+	ENDGAME_UNKNOWN = 0,
+	ENDGAME_DRAW = 1,
+	ENDGAME_WIN = 2,
+	ENDGAME_LOSS = 3
+};
+
+/**
+ * What the databases store for each position: the result for the side to move and, for a win
+ * or a loss, how many moves (plies) the game lasts with best play, packed into 16 bits.
+ */
+class EndgameValue
+{
+	public:
+		/**
+		 * @return Returns a packed value.
+		 * @param result The result for the side to move
+		 * @param distance The plies until the side to move has no move left (0 for a draw)
+		 */
+		static std::uint16_t pack(EndgameResult result, int distance) { return (std::uint16_t)((distance << 2) | result); }
+
+		static EndgameResult getResult(std::uint16_t value) { return (EndgameResult)(value & 3); }
+		static int getDistance(std::uint16_t value) { return value >> 2; }
+
+		// the longest distance a value can hold
+		const static int MAX_DISTANCE = 0x3fff;
+};
+
+/**
+ * The perfect index of one slice. Building it works out a table of where each placement of the
+ * white men starts, so it is made once per slice and kept.
+ *
+ * A position's number is made of, from most to least significant: the placement of the white
+ * men, the black men (among the squares black men can be on that the white men leave free),
+ * the white kings (among the squares the men leave free) and the black kings (among the rest).
+ * Each placement is numbered by the combinatorial number system, so the numbers of each part
+ * run from 0 to the number of ways it can be placed, with nothing skipped.
+ */
+class EndgameIndex
+{
+	public:
+		/**
+		 * Constructor for the index of a slice.
+		 * @param slice The slice
+		 */
+		explicit EndgameIndex(const EndgameSlice& slice);
+
+		/**
+		 * @return Returns the number of positions in the slice.
+		 */
+		std::uint64_t getSize() const { return size; }
+
+		/**
+		 * @return Returns the slice this indexes.
+		 */
+		const EndgameSlice& getSlice() const { return slice; }
+
+		/**
+		 * @return Returns the number of a position (with white to move), which must be in this slice.
+		 * @param whitePieces The bitboard of the white pieces (kings included)
+		 * @param blackPieces The bitboard of the black pieces (kings included)
+		 * @param kings The bitboard of the kings of both colors
+		 */
+		std::uint64_t getIndex(bitboard_t whitePieces, bitboard_t blackPieces, bitboard_t kings) const;
+
+		/**
+		 * Works out the position with the given number.
+		 * @param index The number, from 0 to getSize() - 1
+		 * @param whitePieces Set to the bitboard of the white pieces (kings included)
+		 * @param blackPieces Set to the bitboard of the black pieces (kings included)
+		 * @param kings Set to the bitboard of the kings of both colors
+		 */
+		void getPosition(std::uint64_t index, bitboard_t& whitePieces, bitboard_t& blackPieces, bitboard_t& kings) const;
+
+		/**
+		 * @return Returns a bitboard turned half way around (square n becomes square 31 - n), which
+		 * turns a position with black to move into the same position for white, once the colors
+		 * are swapped: black's men then move the way white's do, toward the last row.
+		 * @param bits The bitboard
+		 */
+		static bitboard_t rotate(bitboard_t bits);
+
+		// the most pieces a slice can have (the combinatorial tables only go this far)
+		const static int MAX_PIECES = 8;
+
+	private:
+		EndgameSlice slice;
+		std::uint64_t size;
+		// the ways to place the kings for any placement of the men
+		std::uint64_t whiteKingPlacements;
+		std::uint64_t blackKingPlacements;
+		// where the numbers of each placement of the white men start
+		// (one more than there are placements, so the last is the size)
+		std::vector<std::uint64_t> whiteMenStarts;
+};
+
+#endif
@@ -0,0 +1,377 @@
+#include "Evaluation.h"
+
+#include "SquareTables.h"
+
+#include <fstream>
+#include <sstream>
+
+// The AVX2 evaluator is compiled for that instruction set function by function (with the target
+// attribute), not for the whole program, so it is only ever run once the processor is known to have it.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define EVAL_BUILD_AVX2 1
+#include <immintrin.h>
+#else
+#define EVAL_BUILD_AVX2 0
+#endif
+
+/**
+ * Every playable square a step in a direction starts from, and how far (in squares) the step
+ * moves it, split by the parity of its row. Within a row parity every step in a direction
+ * changes the square number by the same amount, so a whole bitboard of pieces can be
+ * stepped with one shift.
+ */
+struct StepShifts
+{
+	// [direction][row parity]
+	int shift[4][2];
+	bitboard_t from[4][2];
+};
+
+/**
+ * @return Returns the shifts for every direction of the 8x8 board. (Only ever run by the compiler)
+ */
+constexpr StepShifts buildStepShifts()
+{
+    StepShifts shifts = {};
+    for (int square = 0; square < PLAYABLE_SQUARES; square++)
+    {
+        int parity = (square / 4) % 2;
+        for (int direction = 0; direction < 4; direction++)
+        {
+            int step = SQUARE_TABLES.step[square][direction];
+            if (step == NO_SQUARE)
+                continue;
+            shifts.shift[direction][parity] = step - square;
+            shifts.from[direction][parity] |= (bitboard_t)1 << square;
+        }
+    }
+    return shifts;
+}
+
+/**
+ * @return Returns the bitboard of the middle 4x4 of the board. (Only ever run by the compiler)
+ */
+constexpr bitboard_t buildCenterMask()
+{
+    bitboard_t mask = 0;
+    for (int square = 0; square < PLAYABLE_SQUARES; square++)
+    {
+        int y = square / 4;
+        int x = 2 * (square % 4) + y % 2;
+        if (x >= 2 && x <= 5 && y >= 2 && y <= 5)
+            mask |= (bitboard_t)1 << square;
+    }
+    return mask;
+}
+
+// the name of each weight in a weights file
+static const struct
+{
+    const char* name;
+    int EvalWeights::*value;
+} WEIGHT_NAMES[] = {
+    { "man", &EvalWeights::man },
+    { "king", &EvalWeights::king },
+    { "backRank", &EvalWeights::backRank },
+    { "mobility", &EvalWeights::mobility },
+    { "center", &EvalWeights::center }
+};
+
+static constexpr StepShifts STEP_SHIFTS = buildStepShifts();
+static constexpr bitboard_t CENTER_MASK = buildCenterMask();
+
+// the rows each side's men start on the back of (white starts at the top)
+static constexpr bitboard_t WHITE_BACK_ROW = 0x0000000f;
+static constexpr bitboard_t BLACK_BACK_ROW = 0xf0000000;
+
+static_assert(STEP_SHIFTS.shift[3][0] == 4 && STEP_SHIFTS.shift[2][0] == 3 && STEP_SHIFTS.shift[3][1] == 5, "step shifts");
+static_assert(CENTER_MASK == 0x00666600, "the center is the eight playable squares of the middle 4x4");
+
+/**
+ * @return Returns the number of single steps from the given squares, in the given direction, onto empty squares.
+ * @param pieces The squares to step from
+ * @param empty The empty squares
+ * @param direction The direction, from 0 to 3
+ */
+static inline int countSteps(bitboard_t pieces, bitboard_t empty, int direction)
+{
+    int count = 0;
+    for (int parity = 0; parity < 2; parity++)
+    {
+        int shift = STEP_SHIFTS.shift[direction][parity];
+        bitboard_t from = pieces & STEP_SHIFTS.from[direction][parity];
+        bitboard_t to = shift > 0 ? from << shift : from >> -shift;
+        count += popCount(to & empty);
+    }
+    return count;
+}
+
+/**
+ * @return Returns the unweighted terms of a position.
+ * @param whitePieces The bitboard of the white pieces (kings included)
+ * @param blackPieces The bitboard of the black pieces (kings included)
+ * @param kings The bitboard of the kings of both colors
+ */
+EvalTerms Evaluator::getTerms(bitboard_t whitePieces, bitboard_t blackPieces, bitboard_t kings)
+{
+    bitboard_t whiteKings = whitePieces & kings;
+    bitboard_t blackKings = blackPieces & kings;
+    bitboard_t whiteMen = whitePieces & ~kings;
+    bitboard_t blackMen = blackPieces & ~kings;
+    bitboard_t empty = ~(whitePieces | blackPieces);
+
+    EvalTerms terms;
+    terms.material = popCount(whiteMen) - popCount(blackMen);
+    terms.kings = popCount(whiteKings) - popCount(blackKings);
+    terms.backRank = popCount(whiteMen & WHITE_BACK_ROW) - popCount(blackMen & BLACK_BACK_ROW);
+    terms.center = popCount(whitePieces & CENTER_MASK) - popCount(blackPieces & CENTER_MASK);
+
+    // every piece steps forward (+y for white, -y for black), but only kings step backward
+    terms.mobility = 0;
+    for (int direction = 0; direction < 4; direction++)
+    {
+        bool isForwardForWhite = (direction & 2) != 0;
+        terms.mobility += countSteps(isForwardForWhite ? whitePieces : whiteKings, empty, direction);
+        terms.mobility -= countSteps(isForwardForWhite ? blackKings : blackPieces, empty, direction);
+    }
+    return terms;
+}
+
+/**
+ * @return Returns the score of a position, from white's point of view.
+ * @param whitePieces The bitboard of the white pieces (kings included)
+ * @param blackPieces The bitboard of the black pieces (kings included)
+ * @param kings The bitboard of the kings of both colors
+ * @param weights The weights of the terms
+ */
+int Evaluator::evaluate(bitboard_t whitePieces, bitboard_t blackPieces, bitboard_t kings, const EvalWeights& weights)
+{
+    EvalTerms terms = getTerms(whitePieces, blackPieces, kings);
+    return weights.man * terms.material + weights.king * terms.kings + weights.backRank * terms.backRank +
+           weights.mobility * terms.mobility + weights.center * terms.center;
+}
+
+#if EVAL_BUILD_AVX2
+
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+
+/**
+ * @return Returns the number of set bits in each 32-bit lane.
+ * (Counts each nibble with a table lookup, then adds the byte counts of each lane)
+ * @param bits The bitboards to count
+ */
+AVX2_FUNCTION static inline __m256i popCount8(__m256i bits)
+{
+    const __m256i nibbleCounts = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                  0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowNibbles = _mm256_set1_epi8(0x0f);
+    __m256i low = _mm256_and_si256(bits, lowNibbles);
+    __m256i high = _mm256_and_si256(_mm256_srli_epi16(bits, 4), lowNibbles);
+    __m256i byteCounts = _mm256_add_epi8(_mm256_shuffle_epi8(nibbleCounts, low), _mm256_shuffle_epi8(nibbleCounts, high));
+
+    // bytes to pairs, then pairs to whole lanes
+    __m256i pairCounts = _mm256_maddubs_epi16(byteCounts, _mm256_set1_epi8(1));
+    return _mm256_madd_epi16(pairCounts, _mm256_set1_epi16(1));
+}
+
+/**
+ * @return Returns the number of single steps from the given squares, in the given direction,
+ * onto empty squares, for each of eight positions.
+ * @param pieces The squares to step from
+ * @param empty The empty squares
+ * @param direction The direction, from 0 to 3
+ */
+AVX2_FUNCTION static inline __m256i countSteps8(__m256i pieces, __m256i empty, int direction)
+{
+    __m256i count = _mm256_setzero_si256();
+    for (int parity = 0; parity < 2; parity++)
+    {
+        int shift = STEP_SHIFTS.shift[direction][parity];
+        __m256i from = _mm256_and_si256(pieces, _mm256_set1_epi32((int)STEP_SHIFTS.from[direction][parity]));
+        __m256i to = shift > 0 ? _mm256_sll_epi32(from, _mm_cvtsi32_si128(shift))
+                               : _mm256_srl_epi32(from, _mm_cvtsi32_si128(-shift));
+        count = _mm256_add_epi32(count, popCount8(_mm256_and_si256(to, empty)));
+    }
+    return count;
+}
+
+/**
+ * Scores positions eight at a time, with the same terms as Evaluator::getTerms.
+ * @param white The white bitboards
+ * @param black The black bitboards
+ * @param kings The king bitboards
+ * @param count The number of positions
+ * @param weights The weights of the terms
+ * @param scores The array to write the scores to
+ * @return Returns the number of positions scored (a multiple of eight; the rest are left to the caller).
+ */
+AVX2_FUNCTION static int evaluateAvx2(const bitboard_t* white, const bitboard_t* black, const bitboard_t* kings,
+                                      int count, const EvalWeights& weights, int* scores)
+{
+    const __m256i allBits = _mm256_set1_epi32(-1);
+    const __m256i whiteBackRow = _mm256_set1_epi32((int)WHITE_BACK_ROW);
+    const __m256i blackBackRow = _mm256_set1_epi32((int)BLACK_BACK_ROW);
+    const __m256i center = _mm256_set1_epi32((int)CENTER_MASK);
+    const __m256i manWeight = _mm256_set1_epi32(weights.man);
+    const __m256i kingWeight = _mm256_set1_epi32(weights.king);
+    const __m256i backRankWeight = _mm256_set1_epi32(weights.backRank);
+    const __m256i mobilityWeight = _mm256_set1_epi32(weights.mobility);
+    const __m256i centerWeight = _mm256_set1_epi32(weights.center);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i whitePieces = _mm256_loadu_si256((const __m256i*)(white + i));
+        __m256i blackPieces = _mm256_loadu_si256((const __m256i*)(black + i));
+        __m256i kingPieces = _mm256_loadu_si256((const __m256i*)(kings + i));
+
+        __m256i whiteKings = _mm256_and_si256(whitePieces, kingPieces);
+        __m256i blackKings = _mm256_and_si256(blackPieces, kingPieces);
+        __m256i whiteMen = _mm256_andnot_si256(kingPieces, whitePieces);
+        __m256i blackMen = _mm256_andnot_si256(kingPieces, blackPieces);
+        __m256i empty = _mm256_xor_si256(_mm256_or_si256(whitePieces, blackPieces), allBits);
+
+        __m256i material = _mm256_sub_epi32(popCount8(whiteMen), popCount8(blackMen));
+        __m256i kingCount = _mm256_sub_epi32(popCount8(whiteKings), popCount8(blackKings));
+        __m256i backRank = _mm256_sub_epi32(popCount8(_mm256_and_si256(whiteMen, whiteBackRow)),
+                                            popCount8(_mm256_and_si256(blackMen, blackBackRow)));
+        __m256i centerCount = _mm256_sub_epi32(popCount8(_mm256_and_si256(whitePieces, center)),
+                                               popCount8(_mm256_and_si256(blackPieces, center)));
+
+        __m256i mobility = _mm256_setzero_si256();
+        for (int direction = 0; direction < 4; direction++)
+        {
+            bool isForwardForWhite = (direction & 2) != 0;
+            mobility = _mm256_add_epi32(mobility, countSteps8(isForwardForWhite ? whitePieces : whiteKings, empty, direction));
+            mobility = _mm256_sub_epi32(mobility, countSteps8(isForwardForWhite ? blackKings : blackPieces, empty, direction));
+        }
+
+        __m256i score = _mm256_mullo_epi32(material, manWeight);
+        score = _mm256_add_epi32(score, _mm256_mullo_epi32(kingCount, kingWeight));
+        score = _mm256_add_epi32(score, _mm256_mullo_epi32(backRank, backRankWeight));
+        score = _mm256_add_epi32(score, _mm256_mullo_epi32(mobility, mobilityWeight));
+        score = _mm256_add_epi32(score, _mm256_mullo_epi32(centerCount, centerWeight));
+        _mm256_storeu_si256((__m256i*)(scores + i), score);
+    }
+    return i;
+}
+
+#endif
+
+/**
+ * Scores every position in a batch. (Gives exactly the scores evaluate() would)
+ * @param batch The positions to score
+ * @param weights The weights of the terms
+ * @param scores The array to write the scores to, batch.size() long, in the batch's order
+ * @param backend How to run, which must be supported here (see isSupported)
+ */
+void Evaluator::evaluateBatch(const PositionBatch& batch, const EvalWeights& weights, int* scores, EvalBackend backend)
+{
+    const bitboard_t* white = batch.getWhitePieces();
+    const bitboard_t* black = batch.getBlackPieces();
+    const bitboard_t* kings = batch.getKings();
+    int count = batch.size();
+
+    int done = 0;
+#if EVAL_BUILD_AVX2
+    if (backend == EVAL_AVX2)
+        done = evaluateAvx2(white, black, kings, count, weights, scores);
+#endif
+
+    // whatever is left over (or everything, without a vector backend) one at a time
+    for (int i = done; i < count; i++)
+        scores[i] = evaluate(white[i], black[i], kings[i], weights);
+}
+
+/**
+ * @return Returns true if this program was built with the given backend and the processor can run it.
+ * @param backend The backend to check
+ */
+bool Evaluator::isSupported(EvalBackend backend)
+{
+    if (backend == EVAL_SCALAR)
+        return true;
+#if EVAL_BUILD_AVX2
+    if (backend == EVAL_AVX2)
+        return __builtin_cpu_supports("avx2");
+#endif
+    return false;
+}
+
+/**
+ * @return Returns the fastest backend this processor supports.
+ */
+EvalBackend Evaluator::getBestBackend()
+{
+    // only asks the processor once
+    static const EvalBackend best = isSupported(EVAL_AVX2) ? EVAL_AVX2 : EVAL_SCALAR;
+    return best;
+}
+
+/**
+ * @return Returns the name of a backend ("scalar" or "avx2").
+ * @param backend The backend
+ */
+const char* Evaluator::getBackendName(EvalBackend backend)
+{
+    return backend == EVAL_AVX2 ? "avx2" : "scalar";
+}
+
+/**
+ * Reads weights from a weights file (see checkers_tune): one "name value" line per term
+ * (man, king, backRank, mobility, center), blank lines and lines starting with '#' skipped.
+ * Terms the file leaves out keep their value.
+ * @param path The file to read
+ * @param weights The weights to set
+ * @return Returns false, leaving weights as they were, if the file can't be read or has a line it doesn't understand.
+ */
+bool Evaluator::readWeights(const std::string& path, EvalWeights& weights)
+{
+    std::ifstream in(path);
+    if (!in)
+        return false;
+
+    EvalWeights read = weights;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string name;
+        if (!(fields >> name) || name[0] == '#')
+            continue;
+
+        int value;
+        std::string rest;
+        if (!(fields >> value) || fields >> rest)
+            return false;
+        bool known = false;
+        for (const auto& weight : WEIGHT_NAMES)
+        {
+            if (name == weight.name)
+            {
+                read.*weight.value = value;
+                known = true;
+            }
+        }
+        if (!known)
+            return false;
+    }
+    weights = read;
+    return true;
+}
+
+/**
+ * Writes weights to a weights file, in the form readWeights reads.
+ * @param path The file to write
+ * @param weights The weights to write
+ * @return Returns true if the file was written.
+ */
+bool Evaluator::writeWeights(const std::string& path, const EvalWeights& weights)
+{
+    std::ofstream out(path, std::ios::trunc);
+    out << "# evaluation weights, in hundredths of a man (see GameLogic/Evaluation.h)\n";
+    for (const auto& weight : WEIGHT_NAMES)
+        out << weight.name << " " << weights.*weight.value << "\n";
+    out.close();
+    return !out.fail();
+}
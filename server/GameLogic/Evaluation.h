@@ -0,0 +1,206 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Typedefs.h"
+#include "Bitboard.h"
+#include "BasicBoard.h"
+
+/**
+ * Static evaluation of 8x8 positions, one at a time or in batches.
+ *
+ * A position is scored from its bitboards alone (see Bitboard.h), as a weighted sum of five
+ * terms, each counted for white minus the same count for black:
+ *  - material: the number of men
+ *  - kings: the number of kings
+ *  - back rank: men still on their own back row, guarding it against crowning
+ *  - mobility: the number of single steps onto empty squares (jumps aren't counted)
+ *  - center: pieces on the middle 4x4 of the board
+ *
+ * Scores are always from white's point of view, so positive is good for white.
+ */
+
+/**
+ * How much each term is worth, in hundredths of a man.
+ */
+struct EvalWeights
+{
+	int man = 100;
+	int king = 130;
+	int backRank = 8;
+	int mobility = 3;
+	int center = 6;
+};
+
+/**
+ * The terms of one position, before weighting (each one white's count minus black's).
+ */
+struct EvalTerms
+{
+	int material;
+	int kings;
+	int backRank;
+	int mobility;
+	int center;
+};
+
+/**
+ * Positions in structure-of-arrays form: the white, black and king bitboards of every position
+ * are each kept in an array of their own, so the batch evaluator can load the same bitboard
+ * of several positions with one instruction.
+ */
+class PositionBatch
+{
+	public:
+		/**
+		 * Adds a position to the end of the batch.
+		 * @param whitePieces The bitboard of the white pieces (kings included)
+		 * @param blackPieces The bitboard of the black pieces (kings included)
+		 * @param kings The bitboard of the kings of both colors
+		 */
+		void add(bitboard_t whitePieces, bitboard_t blackPieces, bitboard_t kings)
+		{
+			white.push_back(whitePieces);
+			black.push_back(blackPieces);
+			this->kings.push_back(kings);
+		}
+
+		/**
+		 * Adds the position on a board (or a Board) to the end of the batch.
+		 * @param board The board holding the position
+		 */
+		void add(const BasicBoard<EnglishRules>& board)
+		{
+			add(board.getPieceMask(true), board.getPieceMask(false), board.getKingMask(true) | board.getKingMask(false));
+		}
+
+		/**
+		 * Removes every position from the batch (keeping the memory for the next one).
+		 */
+		void clear() { white.clear(); black.clear(); kings.clear(); }
+
+		/**
+		 * Makes room for the given number of positions, so adding them doesn't reallocate.
+		 * @param count The number of positions
+		 */
+		void reserve(int count) { white.reserve(count); black.reserve(count); kings.reserve(count); }
+
+		/**
+		 * @return Returns the number of positions in the batch.
+		 */
+		int size() const { return (int)white.size(); }
+
+		// the arrays themselves, each size() long
+		const bitboard_t* getWhitePieces() const { return white.data(); }
+		const bitboard_t* getBlackPieces() const { return black.data(); }
+		const bitboard_t* getKings() const { return kings.data(); }
+
+	private:
+		std::vector<bitboard_t> white;
+		std::vector<bitboard_t> black;
+		std::vector<bitboard_t> kings;
+};
+
+/**
+ * The ways the batch evaluator can run. The best one the processor supports is found
+ * at run time, so the same program runs (more slowly) on processors without AVX2.
+ */
+enum EvalBackend
+{
+	// one position at a time
+	EVAL_SCALAR,
+	// eight positions at a time, one in each 32-bit lane of a 256-bit register
+	EVAL_AVX2
+};
+
+/**
+ * Scores positions with the terms and weights described above.
+ */
+class Evaluator
+{
+	public:
+		/**
+		 * @return Returns the unweighted terms of a position.
+		 * @param whitePieces The bitboard of the white pieces (kings included)
+		 * @param blackPieces The bitboard of the black pieces (kings included)
+		 * @param kings The bitboard of the kings of both colors
+		 */
+		static EvalTerms getTerms(bitboard_t whitePieces, bitboard_t blackPieces, bitboard_t kings);
+
+		/**
+		 * @return Returns the score of a position, from white's point of view.
+		 * @param whitePieces The bitboard of the white pieces (kings included)
+		 * @param blackPieces The bitboard of the black pieces (kings included)
+		 * @param kings The bitboard of the kings of both colors
+		 * @param weights The weights of the terms
+		 */
+		static int evaluate(bitboard_t whitePieces, bitboard_t blackPieces, bitboard_t kings, const EvalWeights& weights);
+
+		/**
+		 * @return Returns the score of the position on a board, from white's point of view.
+		 * @param board The board holding the position
+		 * @param weights The weights of the terms
+		 */
+		static int evaluate(const BasicBoard<EnglishRules>& board, const EvalWeights& weights)
+		{
+			return evaluate(board.getPieceMask(true), board.getPieceMask(false),
+			                board.getKingMask(true) | board.getKingMask(false), weights);
+		}
+
+		/**
+		 * Scores every position in a batch. (Gives exactly the scores evaluate() would)
+		 * @param batch The positions to score
+		 * @param weights The weights of the terms
+		 * @param scores The array to write the scores to, batch.size() long, in the batch's order
+		 * @param backend How to run, which must be supported here (see isSupported)
+		 */
+		static void evaluateBatch(const PositionBatch& batch, const EvalWeights& weights, int* scores, EvalBackend backend);
+
+		/**
+		 * Scores every position in a batch, the fastest way this processor supports.
+		 * @param batch The positions to score
+		 * @param weights The weights of the terms
+		 * @param scores The array to write the scores to, batch.size() long, in the batch's order
+		 */
+		static void evaluateBatch(const PositionBatch& batch, const EvalWeights& weights, int* scores)
+		{ evaluateBatch(batch, weights, scores, getBestBackend()); }
+
+		/**
+		 * Reads weights from a weights file (see checkers_tune): one "name value" line per term
+		 * (man, king, backRank, mobility, center), blank lines and lines starting with '#' skipped.
+		 * Terms the file leaves out keep their value.
+		 * @param path The file to read
+		 * @param weights The weights to set
+		 * @return Returns false, leaving weights as they were, if the file can't be read or has a line it doesn't understand.
+		 */
+		static bool readWeights(const std::string& path, EvalWeights& weights);
+
+		/**
+		 * Writes weights to a weights file, in the form readWeights reads.
+		 * @param path The file to write
+		 * @param weights The weights to write
+		 * @return Returns true if the file was written.
+		 */
+		static bool writeWeights(const std::string& path, const EvalWeights& weights);
+
+		/**
+		 * @return Returns true if this program was built with the given backend and the processor can run it.
+		 * @param backend The backend to check
+		 */
+		static bool isSupported(EvalBackend backend);
+
+		/**
+		 * @return Returns the fastest backend this processor supports.
+		 */
+		static EvalBackend getBestBackend();
+
+		/**
+		 * @return Returns the name of a backend ("scalar" or "avx2").
+		 * @param backend The backend
+		 */
+		static const char* getBackendName(EvalBackend backend);
+};
+
+#endif
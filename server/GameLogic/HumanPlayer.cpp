@@ -183,11 +183,14 @@ Piece *HumanPlayer::getPieceFromUser(const Board &board)
             char letterChar = raw[0];
             char numberChar = raw[1];
 
-            // Validate letter and number ranges
-            if (letterChar < 'a' || letterChar > 'h')
-                throw runtime_error("Please enter a letter between 'a' and 'h'.");
-            if (numberChar < '1' || numberChar > '8')
-                throw runtime_error("Please enter a number between '1' and '8'.");
+            // Validate letter and number ranges (one letter and one digit per coordinate, so at most 9x9)
+            const char lastLetter = (char)('a' + Board::SIZE - 1);
+            const char lastNumber = (char)('0' + Board::SIZE);
+            static_assert(Board::SIZE <= 9, "coordinates are read as one letter and one digit");
+            if (letterChar < 'a' || letterChar > lastLetter)
+                throw runtime_error(std::string("Please enter a letter between 'a' and '") + lastLetter + "'.");
+            if (numberChar < '1' || numberChar > lastNumber)
+                throw runtime_error(std::string("Please enter a number between '1' and '") + lastNumber + "'.");
 
             // Convert characters to 0-based coordinates
             int x = letterChar - 'a';
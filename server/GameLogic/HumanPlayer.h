@@ -27,13 +27,7 @@ class HumanPlayer : public Player
 		 * @param board The board to be displayed
 		 * @param possibleMoves A vector of possible moves to display while printing the board.
 		 */
-		void displayBoard(const Board& board, const moves_t possibleMoves);
-		
-		/**
-		 * Responsible for displaying the game board to the user (WITHOUT possible moves)
-		 * @param board The board to be displayed
-		 */
-		void displayBoard(const Board& board);
+		static void displayBoard(const Board& board, const moves_t possibleMoves);
 		
 		/**
 		 * Asks the user for a piece on the board (for them to move),
@@ -63,6 +57,13 @@ class HumanPlayer : public Player
 		 */
 		HumanPlayer(bool isWhite) : isWhite(isWhite) {};
 		
+		/**
+		 * Responsible for displaying the game board to the user (WITHOUT possible moves)
+		 * (Also used to show the board between computer players' moves)
+		 * @param board The board to be displayed
+		 */
+		static void displayBoard(const Board& board);
+		
 		/**
 		 * Gets a move, by asking the human player what move they want to do.
 		 * @param board The board to apply the move to (assumed to be oriented so that this player is on the top)
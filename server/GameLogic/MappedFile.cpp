@@ -0,0 +1,98 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : data(nullptr), size(0)
+{
+#if defined(_WIN32)
+    file = INVALID_HANDLE_VALUE;
+    mapping = nullptr;
+#endif
+}
+
+/**
+ * Responsible for unmapping the file.
+ */
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+/**
+ * Maps a file (unmapping any mapped before).
+ * @param path The file
+ * @return Returns true if the file was mapped. (An empty file can't be)
+ */
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+#if defined(_WIN32)
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER length;
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &length) || length.QuadPart == 0)
+    {
+        close();
+        return false;
+    }
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (view == nullptr)
+    {
+        close();
+        return false;
+    }
+    data = (const unsigned char*)view;
+    size = (std::size_t)length.QuadPart;
+#else
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return false;
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 || status.st_size == 0)
+    {
+        ::close(descriptor);
+        return false;
+    }
+    void* view = mmap(nullptr, (std::size_t)status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+    // (the mapping keeps the file open by itself)
+    ::close(descriptor);
+    if (view == MAP_FAILED)
+        return false;
+    data = (const unsigned char*)view;
+    size = (std::size_t)status.st_size;
+#endif
+    return true;
+}
+
+/**
+ * Unmaps the file, if one is mapped.
+ */
+void MappedFile::close()
+{
+#if defined(_WIN32)
+    if (data != nullptr)
+        UnmapViewOfFile(data);
+    if (mapping != nullptr)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+    file = INVALID_HANDLE_VALUE;
+    mapping = nullptr;
+#else
+    if (data != nullptr)
+        munmap((void*)data, size);
+#endif
+    data = nullptr;
+    size = 0;
+}
@@ -0,0 +1,84 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * A file mapped read-only into memory, so its bytes can be read in place: nothing is loaded
+ * until it is looked at, and the operating system shares the pages between every process that
+ * maps the same file. The engine's data files (see EndgameDatabase.h and OpeningBook.h) are
+ * read this way, with their numbers stored little-endian (see readLittleEndian).
+ */
+class MappedFile
+{
+	public:
+		MappedFile();
+
+		/**
+		 * Responsible for unmapping the file.
+		 */
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/**
+		 * Maps a file (unmapping any mapped before).
+		 * @param path The file
+		 * @return Returns true if the file was mapped. (An empty file can't be)
+		 */
+		bool open(const std::string& path);
+
+		/**
+		 * Unmaps the file, if one is mapped.
+		 */
+		void close();
+
+		/**
+		 * @return Returns the file's bytes, or null if no file is mapped.
+		 */
+		const unsigned char* getData() const { return data; }
+
+		/**
+		 * @return Returns the length of the file, in bytes.
+		 */
+		std::size_t getSize() const { return size; }
+
+	private:
+		const unsigned char* data;
+		std::size_t size;
+#if defined(_WIN32)
+		// the file's and the mapping's HANDLEs
+		void* file;
+		void* mapping;
+#endif
+};
+
+/**
+ * @return Returns a little-endian number.
+ * @param bytes Where it is stored
+ * @param count How many bytes it takes (up to 8)
+ */
+inline std::uint64_t readLittleEndian(const unsigned char* bytes, int count)
+{
+	std::uint64_t value = 0;
+	for (int i = 0; i < count; i++)
+		value |= (std::uint64_t)bytes[i] << (8 * i);
+	return value;
+}
+
+/**
+ * Stores a number little-endian.
+ * @param bytes Where to store it
+ * @param value The number
+ * @param count How many bytes it takes (up to 8)
+ */
+inline void writeLittleEndian(unsigned char* bytes, std::uint64_t value, int count)
+{
+	for (int i = 0; i < count; i++)
+		bytes[i] = (unsigned char)(value >> (8 * i));
+}
+
+#endif
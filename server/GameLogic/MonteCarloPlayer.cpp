@@ -0,0 +1,56 @@
+#include "MonteCarloPlayer.h"
+
+#include "Board.h"
+#include "Trace.h"
+
+#include <iomanip>
+#include <sstream>
+
+// forward declare utilities in main.cpp
+void announce(const std::string& message);
+
+/**
+ * @return Returns the name of a square as the human player types it, e.g. "C3".
+ * @param square The playable square
+ */
+static std::string getSquareName(int square)
+{
+    coords_t coords = Board::getCoordsFromSquare(square);
+    return std::string(1, (char)('A' + coords[0])) + std::to_string(coords[1] + 1);
+}
+
+/**
+ * Gets a move, by searching for the best one, and applies it to the board.
+ * @param board The board to apply the move to
+ */
+void MonteCarloPlayer::getMove(Board& board)
+{
+    // search the position as this player sees it (it is always this player's turn when asked for a move)
+    BasicBoard<EnglishRules> position(board.getPieceMask(true), board.getPieceMask(false),
+                                      board.getKingMask(true) | board.getKingMask(false), isWhite);
+
+    MonteCarloResult result = search.run(position, limits);
+    if (!result.hasMove)
+    {
+        announce(getColor() + " (computer) has no moves.");
+        return;
+    }
+
+    // play it on the real board, so its pieces move too
+    board.makeMove(result.bestMove);
+
+    std::ostringstream message;
+    message << getColor() << " (computer) moved " << getSquareName(result.bestMove.getFrom()) << " to "
+            << getSquareName(result.bestMove.getTo()) << " (" << result.playouts << " playouts, " << std::fixed
+            << std::setprecision(0) << result.winRate * 100 << "% wins, " << std::setprecision(3) << result.seconds << " s)";
+    announce(message.str());
+    TRACE_DEBUG(message.str() << ", " << result.reusedVisits << " visits reused, " << result.treeNodes << " nodes in the tree");
+}
+
+/**
+ * @return Returns a titlecase string representing this player's color
+ */
+std::string MonteCarloPlayer::getColor() const
+{
+    return isWhite ? "White" : "Black";
+}
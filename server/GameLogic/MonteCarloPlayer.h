@@ -0,0 +1,52 @@
+#ifndef MONTE_CARLO_PLAYER_H
+#define MONTE_CARLO_PLAYER_H
+
+#include "Player.h"
+#include "Typedefs.h"
+#include "MonteCarloSearch.h"
+
+#include <cstddef>
+#include <random>
+#include <string>
+
+class Board;
+
+/**
+ * A computer player which picks its moves with a Monte Carlo tree search (see
+ * MonteCarloSearch.h), limited to a number of playouts or a time per move, run on one or more
+ * threads. The tree is kept from move to move: the part of it under the move played and the
+ * reply is where the next search starts.
+ */
+class MonteCarloPlayer : public Player
+{
+    private:
+	    const bool isWhite;
+	    MonteCarloLimits limits;
+	    MonteCarloSearch search;
+
+		/**
+		 * @return Returns a titlecase string representing this player's color
+		 */
+		std::string getColor() const;
+
+	public:
+		/**
+		 * Constructor for the MonteCarloPlayer
+		 * @param isWhite Used to specify if this player is black or white.
+		 * @param limits How many playouts, or how long, to search for each move
+		 * @param treeMegabytes The size of each of the search's node arenas, in megabytes
+		 * @param threads How many threads to run playouts on
+		 * @param weights The weights of the static evaluation the playouts are scored with
+		 */
+		MonteCarloPlayer(bool isWhite, const MonteCarloLimits& limits, std::size_t treeMegabytes = 32, int threads = 1,
+		                 const EvalWeights& weights = EvalWeights())
+			: isWhite(isWhite), limits(limits), search(treeMegabytes, threads, weights, std::random_device()()) {};
+
+		/**
+		 * Gets a move, by searching for the best one, and applies it to the board.
+		 * @param board The board to apply the move to
+		 */
+		virtual void getMove(Board& board);
+};
+
+#endif
@@ -0,0 +1,406 @@
+#include "MonteCarloSearch.h"
+
+#include "MoveList.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @return Returns the next number of a xorshift64* sequence (fast, and good enough for picking playout moves).
+ * @param state The sequence's state (never 0)
+ */
+static inline std::uint64_t nextRandom(std::uint64_t& state)
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * Constructor for a searcher, starting its worker threads.
+ * @param megabytes The size of the node arena (there are two, for reusing the tree), in megabytes
+ * @param threads How many threads run playouts, counting the calling thread
+ * @param weights The weights of the static evaluation the playouts are scored with
+ * @param seed The seed for the playouts' random moves
+ */
+MonteCarloSearch::MonteCarloSearch(std::size_t megabytes, int threads, const EvalWeights& weights, std::uint64_t seed)
+    : weights(weights), seed(seed), nextFree(0), hasTree(false), playouts(0), stopRequested(false), finished(false),
+      shuttingDown(false), runningWorkers(0), generation(0)
+{
+    std::size_t nodes = megabytes * 1024 * 1024 / sizeof(MonteCarloNode);
+    capacity = (std::uint32_t)std::max<std::size_t>(16, std::min<std::size_t>(nodes, UINT32_MAX / 2));
+    arena.reset(new MonteCarloNode[capacity]);
+    spareArena.reset(new MonteCarloNode[capacity]);
+
+    for (int i = 1; i < threads; i++)
+        workers.emplace_back([this, i] { workerLoop(i); });
+}
+
+/**
+ * Responsible for stopping and joining the worker threads.
+ */
+MonteCarloSearch::~MonteCarloSearch()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shuttingDown = true;
+    }
+    finished = true;
+    wakeWorkers.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+/**
+ * Searches for the best move of the side to move, reusing the tree if it has already reached the position.
+ * @param board The position to search
+ * @param searchLimits How many playouts, or how long, to search
+ * @return Returns the most visited move, with how well it did.
+ */
+MonteCarloResult MonteCarloSearch::run(const BasicBoard<EnglishRules>& board, const MonteCarloLimits& searchLimits)
+{
+    startTime = std::chrono::steady_clock::now();
+    MonteCarloResult result;
+    result.reusedVisits = moveRoot(board);
+
+    MonteCarloNode& root = arena[0];
+    expand(root, rootBoard);
+    if (root.state.load(std::memory_order_acquire) != NODE_EXPANDED || root.childCount.load() == 0)
+        return result;
+    result.hasMove = true;
+
+    // with only one legal move there is nothing to decide
+    if (root.childCount.load() > 1)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            limits = searchLimits;
+            playouts = 0;
+            stopRequested = false;
+            finished = false;
+            runningWorkers = (int)workers.size();
+            generation++;
+        }
+        wakeWorkers.notify_all();
+
+        runPlayouts(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        workersFinished.wait(lock, [this] { return runningWorkers == 0; });
+        result.playouts = playouts;
+    }
+
+    // the most visited move is the one the playouts trust most
+    std::uint32_t first = root.firstChild.load();
+    std::uint32_t best = first;
+    for (std::uint32_t i = first; i < first + root.childCount.load(); i++)
+    {
+        if (arena[i].visits.load() > arena[best].visits.load())
+            best = i;
+    }
+    std::uint32_t bestVisits = arena[best].visits.load();
+    result.bestMove = arena[best].move;
+    result.winRate = bestVisits > 0 ? arena[best].points.load() / (2.0 * bestVisits) : 0.5;
+    result.treeNodes = std::min(nextFree.load(), capacity);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return result;
+}
+
+/**
+ * Forgets the tree, so the next search starts from scratch.
+ */
+void MonteCarloSearch::clear()
+{
+    hasTree = false;
+}
+
+/**
+ * Makes the root of the tree the given position: the node the old tree has for it, if
+ * it is within two plies of the old root, or else a new tree.
+ * @param board The position
+ * @return Returns the visits the root already had.
+ */
+std::uint64_t MonteCarloSearch::moveRoot(const BasicBoard<EnglishRules>& board)
+{
+    if (hasTree && rootBoard.getHash() == board.getHash())
+        return arena[0].visits.load();
+
+    // look for the position after the move played from the old root and the reply to it
+    if (hasTree && arena[0].state.load() == NODE_EXPANDED)
+    {
+        const MonteCarloNode& oldRoot = arena[0];
+        for (std::uint32_t i = oldRoot.firstChild; i < oldRoot.firstChild + oldRoot.childCount; i++)
+        {
+            BasicBoard<EnglishRules> child = rootBoard;
+            child.makeMove(arena[i].move);
+            std::uint32_t found = child.getHash() == board.getHash() ? i : 0;
+            if (found == 0 && arena[i].state.load() == NODE_EXPANDED)
+            {
+                for (std::uint32_t j = arena[i].firstChild; j < arena[i].firstChild + arena[i].childCount && found == 0; j++)
+                {
+                    BasicBoard<EnglishRules> grandchild = child;
+                    grandchild.makeMove(arena[j].move);
+                    if (grandchild.getHash() == board.getHash())
+                        found = j;
+                }
+            }
+            if (found != 0)
+            {
+                keepSubtree(found);
+                rootBoard = board;
+                return arena[0].visits.load();
+            }
+        }
+    }
+
+    resetNode(arena[0], CompactMove());
+    nextFree = 1;
+    rootBoard = board;
+    hasTree = true;
+    return 0;
+}
+
+/**
+ * Copies a subtree to the front of the spare arena, and swaps the arenas.
+ * @param index The node at the top of the subtree
+ */
+void MonteCarloSearch::keepSubtree(std::uint32_t index)
+{
+    const MonteCarloNode* from = arena.get();
+    MonteCarloNode* to = spareArena.get();
+
+    // breadth first, straight in the new arena: each copied node still holds where its children
+    // are in the old arena until its own children are copied after everything copied so far
+    auto copyNode = [](MonteCarloNode& copy, const MonteCarloNode& node) {
+        copy.move = node.move;
+        copy.visits.store(node.visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        copy.points.store(node.points.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        copy.firstChild.store(node.firstChild.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        copy.childCount.store(node.childCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        copy.state.store(node.state.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    };
+    copyNode(to[0], from[index]);
+    std::uint32_t used = 1;
+    for (std::uint32_t i = 0; i < used; i++)
+    {
+        MonteCarloNode& node = to[i];
+        if (node.state.load(std::memory_order_relaxed) != NODE_EXPANDED)
+        {
+            // (a node left unexpanded when the arena filled up may be expanded now)
+            node.state.store(NODE_LEAF, std::memory_order_relaxed);
+            continue;
+        }
+        std::uint32_t oldFirst = node.firstChild.load(std::memory_order_relaxed);
+        std::uint16_t count = node.childCount.load(std::memory_order_relaxed);
+        node.firstChild.store(used, std::memory_order_relaxed);
+        for (std::uint16_t c = 0; c < count; c++)
+            copyNode(to[used + c], from[oldFirst + c]);
+        used += count;
+    }
+
+    std::swap(arena, spareArena);
+    nextFree = used;
+}
+
+/**
+ * Initializes a node as an unexpanded leaf.
+ * @param node The node
+ * @param move The move that leads to it
+ */
+void MonteCarloSearch::resetNode(MonteCarloNode& node, const CompactMove& move)
+{
+    node.move = move;
+    node.visits.store(0, std::memory_order_relaxed);
+    node.points.store(0, std::memory_order_relaxed);
+    node.firstChild.store(0, std::memory_order_relaxed);
+    node.childCount.store(0, std::memory_order_relaxed);
+    node.state.store(NODE_LEAF, std::memory_order_relaxed);
+}
+
+/**
+ * Adds a node's children (one per legal move) to the tree, unless another thread is already doing it.
+ * @param node The node
+ * @param board Its position
+ */
+void MonteCarloSearch::expand(MonteCarloNode& node, const BasicBoard<EnglishRules>& board)
+{
+    std::uint8_t expected = NODE_LEAF;
+    if (!node.state.compare_exchange_strong(expected, NODE_EXPANDING, std::memory_order_acq_rel))
+        return;
+
+    MoveList moves;
+    board.getAllLegalMoves(board.isWhiteToMove(), moves);
+    std::uint32_t count = (std::uint32_t)moves.size();
+    std::uint32_t first = count > 0 ? nextFree.fetch_add(count, std::memory_order_relaxed) : 0;
+
+    // once the arena is full the node just stays a leaf (marked as being expanded, so nobody tries again)
+    if (count > 0 && (first >= capacity || capacity - first < count))
+        return;
+
+    for (std::uint32_t i = 0; i < count; i++)
+        resetNode(arena[first + i], moves[(int)i]);
+    node.firstChild.store(first, std::memory_order_relaxed);
+    node.childCount.store((std::uint16_t)count, std::memory_order_relaxed);
+    // publishes the children (and the fields above) to the threads that see the node expanded
+    node.state.store(NODE_EXPANDED, std::memory_order_release);
+}
+
+/**
+ * @return Returns the index of the child to walk down to, by upper confidence bound.
+ * @param node An expanded node with children
+ * @param random The thread's random state (for breaking ties between unvisited children)
+ */
+std::uint32_t MonteCarloSearch::selectChild(const MonteCarloNode& node, std::uint64_t& random) const
+{
+    std::uint32_t first = node.firstChild.load(std::memory_order_relaxed);
+    std::uint32_t count = node.childCount.load(std::memory_order_relaxed);
+    double logVisits = std::log((double)std::max<std::uint32_t>(1, node.visits.load(std::memory_order_relaxed)));
+    double exploration = EXPLORATION / 100.0;
+
+    // starting at a random child, so threads that find several unvisited ones take different ones
+    std::uint32_t offset = (std::uint32_t)(nextRandom(random) % count);
+    std::uint32_t best = first + offset;
+    double bestBound = -1;
+    for (std::uint32_t k = 0; k < count; k++)
+    {
+        std::uint32_t i = first + (offset + k) % count;
+        std::uint32_t visits = arena[i].visits.load(std::memory_order_relaxed);
+        if (visits == 0)
+            return i;
+
+        // visits still under way count as losses until they finish (the virtual loss)
+        double mean = arena[i].points.load(std::memory_order_relaxed) / (2.0 * visits);
+        double bound = mean + exploration * std::sqrt(logVisits / visits);
+        if (bound > bestBound)
+        {
+            bestBound = bound;
+            best = i;
+        }
+    }
+    return best;
+}
+
+/**
+ * Runs one playout: down the tree, expanding the leaf it ends at, then random moves.
+ * @param random The thread's random state
+ */
+void MonteCarloSearch::playout(std::uint64_t& random)
+{
+    BasicBoard<EnglishRules> board = rootBoard;
+    std::uint32_t path[MAX_TREE_DEPTH + 2];
+    // whether white played the move into each node on the path
+    bool whiteMoved[MAX_TREE_DEPTH + 2];
+    int length = 0;
+
+    MonteCarloNode* node = &arena[0];
+    node->visits.fetch_add(1, std::memory_order_relaxed);
+    path[length++] = 0;
+    for (int step = 0; step < 2; step++)
+    {
+        // walk down while the tree goes
+        while (length <= MAX_TREE_DEPTH && node->state.load(std::memory_order_acquire) == NODE_EXPANDED &&
+               node->childCount.load(std::memory_order_relaxed) > 0)
+        {
+            std::uint32_t index = selectChild(*node, random);
+            whiteMoved[length] = board.isWhiteToMove();
+            board.makeMove(arena[index].move);
+            node = &arena[index];
+            node->visits.fetch_add(1, std::memory_order_relaxed);
+            path[length++] = index;
+        }
+
+        // a leaf that has been reached before is worth growing the tree by (and then one more step into it)
+        if (step == 0 && length <= MAX_TREE_DEPTH && node->state.load(std::memory_order_relaxed) == NODE_LEAF &&
+            node->visits.load(std::memory_order_relaxed) > 1)
+            expand(*node, board);
+        else
+            break;
+    }
+
+    // a node with no moves is lost for the side to move; anything else is played out
+    int whitePoints;
+    if (node->state.load(std::memory_order_acquire) == NODE_EXPANDED && node->childCount.load(std::memory_order_relaxed) == 0)
+        whitePoints = board.isWhiteToMove() ? 0 : 2;
+    else
+        whitePoints = simulate(board, random);
+
+    // (the root's points are never looked at, only its visits)
+    for (int i = 1; i < length; i++)
+        arena[path[i]].points.fetch_add(whiteMoved[i] ? whitePoints : 2 - whitePoints, std::memory_order_relaxed);
+}
+
+/**
+ * Plays random moves from a position for up to PLAYOUT_PLIES plies.
+ * @param board The position (which is changed)
+ * @param random The thread's random state
+ * @return Returns how it ended for white, in half points (2 won, 1 drawn, 0 lost).
+ */
+int MonteCarloSearch::simulate(BasicBoard<EnglishRules>& board, std::uint64_t& random) const
+{
+    for (int ply = 0; ply < PLAYOUT_PLIES; ply++)
+    {
+        MoveList moves;
+        board.getAllLegalMoves(board.isWhiteToMove(), moves);
+        if (moves.empty())
+            return board.isWhiteToMove() ? 0 : 2;
+        board.makeMove(moves[(int)(nextRandom(random) % moves.size())]);
+    }
+
+    // not over yet: a clear lead counts as a win, anything closer as a draw
+    int score = Evaluator::evaluate(board, weights);
+    return score >= PLAYOUT_WIN_MARGIN ? 2 : score <= -PLAYOUT_WIN_MARGIN ? 0 : 1;
+}
+
+/**
+ * Runs playouts until the search's budget is used up.
+ * @param threadIndex Which thread this is (0 for the calling thread), for its random seed
+ */
+void MonteCarloSearch::runPlayouts(int threadIndex)
+{
+    // every thread, and every search, plays its own random moves
+    std::uint64_t random = (seed ^ (generation * 0x9E3779B97F4A7C15ULL)) + (std::uint64_t)(threadIndex + 1) * 0xBF58476D1CE4E5B9ULL;
+    if (random == 0)
+        random = 1;
+
+    int sinceCheck = 0;
+    while (!finished.load(std::memory_order_relaxed))
+    {
+        playout(random);
+        std::uint64_t done = playouts.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (limits.maxPlayouts > 0 && done >= limits.maxPlayouts)
+            finished = true;
+
+        if (++sinceCheck >= CHECK_INTERVAL)
+        {
+            sinceCheck = 0;
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+            if (stopRequested || (limits.maxMilliseconds > 0 && elapsed.count() >= limits.maxMilliseconds))
+                finished = true;
+        }
+    }
+}
+
+/**
+ * Runs one worker thread: waits for a search, runs playouts in it, and waits again until shut down.
+ * @param threadIndex Which worker this is (from 1)
+ */
+void MonteCarloSearch::workerLoop(int threadIndex)
+{
+    std::uint64_t searched = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wakeWorkers.wait(lock, [this, searched] { return shuttingDown || generation != searched; });
+        if (shuttingDown)
+            return;
+        searched = generation;
+
+        lock.unlock();
+        runPlayouts(threadIndex);
+        lock.lock();
+
+        if (--runningWorkers == 0)
+            workersFinished.notify_all();
+    }
+}
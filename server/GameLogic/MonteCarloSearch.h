@@ -0,0 +1,248 @@
+#ifndef MONTE_CARLO_SEARCH_H
+#define MONTE_CARLO_SEARCH_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Typedefs.h"
+#include "BasicBoard.h"
+#include "CompactMove.h"
+#include "Evaluation.h"
+
+/**
+ * How much a Monte Carlo search may do: it runs playouts until it has run maxPlayouts of them
+ * or maxMilliseconds have passed, whichever comes first (at least one must be set).
+ */
+struct MonteCarloLimits
+{
+	// stop after this many playouts, counting every thread's (0 for no limit)
+	std::uint64_t maxPlayouts = 0;
+	// stop after about this many milliseconds (0 for no limit)
+	int maxMilliseconds = 0;
+};
+
+/**
+ * What a Monte Carlo search found.
+ */
+struct MonteCarloResult
+{
+	// false only if the side to move has no legal moves (and so has lost)
+	bool hasMove = false;
+	// the root's most visited move
+	CompactMove bestMove;
+	// how often the playouts through bestMove went the side to move's way (a win counting 1, a
+	// draw 1/2), from 0 to 1
+	double winRate = 0;
+	// the playouts this search ran, and the visits the tree already had from earlier searches
+	std::uint64_t playouts = 0;
+	std::uint64_t reusedVisits = 0;
+	// the nodes in the tree when the search ended
+	std::uint64_t treeNodes = 0;
+	double seconds = 0;
+};
+
+/**
+ * A node of the search tree: the move that leads to it, and what the playouts through it
+ * found. Every field can be read and updated by any number of search threads at once.
+ */
+struct MonteCarloNode
+{
+	// the move from the parent to this node
+	CompactMove move;
+	// the playouts through the node, counting the ones still under way (see MonteCarloSearch)
+	std::atomic<std::uint32_t> visits;
+	// the half points the finished ones scored for the side that played move (2 a win, 1 a draw)
+	std::atomic<std::uint32_t> points;
+	// where the node's children start in the arena, and how many there are (once expanded)
+	std::atomic<std::uint32_t> firstChild;
+	std::atomic<std::uint16_t> childCount;
+	// one of MonteCarloSearch's NODE_ constants
+	std::atomic<std::uint8_t> state;
+};
+
+/**
+ * A Monte Carlo tree search for the 8x8 game (UCT): each playout walks down the tree picking
+ * the child with the best upper confidence bound, adds a node's children to the tree once it
+ * is reached, and plays random moves from there for a while, scoring where it ends up with the
+ * static evaluator (see Evaluation.h). It plays less precisely than the alpha-beta search, but
+ * more like a person: it prefers moves that keep winning chances, not just the ones a deep
+ * search can prove.
+ *
+ * Several threads run playouts in the same tree at once, without locks. A playout counts its
+ * visit to every node on its way down at once, and its result only once it has one, so until
+ * then the node looks like it lost that playout (a "virtual loss") and other threads are
+ * steered to other branches rather than all piling into the same one.
+ *
+ * Nodes live in one preallocated arena, with each node's children side by side in it, so
+ * growing the tree takes no allocation at all, just an atomic add. When the next search starts
+ * from a position the tree has already reached (the move played and the reply to it), that
+ * subtree is copied to the front of a second arena and the two are swapped, so everything the
+ * playouts learned about it is kept. If the arena fills up, the tree stops growing and the
+ * playouts go on from its leaves.
+ *
+ * The worker threads are started once, when this is made, and wait between searches; the
+ * calling thread runs playouts too. A MonteCarloSearch runs one search at a time.
+ */
+class MonteCarloSearch
+{
+	public:
+		/**
+		 * Constructor for a searcher, starting its worker threads.
+		 * @param megabytes The size of the node arena (there are two, for reusing the tree), in megabytes
+		 * @param threads How many threads run playouts, counting the calling thread
+		 * @param weights The weights of the static evaluation the playouts are scored with
+		 * @param seed The seed for the playouts' random moves
+		 */
+		MonteCarloSearch(std::size_t megabytes = 32, int threads = 1, const EvalWeights& weights = EvalWeights(),
+		                 std::uint64_t seed = 1);
+
+		/**
+		 * Responsible for stopping and joining the worker threads.
+		 */
+		~MonteCarloSearch();
+
+		MonteCarloSearch(const MonteCarloSearch&) = delete;
+		MonteCarloSearch& operator=(const MonteCarloSearch&) = delete;
+
+		/**
+		 * Searches for the best move of the side to move, reusing the tree if it has already
+		 * reached the position.
+		 * @param board The position to search
+		 * @param limits How many playouts, or how long, to search
+		 * @return Returns the most visited move, with how well it did.
+		 */
+		MonteCarloResult run(const BasicBoard<EnglishRules>& board, const MonteCarloLimits& limits);
+
+		/**
+		 * Forgets the tree, so the next search starts from scratch.
+		 */
+		void clear();
+
+		/**
+		 * Asks a running search to stop as soon as it can (it still returns the best move it has).
+		 * Safe to call from another thread.
+		 */
+		void stop() { stopRequested = true; }
+
+		/**
+		 * @return Returns how many threads run playouts, counting the calling thread.
+		 */
+		int getThreads() const { return (int)workers.size() + 1; }
+
+	private:
+		// a node's state: not yet expanded, being expanded by a thread, or expanded
+		const static std::uint8_t NODE_LEAF = 0;
+		const static std::uint8_t NODE_EXPANDING = 1;
+		const static std::uint8_t NODE_EXPANDED = 2;
+
+		// how many plies a playout plays at most before it is scored by the evaluator
+		const static int PLAYOUT_PLIES = 48;
+		// how far ahead a playout that stops must be to count as a win, in hundredths of a man
+		const static int PLAYOUT_WIN_MARGIN = 100;
+		// the weight of exploring in the upper confidence bound, in hundredths
+		const static int EXPLORATION = 100;
+		// the deepest a playout can walk down the tree
+		const static int MAX_TREE_DEPTH = 256;
+		// how many playouts a thread runs between looks at the clock
+		const static int CHECK_INTERVAL = 16;
+
+		EvalWeights weights;
+		std::uint64_t seed;
+
+		// the arena the tree is in, and the one it is copied into when it is reused
+		std::unique_ptr<MonteCarloNode[]> arena;
+		std::unique_ptr<MonteCarloNode[]> spareArena;
+		std::uint32_t capacity;
+		// the first free node in the arena
+		std::atomic<std::uint32_t> nextFree;
+		// the position at the root of the tree (node 0), if there is a tree
+		BasicBoard<EnglishRules> rootBoard;
+		bool hasTree;
+
+		// the search being run
+		MonteCarloLimits limits;
+		std::chrono::steady_clock::time_point startTime;
+		std::atomic<std::uint64_t> playouts;
+		std::atomic<bool> stopRequested;
+		// set once the budget is used up (or stop was called), for every thread to see
+		std::atomic<bool> finished;
+
+		// the worker threads, and what they wait on between searches
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wakeWorkers;
+		std::condition_variable workersFinished;
+		bool shuttingDown;
+		int runningWorkers;
+		// counts searches, so a worker knows when there is a new one
+		std::uint64_t generation;
+
+		/**
+		 * Makes the root of the tree the given position: the node the old tree has for it, if
+		 * it is within two plies of the old root, or else a new tree.
+		 * @param board The position
+		 * @return Returns the visits the root already had.
+		 */
+		std::uint64_t moveRoot(const BasicBoard<EnglishRules>& board);
+
+		/**
+		 * Copies a subtree to the front of the spare arena, and swaps the arenas.
+		 * @param index The node at the top of the subtree
+		 */
+		void keepSubtree(std::uint32_t index);
+
+		/**
+		 * Initializes a node as an unexpanded leaf.
+		 * @param node The node
+		 * @param move The move that leads to it
+		 */
+		static void resetNode(MonteCarloNode& node, const CompactMove& move);
+
+		/**
+		 * Adds a node's children (one per legal move) to the tree, unless another thread is already doing it.
+		 * @param node The node
+		 * @param board Its position
+		 */
+		void expand(MonteCarloNode& node, const BasicBoard<EnglishRules>& board);
+
+		/**
+		 * @return Returns the index of the child to walk down to, by upper confidence bound.
+		 * @param node An expanded node with children
+		 * @param random The thread's random state (for breaking ties between unvisited children)
+		 */
+		std::uint32_t selectChild(const MonteCarloNode& node, std::uint64_t& random) const;
+
+		/**
+		 * Runs one playout: down the tree, expanding the leaf it ends at, then random moves.
+		 * @param random The thread's random state
+		 */
+		void playout(std::uint64_t& random);
+
+		/**
+		 * Plays random moves from a position for up to PLAYOUT_PLIES plies.
+		 * @param board The position (which is changed)
+		 * @param random The thread's random state
+		 * @return Returns how it ended for white, in half points (2 won, 1 drawn, 0 lost).
+		 */
+		int simulate(BasicBoard<EnglishRules>& board, std::uint64_t& random) const;
+
+		/**
+		 * Runs playouts until the search's budget is used up.
+		 * @param threadIndex Which thread this is (0 for the calling thread), for its random seed
+		 */
+		void runPlayouts(int threadIndex);
+
+		/**
+		 * Runs one worker thread: waits for a search, runs playouts in it, and waits again until shut down.
+		 * @param threadIndex Which worker this is (from 1)
+		 */
+		void workerLoop(int threadIndex);
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef MOVE_LIST_H
+#define MOVE_LIST_H
+
+#include <cassert>
+#include "CompactMove.h"
+#include "WideMove.h"
+
+/**
+ * A fixed-capacity list of moves, meant to be kept on the stack by move generators
+ * so that generating moves never touches the heap.
+ * (MoveType is CompactMove on the 8x8 board, or the move type of a board's rules, see Rules.h)
+ */
+template <class MoveType>
+class BasicMoveList
+{
+	public:
+		// more than the moves a whole side can have on an 8x8 board, and than it has
+		// in any real 10x10 game (generators stop adding moves once this is reached)
+		const static int CAPACITY = 256;
+
+		BasicMoveList() : count(0) {};
+
+		/**
+		 * Adds a move to the end of the list (the list must not be full)
+		 * @param move The move to add
+		 */
+		void push_back(const MoveType& move)
+		{
+			assert(count < CAPACITY);
+			moves[count++] = move;
+		}
+
+		/**
+		 * Removes all moves from the list.
+		 */
+		void clear() { count = 0; }
+
+		int size() const { return count; }
+		bool empty() const { return count == 0; }
+		bool full() const { return count == CAPACITY; }
+
+		const MoveType& operator[](int index) const { return moves[index]; }
+
+		const MoveType* begin() const { return moves; }
+		const MoveType* end() const { return moves + count; }
+
+	private:
+		MoveType moves[CAPACITY];
+		int count;
+};
+
+typedef BasicMoveList<CompactMove> MoveList;
+
+#endif
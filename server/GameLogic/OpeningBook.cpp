@@ -0,0 +1,186 @@
+#include "OpeningBook.h"
+
+#include "MoveList.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <fstream>
+
+// A book file starts with the magic bytes below and then the number of entries (64 bits),
+// followed by the entries, each (all numbers little-endian):
+//   0  the position key (64 bits)
+//   8  the move's from and to squares (a byte each)
+//  10  the weight (16 bits)
+//  12  the wins, draws and losses (32 bits each)
+static const char FILE_MAGIC[8] = {'C', 'K', 'B', 'O', 'O', 'K', '0', '1'};
+static const int FILE_HEADER_SIZE = 16;
+
+OpeningBook::OpeningBook() : entries(nullptr), size(0)
+{
+}
+
+/**
+ * Maps a book file (closing any opened before).
+ * @param path The file checkers_bookbuild wrote
+ * @return Returns true if the file was a book.
+ */
+bool OpeningBook::open(const std::string& path)
+{
+    entries = nullptr;
+    size = 0;
+    if (!file.open(path))
+        return false;
+
+    const unsigned char* data = file.getData();
+    std::uint64_t count = file.getSize() >= (std::size_t)FILE_HEADER_SIZE ? readLittleEndian(data + 8, 8) : 0;
+    if (file.getSize() < (std::size_t)FILE_HEADER_SIZE || !std::equal(FILE_MAGIC, FILE_MAGIC + 8, (const char*)data) ||
+        count != (file.getSize() - FILE_HEADER_SIZE) / ENTRY_SIZE || (file.getSize() - FILE_HEADER_SIZE) % ENTRY_SIZE != 0)
+    {
+        TRACE_ERROR("Not an opening book: " << path);
+        file.close();
+        return false;
+    }
+
+    entries = data + FILE_HEADER_SIZE;
+    size = count;
+    TRACE_INFO("Opening book: " << size << " moves in " << path);
+    return true;
+}
+
+/**
+ * Looks up the moves the book has for a position.
+ * @param key The position (see BasicBoard::getHash)
+ * @param found The array to write the moves to
+ * @param capacity The most moves it can hold
+ * @return Returns the number of moves written.
+ */
+int OpeningBook::probe(hashkey_t key, BookEntry* found, int capacity) const
+{
+    // the first entry with this key or a greater one
+    std::uint64_t low = 0, high = size;
+    while (low < high)
+    {
+        std::uint64_t middle = low + (high - low) / 2;
+        if (getKey(middle) < key)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    int count = 0;
+    for (std::uint64_t i = low; i < size && count < capacity && getKey(i) == key; i++)
+        found[count++] = getEntry(i);
+    return count;
+}
+
+/**
+ * Picks one of the book's moves for a position, at random in proportion to their weights.
+ * @param board The position
+ * @param random A random number, which picks the move
+ * @param move Set to the move, if there is one
+ * @param entry Set to the move's book entry, if there is one (may be null)
+ * @return Returns true if the book has a move with a weight above 0 that is legal in the position.
+ */
+bool OpeningBook::chooseMove(const BasicBoard<EnglishRules>& board, std::uint64_t random, CompactMove& move,
+                             BookEntry* entry) const
+{
+    BookEntry found[MoveList::CAPACITY];
+    int count = probe(board.getHash(), found, MoveList::CAPACITY);
+    if (count == 0)
+        return false;
+
+    // only moves that are legal here count (a key can, very rarely, be another position's)
+    MoveList moves;
+    board.getAllLegalMoves(board.isWhiteToMove(), moves);
+    CompactMove candidates[MoveList::CAPACITY];
+    int candidateEntries[MoveList::CAPACITY];
+    int candidateCount = 0;
+    std::uint64_t totalWeight = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (found[i].weight == 0)
+            continue;
+        for (int j = 0; j < moves.size(); j++)
+        {
+            if (moves[j].getFrom() == found[i].from && moves[j].getTo() == found[i].to)
+            {
+                candidates[candidateCount] = moves[j];
+                candidateEntries[candidateCount++] = i;
+                totalWeight += found[i].weight;
+                break;
+            }
+        }
+    }
+    if (totalWeight == 0)
+        return false;
+
+    std::uint64_t pick = random % totalWeight;
+    for (int i = 0; i < candidateCount; i++)
+    {
+        const BookEntry& candidate = found[candidateEntries[i]];
+        if (pick < candidate.weight)
+        {
+            move = candidates[i];
+            if (entry != nullptr)
+                *entry = candidate;
+            return true;
+        }
+        pick -= candidate.weight;
+    }
+    return false;
+}
+
+/**
+ * Writes a book file.
+ * @param path The file to write
+ * @param bookEntries The moves, sorted (see BookEntry::operator<)
+ * @return Returns true if the file was written.
+ */
+bool OpeningBook::write(const std::string& path, const std::vector<BookEntry>& bookEntries)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    unsigned char header[FILE_HEADER_SIZE];
+    std::copy(FILE_MAGIC, FILE_MAGIC + 8, header);
+    writeLittleEndian(header + 8, bookEntries.size(), 8);
+    out.write((const char*)header, FILE_HEADER_SIZE);
+
+    // a few thousand entries at a time
+    std::vector<unsigned char> buffer;
+    for (std::size_t i = 0; i < bookEntries.size(); i++)
+    {
+        const BookEntry& entry = bookEntries[i];
+        unsigned char bytes[ENTRY_SIZE];
+        writeLittleEndian(bytes, entry.key, 8);
+        bytes[8] = entry.from;
+        bytes[9] = entry.to;
+        writeLittleEndian(bytes + 10, entry.weight, 2);
+        writeLittleEndian(bytes + 12, entry.wins, 4);
+        writeLittleEndian(bytes + 16, entry.draws, 4);
+        writeLittleEndian(bytes + 20, entry.losses, 4);
+        buffer.insert(buffer.end(), bytes, bytes + ENTRY_SIZE);
+        if (buffer.size() >= 4096 * ENTRY_SIZE || i + 1 == bookEntries.size())
+        {
+            out.write((const char*)buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+    return (bool)out;
+}
+
+/**
+ * @return Returns the entry at the given place in the book.
+ * @param index The place, from 0 to getSize() - 1
+ */
+BookEntry OpeningBook::getEntry(std::uint64_t index) const
+{
+    const unsigned char* bytes = entries + index * ENTRY_SIZE;
+    BookEntry entry;
+    entry.key = readLittleEndian(bytes, 8);
+    entry.from = bytes[8];
+    entry.to = bytes[9];
+    entry.weight = (std::uint16_t)readLittleEndian(bytes + 10, 2);
+    entry.wins = (std::uint32_t)readLittleEndian(bytes + 12, 4);
+    entry.draws = (std::uint32_t)readLittleEndian(bytes + 16, 4);
+    entry.losses = (std::uint32_t)readLittleEndian(bytes + 20, 4);
+    return entry;
+}
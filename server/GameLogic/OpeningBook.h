@@ -0,0 +1,119 @@
+#ifndef OPENING_BOOK_H
+#define OPENING_BOOK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Typedefs.h"
+#include "BasicBoard.h"
+#include "CompactMove.h"
+#include "MappedFile.h"
+
+/**
+ * One move of the opening book: a position, a move played in it, and how the games that
+ * played it went, for the side that played it.
+ */
+struct BookEntry
+{
+	// the position (see BasicBoard::getHash)
+	hashkey_t key;
+	// the move's first and last squares (of two king's jumps that share both, the book plays
+	// whichever the board generates first)
+	std::uint8_t from;
+	std::uint8_t to;
+	// how often the book plays this move, relative to the position's other moves (0 for never)
+	std::uint16_t weight;
+	std::uint32_t wins;
+	std::uint32_t draws;
+	std::uint32_t losses;
+
+	/**
+	 * @return Returns the number of games the move was played in.
+	 */
+	std::uint64_t getGames() const { return (std::uint64_t)wins + draws + losses; }
+
+	/**
+	 * @return Returns true if this entry comes before the other in the book (by position, then move).
+	 */
+	bool operator<(const BookEntry& other) const
+	{
+		return key != other.key ? key < other.key : from != other.from ? from < other.from : to < other.to;
+	}
+};
+
+/**
+ * An opening book built from played games (see tools/bookbuild.cpp): for each position the
+ * games went through, the moves played in it and how they turned out.
+ *
+ * The book file is a short header followed by fixed-size entries sorted by position key, so a
+ * position's moves are found by a binary search straight in the memory-mapped file, with
+ * nothing to load or build first: opening a book of any size is instant, only the pages a
+ * lookup touches are ever read, and any number of threads can look positions up at once.
+ */
+class OpeningBook
+{
+	public:
+		OpeningBook();
+
+		/**
+		 * Maps a book file (closing any opened before).
+		 * @param path The file checkers_bookbuild wrote
+		 * @return Returns true if the file was a book.
+		 */
+		bool open(const std::string& path);
+
+		/**
+		 * @return Returns the number of moves in the book (0 if nothing is open).
+		 */
+		std::uint64_t getSize() const { return size; }
+
+		/**
+		 * Looks up the moves the book has for a position.
+		 * @param key The position (see BasicBoard::getHash)
+		 * @param entries The array to write the moves to
+		 * @param capacity The most moves it can hold
+		 * @return Returns the number of moves written.
+		 */
+		int probe(hashkey_t key, BookEntry* entries, int capacity) const;
+
+		/**
+		 * Picks one of the book's moves for a position, at random in proportion to their weights.
+		 * @param board The position
+		 * @param random A random number, which picks the move
+		 * @param move Set to the move, if there is one
+		 * @param entry Set to the move's book entry, if there is one (may be null)
+		 * @return Returns true if the book has a move with a weight above 0 that is legal in the position.
+		 */
+		bool chooseMove(const BasicBoard<EnglishRules>& board, std::uint64_t random, CompactMove& move,
+		                BookEntry* entry = nullptr) const;
+
+		/**
+		 * Writes a book file.
+		 * @param path The file to write
+		 * @param entries The moves, sorted (see BookEntry::operator<)
+		 * @return Returns true if the file was written.
+		 */
+		static bool write(const std::string& path, const std::vector<BookEntry>& entries);
+
+		// the size of an entry in the file, in bytes
+		const static int ENTRY_SIZE = 24;
+
+	private:
+		MappedFile file;
+		const unsigned char* entries;
+		std::uint64_t size;
+
+		/**
+		 * @return Returns the entry at the given place in the book.
+		 * @param index The place, from 0 to getSize() - 1
+		 */
+		BookEntry getEntry(std::uint64_t index) const;
+
+		/**
+		 * @return Returns the position key of the entry at the given place in the book.
+		 * @param index The place, from 0 to getSize() - 1
+		 */
+		hashkey_t getKey(std::uint64_t index) const { return readLittleEndian(entries + index * ENTRY_SIZE, 8); }
+};
+
+#endif
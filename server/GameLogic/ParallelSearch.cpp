@@ -0,0 +1,138 @@
+#include "ParallelSearch.h"
+
+#include <algorithm>
+
+/**
+ * Constructor for a parallel searcher, starting its helper threads.
+ * @param table The transposition table every thread shares (which must outlive this)
+ * @param maxThreads The most threads a search can use, counting the calling thread
+ * @param weights The weights of the static evaluation
+ */
+ParallelSearch::ParallelSearch(TranspositionTable& table, int maxThreads, const EvalWeights& weights)
+    : table(table), mainSearch(weights, &table, 0), shuttingDown(false), runningHelpers(0), helpersStop(false)
+{
+    for (int i = 1; i < maxThreads; i++)
+    {
+        std::unique_ptr<Helper> helper(new Helper());
+        helper->search.reset(new Search(weights, &table, i));
+        helper->search->setStopSignal(&helpersStop);
+        helpers.push_back(std::move(helper));
+    }
+    // start the threads only once every helper is in place
+    for (std::unique_ptr<Helper>& helper : helpers)
+    {
+        Helper* self = helper.get();
+        helper->thread = std::thread([this, self] { helperLoop(*self); });
+    }
+}
+
+/**
+ * Responsible for stopping and joining the helper threads.
+ */
+ParallelSearch::~ParallelSearch()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shuttingDown = true;
+    }
+    helpersStop = true;
+    wakeHelpers.notify_all();
+    for (std::unique_ptr<Helper>& helper : helpers)
+        helper->thread.join();
+}
+
+/**
+ * Searches for the best move of the side to move on the given board.
+ * @param board The position to search (it is copied, and not changed)
+ * @param limits How deep, and for how many nodes or how long, the main search may go
+ * @param threads How many threads to search with, counting the calling thread (0 for all of them)
+ * @return Returns the main search's result, with the nodes of every thread counted.
+ */
+SearchResult ParallelSearch::run(const BasicBoard<EnglishRules>& board, const SearchLimits& limits, int threads)
+{
+    int helperCount = threads <= 0 ? (int)helpers.size() : std::min(threads - 1, (int)helpers.size());
+
+    table.newSearch();
+    helpersStop = false;
+    if (helperCount > 0)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobBoard = board;
+        // the helpers only stop when the main search does
+        jobLimits = SearchLimits();
+        jobLimits.maxDepth = limits.maxDepth;
+        for (int i = 0; i < helperCount; i++)
+            helpers[i]->assigned = true;
+        runningHelpers = helperCount;
+    }
+    wakeHelpers.notify_all();
+
+    SearchResult result = mainSearch.run(board, limits);
+
+    helpersStop = true;
+    std::unique_lock<std::mutex> lock(mutex);
+    helpersFinished.wait(lock, [this] { return runningHelpers == 0; });
+    for (int i = 0; i < helperCount; i++)
+    {
+        result.nodes += helpers[i]->result.nodes;
+        result.endgameHits += helpers[i]->result.endgameHits;
+    }
+    return result;
+}
+
+/**
+ * Sets the keys of the positions the game has already been through, for every thread.
+ * @param keys The Zobrist keys of the positions, oldest first
+ */
+void ParallelSearch::setGameHistory(const std::vector<hashkey_t>& keys)
+{
+    mainSearch.setGameHistory(keys);
+    for (std::unique_ptr<Helper>& helper : helpers)
+        helper->search->setGameHistory(keys);
+}
+
+/**
+ * Sets the endgame database every thread looks positions up in.
+ * @param endgames The database (or null to search without one)
+ */
+void ParallelSearch::setEndgameDatabase(const EndgameDatabase* endgames)
+{
+    mainSearch.setEndgameDatabase(endgames);
+    for (std::unique_ptr<Helper>& helper : helpers)
+        helper->search->setEndgameDatabase(endgames);
+}
+
+/**
+ * Asks a running search to stop as soon as it can (it still returns the best move it has).
+ */
+void ParallelSearch::stop()
+{
+    mainSearch.stop();
+    helpersStop = true;
+}
+
+/**
+ * Runs one helper thread: waits for a search, runs it, and waits again until shut down.
+ * @param helper The helper this thread is
+ */
+void ParallelSearch::helperLoop(Helper& helper)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wakeHelpers.wait(lock, [this, &helper] { return shuttingDown || helper.assigned; });
+        if (shuttingDown)
+            return;
+
+        BasicBoard<EnglishRules> board = jobBoard;
+        SearchLimits limits = jobLimits;
+        lock.unlock();
+        SearchResult result = helper.search->run(board, limits);
+        lock.lock();
+
+        helper.result = result;
+        helper.assigned = false;
+        if (--runningHelpers == 0)
+            helpersFinished.notify_all();
+    }
+}
@@ -0,0 +1,123 @@
+#ifndef PARALLEL_SEARCH_H
+#define PARALLEL_SEARCH_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Typedefs.h"
+#include "BasicBoard.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+
+/**
+ * Searches a position with several threads at once ("lazy SMP"): every thread searches the
+ * same position with its own Search, and they share one transposition table, so each thread
+ * finds much of the tree already searched by the others. The helper threads start at different
+ * depths and order their moves a little differently, so they don't all search the same lines.
+ * The calling thread runs the main search, whose result (and limits) are the ones that count;
+ * once it finishes, the helpers are stopped.
+ *
+ * The helper threads are started once, when this is made, and wait between searches, so
+ * searching a move never starts a thread. A ParallelSearch runs one search at a time.
+ */
+class ParallelSearch
+{
+	public:
+		/**
+		 * Constructor for a parallel searcher, starting its helper threads.
+		 * @param table The transposition table every thread shares (which must outlive this)
+		 * @param maxThreads The most threads a search can use, counting the calling thread
+		 * @param weights The weights of the static evaluation
+		 */
+		ParallelSearch(TranspositionTable& table, int maxThreads, const EvalWeights& weights = EvalWeights());
+
+		/**
+		 * Responsible for stopping and joining the helper threads.
+		 */
+		~ParallelSearch();
+
+		ParallelSearch(const ParallelSearch&) = delete;
+		ParallelSearch& operator=(const ParallelSearch&) = delete;
+
+		/**
+		 * Searches for the best move of the side to move on the given board.
+		 * @param board The position to search (it is copied, and not changed)
+		 * @param limits How deep, and for how many nodes or how long, the main search may go
+		 * (the helpers stop when it does)
+		 * @param threads How many threads to search with, counting the calling thread
+		 * (at most the maxThreads this was made with; 0 for all of them)
+		 * @return Returns the main search's result, with the nodes of every thread counted.
+		 */
+		SearchResult run(const BasicBoard<EnglishRules>& board, const SearchLimits& limits, int threads = 0);
+
+		/**
+		 * Sets the keys of the positions the game has already been through, for every thread
+		 * (see Search::setGameHistory).
+		 * @param keys The Zobrist keys of the positions, oldest first
+		 */
+		void setGameHistory(const std::vector<hashkey_t>& keys);
+
+		/**
+		 * Sets the endgame database every thread looks positions up in (see Search::setEndgameDatabase).
+		 * Not to be called while a search is running.
+		 * @param endgames The database (or null to search without one)
+		 */
+		void setEndgameDatabase(const EndgameDatabase* endgames);
+
+		/**
+		 * Asks a running search to stop as soon as it can (it still returns the best move it has).
+		 * Safe to call from another thread.
+		 */
+		void stop();
+
+		/**
+		 * Sets a flag, shared with other threads, that also stops the main search (and so the
+		 * helpers) once set (see Search::setStopSignal). Not to be called while a search is running.
+		 * @param signal The flag (or null for none), which must outlive the searches that use it
+		 */
+		void setStopSignal(const std::atomic<bool>* signal) { mainSearch.setStopSignal(signal); }
+
+		/**
+		 * @return Returns the most threads a search can use, counting the calling thread.
+		 */
+		int getMaxThreads() const { return (int)helpers.size() + 1; }
+
+	private:
+		struct Helper
+		{
+			std::unique_ptr<Search> search;
+			std::thread thread;
+			// set when the helper has a search to run, and cleared once it has run it
+			bool assigned = false;
+			SearchResult result;
+		};
+
+		TranspositionTable& table;
+		Search mainSearch;
+		std::vector<std::unique_ptr<Helper>> helpers;
+
+		// guards the job below and the helpers' assigned flags
+		std::mutex mutex;
+		std::condition_variable wakeHelpers;
+		std::condition_variable helpersFinished;
+		bool shuttingDown;
+		int runningHelpers;
+
+		// the search the helpers are given
+		BasicBoard<EnglishRules> jobBoard;
+		SearchLimits jobLimits;
+
+		// set once the main search is done, to stop the helpers
+		std::atomic<bool> helpersStop;
+
+		/**
+		 * Runs one helper thread: waits for a search, runs it, and waits again until shut down.
+		 * @param helper The helper this thread is
+		 */
+		void helperLoop(Helper& helper);
+};
+
+#endif
@@ -3,8 +3,7 @@
 #include "Board.h"
 #include "Move.h"
 #include "Typedefs.h"
-
-#include <iostream>
+#include "Trace.h"
 
 /**
  * @return Returns a two-part array representing the coordinates of this piece's position.
@@ -59,14 +58,54 @@ void Piece::checkIfShouldBeKing(const Board& board)
 
 moves_t Piece::getAllPossibleMoves(const Board &board) const
 {
-    // create expandable list of all moves
-    moves_t moves(0);
+    // generate into a list on the stack, and only then build the Move objects
+    MoveList list;
+    getAllPossibleMoves(board, list);
 
-    std::cout << "Generating moves for piece at ("
-              << x << "," << y
-              << ") Color: " << (isWhite ? "White" : "Black")
-              << " King: " << (isKing ? "Yes" : "No")
-              << std::endl;
+    // jumps are generated depth first, so the move holding one less jump than the current one
+    // is always the last one seen with that many jumps
+    move_ptr_t lastJumpAtDepth[CompactMove::MAX_JUMPS + 1];
+
+    moves_t moves;
+    moves.reserve(list.size());
+    for (const CompactMove& move : list)
+    {
+        int jumps = move.getJumpCount();
+        if (jumps == 0)
+        {
+            coords_t start = Board::getCoordsFromSquare(move.getFrom());
+            coords_t end = Board::getCoordsFromSquare(move.getTo());
+            moves.push_back(move_ptr_t(new Move(start[0], start[1], end[0], end[1], nullptr, false)));
+        }
+        else
+        {
+            // a Move only holds its last jump, starting where the preceding jump landed
+            int landings[CompactMove::MAX_JUMPS];
+            move.getLandingSquares(landings);
+            coords_t start = Board::getCoordsFromSquare(jumps > 1 ? landings[jumps - 2] : move.getFrom());
+            coords_t end = Board::getCoordsFromSquare(move.getTo());
+
+            move_ptr_t precedingMove = jumps > 1 ? lastJumpAtDepth[jumps - 1] : nullptr;
+            lastJumpAtDepth[jumps] = move_ptr_t(new Move(start[0], start[1], end[0], end[1], precedingMove, true));
+            moves.push_back(lastJumpAtDepth[jumps]);
+        }
+    }
+
+    return moves;
+}
+
+/**
+ * Generates all physically possible moves of the given piece, without allocating any memory.
+ * (Every jump in a chain is its own move, holding the full path of jumps up to it)
+ * @param board The board to work with.
+ * @param moves The list to add the moves to.
+ */
+void Piece::getAllPossibleMoves(const Board &board, MoveList &moves) const
+{
+    TRACE_DEBUG("Generating moves for piece at ("
+                << x << "," << y
+                << ") Color: " << (isWhite ? "White" : "Black")
+                << " King: " << (isKing ? "Yes" : "No"));
 
     // change y endpoints based on kingness and color=direction of movement
     int startingY, yIncrement;
@@ -103,25 +142,21 @@ moves_t Piece::getAllPossibleMoves(const Board &board) const
                 continue;
 
             // add a move here if there's not a piece
-            if (board.getValueAt(x, y) == nullptr)
+            if (!board.isOccupied(x, y) && !moves.full())
             {
                 // this is not jump move in any case, and is always the first move
-                move_ptr_t move(new Move(this->x, this->y, x, y, nullptr, false));
-                moves.push_back(move);
+                moves.push_back(CompactMove(Board::getSquareFromCoords(this->x, this->y), Board::getSquareFromCoords(x, y)));
 
-                std::cout << "Found possible move to (" << x << "," << y << ")" << std::endl;
+                TRACE_DEBUG("Found possible move to (" << x << "," << y << ")");
             }
         }
     }
 
     // after we've checked all normal moves, look for and add all possible jumps (recusively as well - I mean ALL jumps)
-    moves_t possibleJumps = this->getAllPossibleJumps(board, nullptr);
-    moves.insert(moves.end(), possibleJumps.begin(), possibleJumps.end());
+    int square = Board::getSquareFromCoords(this->x, this->y);
+    this->getAllPossibleJumps(board, moves, CompactMove(square, square));
 
-    std::cout << "Total possible moves: " << moves.size() << std::endl;
-
-    moves.shrink_to_fit();
-    return moves;
+    TRACE_DEBUG("Total possible moves: " << moves.size());
 }
 
 /**
@@ -129,18 +164,16 @@ moves_t Piece::getAllPossibleMoves(const Board &board) const
  * Does this recursivly; for each move a new imaginary piece will be generated,
  * and this function will then be called on that piece to find all possible subsequent moves.
  * @param board The board to work with - assumed to be flipped to correspond to this piece's color.
- * @param precedingMove The moves preceding the call to search for moves off this piece - only used
- * in recursion, should be set to null at first call. (if it's not, it means this piece is imaginary).
+ * @param moves The list to add the jumps to.
+ * @param precedingJumps The move made of the jumps preceding the call to search for moves off this piece - it
+ * should have no jumps at first call. (if it has any, it means this piece is imaginary).
  */
-moves_t Piece::getAllPossibleJumps(const Board &board, const move_ptr_t precedingMove) const
+void Piece::getAllPossibleJumps(const Board &board, MoveList &moves, const CompactMove &precedingJumps) const
 {
-    // create expandable list of all moves
-    moves_t moves(0);
-
-    std::cout << "DEBUG: Entering getAllPossibleJumps for piece at ("
-              << this->x << "," << this->y
-              << ") Color: " << (isWhite ? "White" : "Black")
-              << " King: " << (isKing ? "Yes" : "No") << std::endl;
+    TRACE_DEBUG("Entering getAllPossibleJumps for piece at ("
+                << this->x << "," << this->y
+                << ") Color: " << (isWhite ? "White" : "Black")
+                << " King: " << (isKing ? "Yes" : "No"));
 
     // this is the same as above except we're doing a large cube (4x4)
     // change y endpoints based on kingness and color=direction of movement
@@ -158,15 +191,18 @@ moves_t Piece::getAllPossibleJumps(const Board &board, const move_ptr_t precedin
         yIncrement = 4;
     }
 
-    std::cout << "DEBUG: Jump direction - startingY: " << startingY
-              << ", yIncrement: " << yIncrement << std::endl;
+    TRACE_DEBUG("Jump direction - startingY: " << startingY
+                << ", yIncrement: " << yIncrement);
 
     // use kingess to determine number of rows to check
     int rowsToCheck = 1; // default as non-king
     if (this->isKing)
         rowsToCheck = 2;
 
-    std::cout << "DEBUG: rowsToCheck: " << rowsToCheck << std::endl;
+    TRACE_DEBUG("rowsToCheck: " << rowsToCheck);
+
+    // the opponent's pieces, which are the only ones we can jump
+    bitboard_t opponentPieces = board.getPieceMask(!this->isWhite);
 
     // iterate over the four spaces where normal (non-jumping) moves are possible
     for (int x = this->x - 2; x <= this->x + 2; x += 4)
@@ -174,73 +210,75 @@ moves_t Piece::getAllPossibleJumps(const Board &board, const move_ptr_t precedin
         // go over the rows (or row) (we iterate the number of times determined by the kingess above)
         int y = startingY - yIncrement; // add this so we can add the normal increment before the boundary checks in the loop
 
-        std::cout << "DEBUG: Starting jump check sequence at x: " << x
-                  << ", initial y: " << y << std::endl;
+        TRACE_DEBUG("Starting jump check sequence at x: " << x
+                    << ", initial y: " << y);
 
         for (int i = 0; i < rowsToCheck; i++)
         {
             // increment y if we need to (this will have no effect if we only run one iteration)
             y += yIncrement;
 
-            std::cout << "DEBUG: Checking potential jump to (" << x << "," << y << ")" << std::endl;
+            TRACE_DEBUG("Checking potential jump to (" << x << "," << y << ")");
 
             // check for going off end of board, in which case just skip this iteration (we may do this twice if at a corner)
             if (board.isOverEdge(x, y))
             {
-                std::cout << "DEBUG: Position (" << x << "," << y << ") is over edge, skipping" << std::endl;
-                continue;
-            }
-
-            // don't try to go backward to our old move start so we don't get in infinite recursion loops
-            if (precedingMove != nullptr &&
-                x == precedingMove->getStartingPosition()[0] &&
-                y == precedingMove->getStartingPosition()[1])
-            {
-                std::cout << "DEBUG: Position (" << x << "," << y
-                          << ") would cause recursion loop, skipping" << std::endl;
+                TRACE_DEBUG("Position (" << x << "," << y << ") is over edge, skipping");
                 continue;
             }
 
             // Calculate the position of the piece we'd be jumping over
             int midX = (this->x + x) / 2;
             int midY = (this->y + y) / 2;
+            int midSquare = Board::getSquareFromCoords(midX, midY);
 
-            std::cout << "DEBUG: Checking if there's an opponent's piece at ("
-                      << midX << "," << midY << ")" << std::endl;
+            // don't jump a piece this chain has already jumped (which includes going straight back to
+            // our old move start), so a king circling a group of pieces doesn't recurse forever
+            if (precedingJumps.getCaptureMask() & squareMask(midSquare))
+            {
+                TRACE_DEBUG("Position (" << x << "," << y
+                            << ") would cause recursion loop, skipping");
+                continue;
+            }
+
+            TRACE_DEBUG("Checking if there's an opponent's piece at ("
+                        << midX << "," << midY << ")");
 
             // test if there is a different-colored piece between us (at the average of our position) and the starting point
             // AND that there's no piece in the planned landing space (meaning we can possible jump there)
-            Piece *betweenPiece = board.getValueAt(midX, midY);
-
-            if (betweenPiece == nullptr)
+            if (!board.isOccupied(midX, midY))
             {
-                std::cout << "DEBUG: No piece found at (" << midX << "," << midY
-                          << "), cannot jump" << std::endl;
+                TRACE_DEBUG("No piece found at (" << midX << "," << midY
+                            << "), cannot jump");
                 continue;
             }
 
-            if (betweenPiece->isWhite == this->isWhite)
+            if ((opponentPieces & squareMask(midSquare)) == 0)
             {
-                std::cout << "DEBUG: Piece at (" << midX << "," << midY
-                          << ") is same color, cannot jump" << std::endl;
+                TRACE_DEBUG("Piece at (" << midX << "," << midY
+                            << ") is same color, cannot jump");
                 continue;
             }
 
             // Check if landing spot is empty
-            if (board.getValueAt(x, y) != nullptr)
+            if (board.isOccupied(x, y))
             {
-                std::cout << "DEBUG: Landing spot at (" << x << "," << y
-                          << ") is occupied, cannot jump" << std::endl;
+                TRACE_DEBUG("Landing spot at (" << x << "," << y
+                            << ") is occupied, cannot jump");
                 continue;
             }
 
-            std::cout << "DEBUG: Valid jump found from (" << this->x << "," << this->y
-                      << ") to (" << x << "," << y << ")" << std::endl;
+            // stop adding moves once the list is full (or the chain can't hold another jump)
+            if (moves.full() || precedingJumps.getJumpCount() == CompactMove::MAX_JUMPS)
+                return;
 
-            // in which case, add a move here, and note that it is a jump (we may be following some other jumps)
-            move_ptr_t jumpingMove(new Move(this->x, this->y, x, y, precedingMove, true)); // origin points are absolute origin (ORIGINAL piece)
+            TRACE_DEBUG("Valid jump found from (" << this->x << "," << this->y
+                        << ") to (" << x << "," << y << ")");
 
-            // then add it to our list
+            // in which case, add a move here, and note that it is a jump (we may be following some other jumps)
+            // (the direction has bit 0 set for +x and bit 1 set for +y)
+            int direction = (x > this->x ? 1 : 0) | (y > this->y ? 2 : 0);
+            CompactMove jumpingMove = precedingJumps.withJump(direction, midSquare, Board::getSquareFromCoords(x, y));
             moves.push_back(jumpingMove);
 
             // after jumping, create an imaginary piece as if it was there to look for more jumps
@@ -250,25 +288,20 @@ moves_t Piece::getAllPossibleJumps(const Board &board, const move_ptr_t precedin
             if (this->isKing)
                 imaginaryPiece.setKing();
 
-            std::cout << "DEBUG: Checking for chain jumps from (" << x << "," << y << ")" << std::endl;
+            TRACE_DEBUG("Checking for chain jumps from (" << x << "," << y << ")");
 
-            // find possible subsequent moves recursively
-            moves_t subsequentMoves = imaginaryPiece.getAllPossibleJumps(board, jumpingMove);
+            // find possible subsequent moves recursively (they are added straight to our list)
+            int sizeBefore = moves.size();
+            imaginaryPiece.getAllPossibleJumps(board, moves, jumpingMove);
 
-            if (!subsequentMoves.empty())
+            if (moves.size() > sizeBefore)
             {
-                std::cout << "DEBUG: Found " << subsequentMoves.size()
-                          << " chain jumps from (" << x << "," << y << ")" << std::endl;
+                TRACE_DEBUG("Found " << moves.size() - sizeBefore
+                            << " chain jumps from (" << x << "," << y << ")");
             }
-
-            // add these moves to our list if they exist, otherwise just move on to other possibilities
-            moves.insert(moves.end(), subsequentMoves.begin(), subsequentMoves.end());
         }
     }
 
-    std::cout << "DEBUG: getAllPossibleJumps returning " << moves.size()
-              << " jumps for piece at (" << this->x << "," << this->y << ")" << std::endl;
-
-    moves.shrink_to_fit();
-    return moves;
-}
\ No newline at end of file
+    TRACE_DEBUG("getAllPossibleJumps finished with " << moves.size()
+                << " moves for piece at (" << this->x << "," << this->y << ")");
+}
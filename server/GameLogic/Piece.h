@@ -5,6 +5,7 @@
 #include <vector>
 #include <array>
 #include "Typedefs.h"
+#include "MoveList.h"
 
 class Board;
 class Move;
@@ -18,6 +19,9 @@ class Move;
  */
 class Piece
 {
+	// the board crowns pieces, and uncrowns them when taking a move back
+	friend class Board;
+
     private:
     	int x;
     	int y;
@@ -33,14 +37,22 @@ class Piece
 		 * Does this recursivly; for each move a new imaginary piece will be generated,
 		 * and this function will then be called on that piece to find all possible subsequent moves.
 		 * @param board The board to work with - assumed to be flipped to correspond to this piece's color.
-		 * @param precedingMove The moves preceding the call to search for moves off this piece - only used
-
-		 * in recursion, should be set to null at first call. (if it's not, it means this piece is imaginary).
+		 * @param moves The list to add the jumps to.
+		 * @param precedingJumps The move made of the jumps preceding the call to search for moves off this piece - it
+		 * should have no jumps at first call. (if it has any, it means this piece is imaginary).
 		 */
-		moves_t getAllPossibleJumps(const Board& board, const move_ptr_t precedingMove) const;
+		void getAllPossibleJumps(const Board& board, MoveList& moves, const CompactMove& precedingJumps) const;
 		
     public:
-    	const bool isWhite;
+    	// (not const, so the board can keep its pieces by value and copy them around,
+    	// but only ever set when a piece is made)
+    	bool isWhite;
+
+		/**
+		 * Constructor for an empty slot in the board's array of pieces
+		 * (which the board replaces with a real piece before using it)
+		 */
+		Piece() : x(0), y(0), isWhite(false) {};
 
 		/**
 		 * Constructor for objects of class Piece
@@ -60,6 +72,11 @@ class Piece
 		 * @return Returns a string representation of this given piece
 		 */
 		std::string getString() const;
+
+		/**
+		 * @return Returns true if this piece is a king
+		 */
+		bool getIsKing() const { return isKing; }
 		
 		/**
 		 * Switches this peice to be a king if it is at the end of the board.
@@ -81,6 +98,14 @@ class Piece
 		 * @param board The board to work with.
 		 */
 		moves_t getAllPossibleMoves(const Board& board) const;
+
+		/**
+		 * Generates all physically possible moves of the given piece, without allocating any memory.
+		 * (Every jump in a chain is its own move, holding the full path of jumps up to it)
+		 * @param board The board to work with.
+		 * @param moves The list to add the moves to.
+		 */
+		void getAllPossibleMoves(const Board& board, MoveList& moves) const;
 };
 		
 #endif
@@ -0,0 +1,106 @@
+#include "PonderSearch.h"
+
+#include "Trace.h"
+
+/**
+ * Constructor for a ponderer, starting its thread.
+ * @param search The search to ponder with (which must outlive this)
+ */
+PonderSearch::PonderSearch(ParallelSearch& search)
+    : search(search), shuttingDown(false), assigned(false), pondering(false), stopSignal(false)
+{
+    thread = std::thread([this] { ponderLoop(); });
+}
+
+/**
+ * Responsible for stopping the ponder, if one is running, and joining the thread.
+ */
+PonderSearch::~PonderSearch()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shuttingDown = true;
+    }
+    stopSignal = true;
+    wake.notify_all();
+    thread.join();
+}
+
+/**
+ * Starts pondering a position (finishing any ponder that was running).
+ * @param board The position after the reply the opponent is expected to play
+ * @param limits How deep, and for how many nodes or how long, to search
+ */
+void PonderSearch::start(const BasicBoard<EnglishRules>& board, const SearchLimits& limits)
+{
+    if (pondering)
+    {
+        SearchResult ignored;
+        finish(board, ignored);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobBoard = board;
+        jobLimits = limits;
+        jobStart = std::chrono::steady_clock::now();
+        assigned = true;
+        pondering = true;
+    }
+    wake.notify_all();
+}
+
+/**
+ * Stops the ponder, if one is running, and waits for it.
+ * @param board The position the opponent's move actually led to
+ * @param result Set to the ponder's result, if it was pondering this position
+ * @return Returns true if it was pondering this position (a ponder hit).
+ */
+bool PonderSearch::finish(const BasicBoard<EnglishRules>& board, SearchResult& result)
+{
+    if (!pondering)
+        return false;
+
+    stopSignal = true;
+    std::unique_lock<std::mutex> lock(mutex);
+    searchDone.wait(lock, [this] { return !assigned; });
+    stopSignal = false;
+    pondering = false;
+
+    // the key includes the side to move, so a matching key is the same position
+    bool hit = board.getHash() == jobBoard.getHash();
+    if (hit)
+    {
+        result = jobResult;
+        // the time the ponder ran counts, not just the time it spent searching
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - jobStart).count();
+    }
+    TRACE_DEBUG("Ponder " << (hit ? "hit" : "miss") << " after " << jobResult.nodes << " nodes, depth " << jobResult.depth);
+    return hit;
+}
+
+/**
+ * Runs the thread: waits for a position, searches it, and waits again until shut down.
+ */
+void PonderSearch::ponderLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wake.wait(lock, [this] { return shuttingDown || assigned; });
+        if (shuttingDown)
+            return;
+
+        BasicBoard<EnglishRules> board = jobBoard;
+        SearchLimits limits = jobLimits;
+        lock.unlock();
+        search.setStopSignal(&stopSignal);
+        SearchResult result = search.run(board, limits);
+        search.setStopSignal(nullptr);
+        lock.lock();
+
+        jobResult = result;
+        assigned = false;
+        searchDone.notify_all();
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef PONDER_SEARCH_H
+#define PONDER_SEARCH_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "Typedefs.h"
+#include "BasicBoard.h"
+#include "ParallelSearch.h"
+#include "Search.h"
+
+/**
+ * Thinks on the opponent's time ("pondering"): once a player has moved, it searches the
+ * position after the reply its search expects, on a thread of its own, until the opponent has
+ * actually moved. If the opponent played that reply (a "ponder hit"), the search has already
+ * been under way for the whole of the opponent's turn: its result can be played at once, or,
+ * if it hasn't searched long enough yet, the player's own search finds the transposition table
+ * full of it. Otherwise it was a guess that didn't come up, and is just stopped.
+ *
+ * Ponders with a player's own ParallelSearch (so pondering never adds threads to the ones the
+ * player searches with anyway) on a thread started once, when this is made, which waits
+ * between ponders. The player must finish the ponder before searching again itself.
+ */
+class PonderSearch
+{
+	public:
+		/**
+		 * Constructor for a ponderer, starting its thread.
+		 * @param search The search to ponder with (which must outlive this)
+		 */
+		explicit PonderSearch(ParallelSearch& search);
+
+		/**
+		 * Responsible for stopping the ponder, if one is running, and joining the thread.
+		 */
+		~PonderSearch();
+
+		PonderSearch(const PonderSearch&) = delete;
+		PonderSearch& operator=(const PonderSearch&) = delete;
+
+		/**
+		 * Starts pondering a position (finishing any ponder that was running).
+		 * @param board The position after the reply the opponent is expected to play
+		 * @param limits How deep, and for how many nodes or how long, to search (usually no time
+		 * limit, since the ponder is stopped when the opponent moves)
+		 */
+		void start(const BasicBoard<EnglishRules>& board, const SearchLimits& limits);
+
+		/**
+		 * Stops the ponder, if one is running, and waits for it.
+		 * @param board The position the opponent's move actually led to
+		 * @param result Set to the ponder's result, if it was pondering this position
+		 * @return Returns true if it was pondering this position (a ponder hit).
+		 */
+		bool finish(const BasicBoard<EnglishRules>& board, SearchResult& result);
+
+		/**
+		 * @return Returns true if a ponder has been started and not finished.
+		 */
+		bool isPondering() const { return pondering; }
+
+	private:
+		ParallelSearch& search;
+		std::thread thread;
+
+		// guards the job below and the flags
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::condition_variable searchDone;
+		bool shuttingDown;
+		// set when there is a position to search, and cleared once the search of it has returned
+		bool assigned;
+		// set from start until finish, so the owner knows there is a ponder to finish
+		bool pondering;
+
+		BasicBoard<EnglishRules> jobBoard;
+		SearchLimits jobLimits;
+		SearchResult jobResult;
+		std::chrono::steady_clock::time_point jobStart;
+
+		// stops the search (unlike ParallelSearch::stop, it can't be missed by a search that is
+		// just about to start)
+		std::atomic<bool> stopSignal;
+
+		/**
+		 * Runs the thread: waits for a position, searches it, and waits again until shut down.
+		 */
+		void ponderLoop();
+};
+
+#endif
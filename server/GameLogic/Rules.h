@@ -0,0 +1,101 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include "Typedefs.h"
+
+class CompactMove;
+class WideMove;
+
+/**
+ * The rule sets a BasicBoard can be built for. Everything here is a compile time constant,
+ * so a board only ever contains the code for its own rules, and the geometry tables
+ * (see SquareTables.h) are worked out by the compiler for its size.
+ *
+ * Only the dark squares of a board can hold pieces, so a board of SIZE x SIZE has
+ * SIZE * SIZE / 2 playable squares, numbered from the top left SIZE / 2 to a row
+ * (see Bitboard.h). White starts at the top in both variants and moves first.
+ */
+
+/**
+ * The variants a game can be created with, for choosing a rule set at run time.
+ */
+enum GameVariant
+{
+	ENGLISH_CHECKERS,
+	INTERNATIONAL_DRAUGHTS
+};
+
+/**
+ * The checkers this program has always played: 8x8, men move and jump forward only,
+ * kings move one square at a time, and any capture may be chosen.
+ * (As in Piece, every jump in a chain is a move of its own, so a chain may be stopped early)
+ */
+struct EnglishRules
+{
+	static const GameVariant VARIANT = ENGLISH_CHECKERS;
+	static const int SIZE = 8;
+	static const int PLAYABLE_SQUARES = 32;
+	// the rows of men each side starts with
+	static const int STARTING_ROWS = 3;
+
+	// kings move (and jump) any distance along a diagonal
+	static const bool FLYING_KINGS = false;
+	// men may jump backward as well as forward
+	static const bool MEN_CAPTURE_BACKWARD = false;
+	// the capture taking the most pieces must be chosen, and only whole chains are moves
+	static const bool MAJORITY_CAPTURE = false;
+
+	typedef bitboard_t bitboard_type;
+	typedef CompactMove move_type;
+
+	static const char* getName() { return "english"; }
+};
+
+/**
+ * International draughts: 10x10 with 20 men a side, men move forward but jump in every
+ * direction, kings fly, and a side must take the chain that captures the most pieces.
+ * Captured pieces are only removed once the chain is over (so they can't be jumped twice,
+ * but still block), and a man only becomes a king if the move ends on the far row.
+ */
+struct InternationalRules
+{
+	static const GameVariant VARIANT = INTERNATIONAL_DRAUGHTS;
+	static const int SIZE = 10;
+	static const int PLAYABLE_SQUARES = 50;
+	static const int STARTING_ROWS = 4;
+
+	static const bool FLYING_KINGS = true;
+	static const bool MEN_CAPTURE_BACKWARD = true;
+	static const bool MAJORITY_CAPTURE = true;
+
+	typedef std::uint64_t bitboard_type;
+	typedef WideMove move_type;
+
+	static const char* getName() { return "international"; }
+};
+
+/**
+ * @return Returns the variant with the given name ("english" or "international", in any case),
+ * or ENGLISH_CHECKERS if the name is empty or unknown.
+ * @param name The name of the variant
+ */
+inline GameVariant getVariantFromName(std::string name)
+{
+	for (char& c : name)
+		c = (char)tolower((unsigned char)c);
+	return name == InternationalRules::getName() ? INTERNATIONAL_DRAUGHTS : ENGLISH_CHECKERS;
+}
+
+/**
+ * @return Returns the name of the given variant.
+ * @param variant The variant
+ */
+inline const char* getVariantName(GameVariant variant)
+{
+	return variant == INTERNATIONAL_DRAUGHTS ? InternationalRules::getName() : EnglishRules::getName();
+}
+
+#endif
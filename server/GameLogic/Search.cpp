@@ -0,0 +1,517 @@
+#include "Search.h"
+
+#include "Bitboard.h"
+#include "EndgameDatabase.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// more than any score a search can return, for the bounds of the first window
+static const int INFINITE_SCORE = Search::WIN_SCORE + 1;
+
+// scores beyond this are wins or losses, found by the search or the endgame database
+static const int KNOWN_RESULT_SCORE = Search::ENDGAME_WIN_SCORE - Search::MAX_ENDGAME_DISTANCE - Search::MAX_DEPTH - 1;
+
+// the order moves are searched in (see orderMoves): the previous best line's move, then
+// captures by how many pieces they take, then killers, then by history
+static const int PV_MOVE_ORDER = 1 << 30;
+static const int CAPTURE_ORDER = 1 << 24;
+static const int FIRST_KILLER_ORDER = 1 << 21;
+static const int SECOND_KILLER_ORDER = 1 << 20;
+// history counts are halved whenever one reaches this, so they stay below the killers
+static const int MAX_HISTORY = 1 << 19;
+
+/**
+ * @return Returns a score as stored in the transposition table. Wins and losses (including the
+ * endgame database's) are scored by how far they are from the root, but are stored by how far
+ * they are from the position itself, so they still mean the same thing when the position is
+ * reached at another ply.
+ * @param score The score, relative to the root
+ * @param ply The ply of the position
+ */
+static int scoreToTable(int score, int ply)
+{
+    if (score > KNOWN_RESULT_SCORE)
+        return score + ply;
+    if (score < -KNOWN_RESULT_SCORE)
+        return score - ply;
+    return score;
+}
+
+/**
+ * @return Returns a score from the transposition table, relative to the root again. (See scoreToTable)
+ * @param score The score, as stored
+ * @param ply The ply of the position
+ */
+static int scoreFromTable(int score, int ply)
+{
+    if (score > KNOWN_RESULT_SCORE)
+        return score - ply;
+    if (score < -KNOWN_RESULT_SCORE)
+        return score + ply;
+    return score;
+}
+
+/**
+ * Constructor for a searcher
+ * @param weights The weights of the static evaluation
+ * @param table The transposition table to use, which may be shared with other searches
+ * (or null to search without one)
+ * @param threadIndex Which of several searches of the same position this is (0 for the main one)
+ */
+Search::Search(const EvalWeights& weights, TranspositionTable* table, int threadIndex)
+    : weights(weights), table(table), endgames(nullptr), threadIndex(threadIndex), nodes(0), nextCheck(0), aborted(false),
+      stopRequested(false), stopSignal(nullptr),
+      tableProbes(0), tableHits(0), endgameHits(0)
+{
+    memset(history, 0, sizeof(history));
+    memset(gameHistoryFilter, 0, sizeof(gameHistoryFilter));
+}
+
+/**
+ * Sets the keys of the positions the game has already been through (oldest first),
+ * so the search treats going back to any of them as a draw.
+ * @param keys The Zobrist keys of the positions (see BasicBoard::getHash)
+ */
+void Search::setGameHistory(const std::vector<hashkey_t>& keys)
+{
+    gameHistory = keys;
+    memset(gameHistoryFilter, 0, sizeof(gameHistoryFilter));
+    for (hashkey_t key : gameHistory)
+        gameHistoryFilter[(key >> 6) & 63] |= (std::uint64_t)1 << (key & 63);
+}
+
+/**
+ * Searches for the best move of the side to move on the given board.
+ * @param start The position to search (it is copied, and not changed)
+ * @param searchLimits How deep, and for how many nodes or how long, to search
+ * @return Returns the best move found, with its score and expected line.
+ */
+SearchResult Search::run(const BasicBoard<EnglishRules>& start, const SearchLimits& searchLimits)
+{
+    limits = searchLimits;
+    limits.maxDepth = std::max(1, std::min(limits.maxDepth, (int)MAX_DEPTH));
+    startTime = std::chrono::steady_clock::now();
+    nodes = 0;
+    aborted = false;
+    stopRequested = false;
+    tableProbes = 0;
+    tableHits = 0;
+    endgameHits = 0;
+    previousPv.clear();
+
+    // killers only make sense in the position they were found in, but history carries over (fading)
+    for (int ply = 0; ply <= MAX_DEPTH; ply++)
+        killers[ply][0] = killers[ply][1] = CompactMove(0, 0);
+    for (int side = 0; side < 2; side++)
+        for (int from = 0; from < PLAYABLE_SQUARES; from++)
+            for (int to = 0; to < PLAYABLE_SQUARES; to++)
+                history[side][from][to] /= 8;
+
+    BasicBoard<EnglishRules> board = start;
+    SearchResult result;
+
+    MoveList rootMoves;
+    board.getAllLegalMoves(board.isWhiteToMove(), rootMoves);
+    if (rootMoves.empty())
+    {
+        result.score = -WIN_SCORE;
+        return result;
+    }
+    result.hasMove = true;
+    result.bestMove = rootMoves[0];
+    result.principalVariation.push_back(rootMoves[0]);
+
+    // with only one legal move there is nothing to decide
+    if (rootMoves.size() == 1)
+    {
+        result.score = evaluate(board);
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        return result;
+    }
+
+    // every other helper thread starts a ply deeper, so the threads spread over two depths at once
+    int firstDepth = std::min(limits.maxDepth, 1 + (threadIndex & 1));
+    for (int depth = firstDepth; depth <= limits.maxDepth; depth++)
+    {
+        // the first iteration always finishes, so there is always a searched move to play
+        nextCheck = depth == firstDepth ? UINT64_MAX : nodes + CHECK_INTERVAL;
+
+        int score = negamax(board, depth, 0, -INFINITE_SCORE, INFINITE_SCORE, true);
+        if (aborted)
+            break;
+
+        bool bestMoveChanged = depth > firstDepth && pv[0][0] != result.bestMove;
+        result.bestMove = pv[0][0];
+        result.score = score;
+        result.depth = depth;
+        previousPv.assign(pv[0], pv[0] + pvLength[0]);
+        result.principalVariation = previousPv;
+        TRACE_DEBUG("Search depth " << depth << ": score " << score << ", " << nodes << " nodes");
+
+        // a forced result seen all the way to the end won't change with more depth
+        if (isWinScore(score) && WIN_SCORE - std::abs(score) <= depth)
+            break;
+
+        // and when the endgame database has every position after the root, neither will anything else
+        if (endgames != nullptr && popCount(board.getOccupiedMask()) <= endgames->getMaxPieces())
+            break;
+
+        // the next iteration takes several times as long as this one, so don't start one that can't
+        // finish, but give a best move that just changed a little more time to settle
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        double softLimit = limits.softMilliseconds > 0 ? limits.softMilliseconds : limits.maxMilliseconds / 2.0;
+        if (limits.softMilliseconds > 0 && bestMoveChanged)
+            softLimit = softLimit * UNSTABLE_TIME_PERCENT / 100;
+        if (softLimit > 0 && elapsed > softLimit)
+            break;
+    }
+
+    if (table != nullptr)
+        table->addProbeCounts(tableProbes, tableHits);
+
+    result.nodes = nodes;
+    result.endgameHits = endgameHits;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return result;
+}
+
+/**
+ * Searches a position to the given depth.
+ * @param board The position (which is changed during the search, but put back)
+ * @param depth How many more plies to search
+ * @param ply How many plies from the root this position is
+ * @param alpha The score the side to move already has elsewhere
+ * @param beta The score the other side already has elsewhere (this search stops once it reaches it)
+ * @param onPv Whether this position is on the previous iteration's best line
+ * @return Returns the score of the position for the side to move.
+ */
+int Search::negamax(BasicBoard<EnglishRules>& board, int depth, int ply, int alpha, int beta, bool onPv)
+{
+    // past the full-width depth only captures are searched (the root always gets a full ply)
+    if (depth <= 0 && ply > 0)
+        return quiescence(board, ply, alpha, beta);
+
+    pvLength[ply] = ply;
+    nodes++;
+    lineKeys[ply] = board.getHash();
+
+    if (ply > 0)
+    {
+        if (isRepetition(ply))
+            return 0;
+        if (outOfBudget())
+            return 0;
+
+        int score;
+        if (probeEndgames(board, ply, score))
+        {
+            endgameHits++;
+            return score;
+        }
+    }
+
+    // a side with no moves (no pieces, or all of them blocked) has lost
+    bool isWhite = board.isWhiteToMove();
+    MoveList moves;
+    board.getAllLegalMoves(isWhite, moves);
+    if (moves.empty())
+        return -(WIN_SCORE - ply);
+
+    if (ply >= MAX_DEPTH)
+        return evaluate(board);
+
+    // a result stored for this position may already settle it (though never at the root, which needs a move)
+    std::uint32_t tableMove = 0;
+    TableEntry entry;
+    if (table != nullptr)
+    {
+        tableProbes++;
+        if (table->probe(board.getHash(), entry))
+        {
+            tableHits++;
+            tableMove = entry.move;
+            int score = scoreFromTable(entry.score, ply);
+            if (ply > 0 && entry.depth >= depth &&
+                (entry.bound == BOUND_EXACT || (entry.bound == BOUND_LOWER && score >= beta) ||
+                 (entry.bound == BOUND_UPPER && score <= alpha)))
+                return score;
+        }
+    }
+
+    bool followPv = onPv && ply < (int)previousPv.size();
+    CompactMove ordered[MoveList::CAPACITY];
+    orderMoves(moves, ordered, ply, isWhite, followPv ? TranspositionTable::getMoveKey(previousPv[ply]) : tableMove);
+
+    int alphaOriginal = alpha;
+    std::uint32_t bestMove = 0;
+    int best = -INFINITE_SCORE;
+    for (int i = 0; i < moves.size(); i++)
+    {
+        const CompactMove& move = ordered[i];
+        BasicBoard<EnglishRules>::undo_type undo = board.makeMove(move);
+        int score = -negamax(board, depth - 1, ply + 1, -beta, -alpha, followPv && i == 0);
+        board.unmakeMove(move, undo);
+
+        // an unfinished search's scores mean nothing
+        if (aborted)
+            return 0;
+
+        if (score > best)
+        {
+            best = score;
+            if (score > alpha)
+            {
+                alpha = score;
+                bestMove = TranspositionTable::getMoveKey(move);
+                updatePv(move, ply);
+
+                if (alpha >= beta)
+                {
+                    if (!move.isJump())
+                        recordCutoff(move, ply, depth, isWhite);
+                    break;
+                }
+            }
+        }
+    }
+
+    if (table != nullptr)
+    {
+        TableBound bound = best <= alphaOriginal ? BOUND_UPPER : best >= beta ? BOUND_LOWER : BOUND_EXACT;
+        table->store(board.getHash(), bestMove, scoreToTable(best, ply), depth, bound);
+    }
+    return best;
+}
+
+/**
+ * Searches only the captures from a position, until the side to move has none.
+ * @param board The position (which is changed during the search, but put back)
+ * @param ply How many plies from the root this position is
+ * @param alpha The score the side to move already has elsewhere
+ * @param beta The score the other side already has elsewhere (this search stops once it reaches it)
+ * @return Returns the score of the position for the side to move.
+ */
+int Search::quiescence(BasicBoard<EnglishRules>& board, int ply, int alpha, int beta)
+{
+    pvLength[ply] = ply;
+    nodes++;
+    lineKeys[ply] = board.getHash();
+
+    if (isRepetition(ply))
+        return 0;
+    if (outOfBudget())
+        return 0;
+
+    int score;
+    if (probeEndgames(board, ply, score))
+    {
+        endgameHits++;
+        return score;
+    }
+
+    // a quiet position is scored as it stands (unless the side to move has no moves at all, and so has lost)
+    bool isWhite = board.isWhiteToMove();
+    if (!board.hasAnyCapture(isWhite) || ply >= MAX_DEPTH)
+    {
+        MoveList moves;
+        board.getAllLegalMoves(isWhite, moves);
+        return moves.empty() ? -(WIN_SCORE - ply) : evaluate(board);
+    }
+
+    // captures are forced, so there is no standing pat: the position is worth its best capture
+    MoveList captures;
+    board.getAllCaptures(isWhite, captures);
+    CompactMove ordered[MoveList::CAPACITY];
+    orderMoves(captures, ordered, ply, isWhite, 0);
+
+    int best = -INFINITE_SCORE;
+    for (int i = 0; i < captures.size(); i++)
+    {
+        const CompactMove& move = ordered[i];
+        BasicBoard<EnglishRules>::undo_type undo = board.makeMove(move);
+        score = -quiescence(board, ply + 1, -beta, -alpha);
+        board.unmakeMove(move, undo);
+
+        if (aborted)
+            return 0;
+
+        if (score > best)
+        {
+            best = score;
+            if (score > alpha)
+            {
+                alpha = score;
+                updatePv(move, ply);
+                if (alpha >= beta)
+                    break;
+            }
+        }
+    }
+    return best;
+}
+
+/**
+ * Makes a move the best line from its ply, followed by the best line found below it.
+ * @param move The move
+ * @param ply The ply it was played at
+ */
+void Search::updatePv(const CompactMove& move, int ply)
+{
+    pv[ply][ply] = move;
+    for (int next = ply + 1; next < pvLength[ply + 1]; next++)
+        pv[ply][next] = pv[ply + 1][next];
+    pvLength[ply] = std::max(pvLength[ply + 1], ply + 1);
+}
+
+/**
+ * @return Returns the static evaluation of a position, for the side to move.
+ * @param board The position
+ */
+int Search::evaluate(const BasicBoard<EnglishRules>& board) const
+{
+    int score = Evaluator::evaluate(board, weights);
+    return board.isWhiteToMove() ? score : -score;
+}
+
+/**
+ * Looks a position up in the endgame database.
+ * @param board The position
+ * @param ply How many plies from the root it is
+ * @param score Set to its score for the side to move, if it was found
+ * @return Returns true if the database has the position.
+ */
+bool Search::probeEndgames(const BasicBoard<EnglishRules>& board, int ply, int& score) const
+{
+    if (endgames == nullptr || popCount(board.getOccupiedMask()) > endgames->getMaxPieces())
+        return false;
+
+    int distance = 0;
+    switch (endgames->probe(board, &distance))
+    {
+        case ENDGAME_WIN:
+            score = ENDGAME_WIN_SCORE - ply - std::min(distance, (int)MAX_ENDGAME_DISTANCE);
+            return true;
+        case ENDGAME_LOSS:
+            score = -(ENDGAME_WIN_SCORE - ply - std::min(distance, (int)MAX_ENDGAME_DISTANCE));
+            return true;
+        case ENDGAME_DRAW:
+            score = 0;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @return Returns true if the position at the given ply already came up earlier in the line or the game.
+ * @param ply How many plies from the root the position is (its key must be in lineKeys)
+ */
+bool Search::isRepetition(int ply) const
+{
+    // the key includes the side to move, so only every other position can match
+    hashkey_t key = lineKeys[ply];
+    for (int earlier = ply - 2; earlier >= 0; earlier -= 2)
+    {
+        if (lineKeys[earlier] == key)
+            return true;
+    }
+    if (!(gameHistoryFilter[(key >> 6) & 63] & ((std::uint64_t)1 << (key & 63))))
+        return false;
+    return std::find(gameHistory.begin(), gameHistory.end(), key) != gameHistory.end();
+}
+
+/**
+ * Puts the moves in the order they should be searched: the previous best line's move
+ * (or the table's best move), then the longest captures, then killers, then by history.
+ * @param moves The moves, as generated
+ * @param ordered The array to write the ordered moves to (moves.size() long)
+ * @param ply The ply of the position
+ * @param isWhite The side to move
+ * @param firstMove The move key (see TranspositionTable::getMoveKey) of the move to search first, or 0 for none
+ */
+void Search::orderMoves(const MoveList& moves, CompactMove* ordered, int ply, bool isWhite, std::uint32_t firstMove) const
+{
+    int keys[MoveList::CAPACITY];
+    for (int i = 0; i < moves.size(); i++)
+    {
+        const CompactMove& move = moves[i];
+        int key;
+        if (firstMove != 0 && TranspositionTable::getMoveKey(move) == firstMove)
+            key = PV_MOVE_ORDER;
+        else if (move.isJump())
+            key = CAPTURE_ORDER + popCount(move.getCaptureMask());
+        else if (move == killers[ply][0])
+            key = FIRST_KILLER_ORDER;
+        else if (move == killers[ply][1])
+            key = SECOND_KILLER_ORDER;
+        else
+        {
+            key = history[isWhite][move.getFrom()][move.getTo()];
+
+            // helper threads break ties (and near ties) between quiet moves their own way
+            if (threadIndex > 0)
+                key += (int)(((TranspositionTable::getMoveKey(move) ^ (std::uint32_t)threadIndex) * 2654435761u) >> 28);
+        }
+
+        // insertion sort, since there are rarely more than a dozen moves
+        int j = i;
+        for (; j > 0 && keys[j - 1] < key; j--)
+        {
+            keys[j] = keys[j - 1];
+            ordered[j] = ordered[j - 1];
+        }
+        keys[j] = key;
+        ordered[j] = move;
+    }
+}
+
+/**
+ * Remembers a quiet move that caused a cutoff, so it is tried early elsewhere.
+ * @param move The move
+ * @param ply The ply it was played at
+ * @param depth The depth it was searched to
+ * @param isWhite The side that played it
+ */
+void Search::recordCutoff(const CompactMove& move, int ply, int depth, bool isWhite)
+{
+    if (killers[ply][0] != move)
+    {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+
+    int& count = history[isWhite][move.getFrom()][move.getTo()];
+    count += depth * depth;
+    if (count >= MAX_HISTORY)
+    {
+        for (int from = 0; from < PLAYABLE_SQUARES; from++)
+            for (int to = 0; to < PLAYABLE_SQUARES; to++)
+                history[isWhite][from][to] /= 2;
+    }
+}
+
+/**
+ * @return Returns true if the search has used up its nodes or time, or been asked to stop.
+ * (Only looks at the clock every CHECK_INTERVAL nodes)
+ */
+bool Search::outOfBudget()
+{
+    if (aborted)
+        return true;
+    if (nodes < nextCheck)
+        return false;
+    nextCheck = nodes + CHECK_INTERVAL;
+
+    if (stopRequested || (stopSignal != nullptr && stopSignal->load(std::memory_order_relaxed)) ||
+        (limits.maxNodes > 0 && nodes >= limits.maxNodes))
+        aborted = true;
+    else if (limits.maxMilliseconds > 0)
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+        aborted = elapsed.count() >= limits.maxMilliseconds;
+    }
+    return aborted;
+}
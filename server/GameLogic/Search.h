@@ -0,0 +1,282 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "Typedefs.h"
+#include "BasicBoard.h"
+#include "CompactMove.h"
+#include "MoveList.h"
+#include "Evaluation.h"
+#include "TranspositionTable.h"
+
+class EndgameDatabase;
+
+/**
+ * How much a search may do. It deepens one ply at a time until it finishes maxDepth,
+ * or until it runs out of nodes or time (checked every few thousand nodes), whichever comes first.
+ * (See TimeManager.h for time limits worked out from a clock)
+ */
+struct SearchLimits
+{
+	// the deepest iteration to search, in plies (at most Search::MAX_DEPTH)
+	int maxDepth = 64;
+	// stop after about this many nodes (0 for no limit)
+	std::uint64_t maxNodes = 0;
+	// stop after about this many milliseconds, even in the middle of an iteration (0 for no limit)
+	int maxMilliseconds = 0;
+	// start no new iteration after this many milliseconds, or a little later while the best move
+	// keeps changing (0 to start none past half of maxMilliseconds)
+	int softMilliseconds = 0;
+};
+
+/**
+ * What a search found.
+ */
+struct SearchResult
+{
+	// false only if the side to move has no legal moves (and so has lost)
+	bool hasMove = false;
+	CompactMove bestMove;
+	// the score of the best move for the side to move, in hundredths of a man (see Search::isWinScore)
+	int score = 0;
+	// the deepest iteration that was finished
+	int depth = 0;
+	std::uint64_t nodes = 0;
+	// how many of the nodes were looked up in the endgame database
+	std::uint64_t endgameHits = 0;
+	double seconds = 0;
+	// the moves both sides are expected to play, starting with bestMove
+	std::vector<CompactMove> principalVariation;
+};
+
+/**
+ * An alpha-beta searcher for the 8x8 game: negamax with iterative deepening, scoring the
+ * positions at the end of each line with the static evaluator (see Evaluation.h).
+ *
+ * A line doesn't end in the middle of an exchange: past the iteration's depth, the search
+ * goes on through captures only (quiescence search) until the side to move has none, and only
+ * that quiet position is evaluated. A side that can capture must, so it can't stand pat on its
+ * evaluation the way a chess engine's quiescence search would; it gets the best of its captures.
+ *
+ * Each iteration searches the previous one's best line first, and moves that caused cutoffs
+ * elsewhere (killer and history moves) early, so most of the tree is cut off. Positions that
+ * repeat one earlier in the line (or in the game, see setGameHistory) are scored as draws.
+ * With a transposition table (see TranspositionTable.h), positions reached again by another
+ * order of moves, or searched by an earlier iteration, are looked up instead of searched
+ * again, and their best moves are tried first. (Whoever starts a search should call the
+ * table's newSearch first, so it knows which entries are out of date)
+ *
+ * With an endgame database (see EndgameDatabase.h), positions with few enough pieces are
+ * looked up rather than searched, so the search sees their results however far away the end
+ * of the game is.
+ *
+ * Several searches can share one table and search the same position at once (see
+ * ParallelSearch.h); the ones with a thread index above 0 start at a different depth and
+ * order their quiet moves slightly differently, so they don't all search the same tree.
+ *
+ * A Search keeps its own tables between moves, so it should only be used by one thread at a
+ * time, but stop() may be called from any thread.
+ */
+class Search
+{
+	public:
+		// the deepest a search can go, in plies
+		const static int MAX_DEPTH = 64;
+
+		// the score of a side that has already won; a win n plies away scores WIN_SCORE - n
+		const static int WIN_SCORE = 30000;
+
+		// the score of a position the endgame database says is won; a win the database says ends
+		// n plies after the position m plies away scores ENDGAME_WIN_SCORE - m - n (with n at
+		// most MAX_ENDGAME_DISTANCE), well above any evaluation and below any win the search sees
+		const static int ENDGAME_WIN_SCORE = 20000;
+		const static int MAX_ENDGAME_DISTANCE = 1000;
+
+		/**
+		 * Constructor for a searcher
+		 * @param weights The weights of the static evaluation
+		 * @param table The transposition table to use, which may be shared with other searches
+		 * (or null to search without one)
+		 * @param threadIndex Which of several searches of the same position this is (0 for the main one)
+		 */
+		Search(const EvalWeights& weights = EvalWeights(), TranspositionTable* table = nullptr, int threadIndex = 0);
+
+		/**
+		 * Sets the transposition table to use from the next search on.
+		 * @param table The table, which may be shared with other searches (or null to search without one)
+		 */
+		void setTable(TranspositionTable* table) { this->table = table; }
+
+		/**
+		 * Sets the endgame database to look positions up in from the next search on.
+		 * @param endgames The database, which may be shared with other searches (or null to search without one)
+		 */
+		void setEndgameDatabase(const EndgameDatabase* endgames) { this->endgames = endgames; }
+
+		/**
+		 * Searches for the best move of the side to move on the given board.
+		 * @param board The position to search (it is copied, and not changed)
+		 * @param limits How deep, and for how many nodes or how long, to search
+		 * @return Returns the best move found, with its score and expected line.
+		 */
+		SearchResult run(const BasicBoard<EnglishRules>& board, const SearchLimits& limits);
+
+		/**
+		 * Sets the keys of the positions the game has already been through (oldest first),
+		 * so the search treats going back to any of them as a draw.
+		 * @param keys The Zobrist keys of the positions (see BasicBoard::getHash)
+		 */
+		void setGameHistory(const std::vector<hashkey_t>& keys);
+
+		/**
+		 * Asks a running search to stop as soon as it can (it still returns the best move it has).
+		 * Safe to call from another thread.
+		 */
+		void stop() { stopRequested = true; }
+
+		/**
+		 * Sets a flag, shared with other threads, that also stops this search once set.
+		 * (Unlike stop(), the flag isn't reset when a search starts, so it can't be missed by a
+		 * search that starts after it was set)
+		 * @param signal The flag (or null for none), which must outlive the searches that use it
+		 */
+		void setStopSignal(const std::atomic<bool>* signal) { stopSignal = signal; }
+
+		/**
+		 * @return Returns true if the score is a win or loss found by the search, rather than an evaluation.
+		 * @param score The score
+		 */
+		static bool isWinScore(int score) { return score > WIN_SCORE - MAX_DEPTH - 1 || score < -(WIN_SCORE - MAX_DEPTH - 1); }
+
+		/**
+		 * @return Returns true if the score is a win or loss the endgame database found.
+		 * @param score The score
+		 */
+		static bool isEndgameScore(int score)
+		{
+			const int lowest = ENDGAME_WIN_SCORE - MAX_ENDGAME_DISTANCE - MAX_DEPTH;
+			return !isWinScore(score) && (score >= lowest || score <= -lowest);
+		}
+
+	private:
+		// how many nodes pass between checks of the clock
+		const static std::uint64_t CHECK_INTERVAL = 4096;
+		// how much longer than softMilliseconds iterations are started after the best move changes, in percent
+		const static int UNSTABLE_TIME_PERCENT = 150;
+
+		EvalWeights weights;
+		TranspositionTable* table;
+		const EndgameDatabase* endgames;
+		int threadIndex;
+		SearchLimits limits;
+		std::chrono::steady_clock::time_point startTime;
+		std::uint64_t nodes;
+		std::uint64_t nextCheck;
+		bool aborted;
+		std::atomic<bool> stopRequested;
+		const std::atomic<bool>* stopSignal;
+
+		// this search's transposition table lookups, added to the table's counters when it ends
+		std::uint64_t tableProbes;
+		std::uint64_t tableHits;
+		std::uint64_t endgameHits;
+
+		// the keys of the positions in the game before the search, and along the line being searched
+		std::vector<hashkey_t> gameHistory;
+		hashkey_t lineKeys[MAX_DEPTH + 1];
+		// a bit for the low bits of each key in gameHistory, so most positions are known
+		// not to be in the game without looking through it
+		std::uint64_t gameHistoryFilter[64];
+
+		// the best line found from each ply, built up as the search returns (pv[ply] starts at ply)
+		CompactMove pv[MAX_DEPTH + 1][MAX_DEPTH + 1];
+		int pvLength[MAX_DEPTH + 1];
+		// the best line of the last finished iteration, searched first by the next one
+		std::vector<CompactMove> previousPv;
+
+		// two quiet moves per ply that caused cutoffs, tried right after the captures
+		CompactMove killers[MAX_DEPTH + 1][2];
+		// how often each move (by side, from and to square) has caused cutoffs, weighted by depth
+		int history[2][PLAYABLE_SQUARES][PLAYABLE_SQUARES];
+
+		/**
+		 * Searches a position to the given depth.
+		 * @param board The position (which is changed during the search, but put back)
+		 * @param depth How many more plies to search
+		 * @param ply How many plies from the root this position is
+		 * @param alpha The score the side to move already has elsewhere
+		 * @param beta The score the other side already has elsewhere (this search stops once it reaches it)
+		 * @param onPv Whether this position is on the previous iteration's best line
+		 * @return Returns the score of the position for the side to move.
+		 */
+		int negamax(BasicBoard<EnglishRules>& board, int depth, int ply, int alpha, int beta, bool onPv);
+
+		/**
+		 * Searches only the captures from a position, until the side to move has none.
+		 * @param board The position (which is changed during the search, but put back)
+		 * @param ply How many plies from the root this position is
+		 * @param alpha The score the side to move already has elsewhere
+		 * @param beta The score the other side already has elsewhere (this search stops once it reaches it)
+		 * @return Returns the score of the position for the side to move.
+		 */
+		int quiescence(BasicBoard<EnglishRules>& board, int ply, int alpha, int beta);
+
+		/**
+		 * Makes a move the best line from its ply, followed by the best line found below it.
+		 * @param move The move
+		 * @param ply The ply it was played at
+		 */
+		void updatePv(const CompactMove& move, int ply);
+
+		/**
+		 * @return Returns the static evaluation of a position, for the side to move.
+		 * @param board The position
+		 */
+		int evaluate(const BasicBoard<EnglishRules>& board) const;
+
+		/**
+		 * Looks a position up in the endgame database.
+		 * @param board The position
+		 * @param ply How many plies from the root it is
+		 * @param score Set to its score for the side to move, if it was found
+		 * @return Returns true if the database has the position.
+		 */
+		bool probeEndgames(const BasicBoard<EnglishRules>& board, int ply, int& score) const;
+
+		/**
+		 * @return Returns true if the position at the given ply already came up earlier in the line or the game.
+		 * @param ply How many plies from the root the position is (its key must be in lineKeys)
+		 */
+		bool isRepetition(int ply) const;
+
+		/**
+		 * Puts the moves in the order they should be searched: the previous best line's move
+		 * (or the table's best move), then the longest captures, then killers, then by history.
+		 * @param moves The moves, as generated
+		 * @param ordered The array to write the ordered moves to (moves.size() long)
+		 * @param ply The ply of the position
+		 * @param isWhite The side to move
+		 * @param firstMove The move key (see TranspositionTable::getMoveKey) of the move to search first, or 0 for none
+		 */
+		void orderMoves(const MoveList& moves, CompactMove* ordered, int ply, bool isWhite, std::uint32_t firstMove) const;
+
+		/**
+		 * Remembers a quiet move that caused a cutoff, so it is tried early elsewhere.
+		 * @param move The move
+		 * @param ply The ply it was played at
+		 * @param depth The depth it was searched to
+		 * @param isWhite The side that played it
+		 */
+		void recordCutoff(const CompactMove& move, int ply, int depth, bool isWhite);
+
+		/**
+		 * @return Returns true if the search has used up its nodes or time, or been asked to stop.
+		 * (Only looks at the clock every CHECK_INTERVAL nodes)
+		 */
+		bool outOfBudget();
+};
+
+#endif
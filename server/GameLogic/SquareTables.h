@@ -0,0 +1,135 @@
+#ifndef SQUARE_TABLES_H
+#define SQUARE_TABLES_H
+
+#include "Typedefs.h"
+
+/**
+ * Tables of where every diagonal move from every playable square goes, worked out by the
+ * compiler, so move generation never does coordinate arithmetic or edge checks.
+ *
+ * Squares are the playable square numbers described in Bitboard.h, and directions are
+ * numbered as in CompactMove (bit 0 set means +x, bit 1 set means +y).
+ *
+ * The tables are built for any board size (BOARD_TABLES), and the functions below look in
+ * the ones for the 8x8 board.
+ *
+ * A move that would leave the board goes to NO_SQUARE, and its mask is empty. Since an empty
+ * mask never overlaps any pieces, tests like (opponents & getJumpOverMask(square, direction))
+ * are simply false over the edge, without checking for it.
+ */
+
+// where a step or jump over the edge of the board "goes"
+const int NO_SQUARE = -1;
+
+/**
+ * The tables for a board of SIZE x SIZE, with masks of type Bits (which needs a bit for
+ * each of the SIZE * SIZE / 2 playable squares).
+ */
+template <int SIZE, typename Bits>
+struct SquareTables
+{
+	static const int SQUARES = SIZE * SIZE / 2;
+
+	// the square one diagonal step away (which is also the square a jump passes over)
+	signed char step[SQUARES][4];
+	// the square a jump lands on, two diagonal steps away
+	signed char jumpLanding[SQUARES][4];
+
+	// the same squares as bitboards (empty for NO_SQUARE)
+	Bits stepMask[SQUARES][4];
+	Bits jumpLandingMask[SQUARES][4];
+};
+
+/**
+ * @return Returns the square at the given coordinates, or NO_SQUARE if they are off the board.
+ * (The coordinates are assumed to be those of a dark square, as every diagonal step from one is)
+ * @param x The x coordinate
+ * @param y The y coordinate
+ */
+template <int SIZE>
+constexpr int squareAt(int x, int y)
+{
+	return (x < 0 || x >= SIZE || y < 0 || y >= SIZE) ? NO_SQUARE : y * (SIZE / 2) + x / 2;
+}
+
+/**
+ * @return Returns the tables for every square and direction. (Only ever run by the compiler)
+ */
+template <int SIZE, typename Bits>
+constexpr SquareTables<SIZE, Bits> buildSquareTables()
+{
+	SquareTables<SIZE, Bits> tables = {};
+	for (int square = 0; square < SquareTables<SIZE, Bits>::SQUARES; square++)
+	{
+		int y = square / (SIZE / 2);
+		int x = 2 * (square % (SIZE / 2)) + y % 2;
+		for (int direction = 0; direction < 4; direction++)
+		{
+			int dx = (direction & 1) ? 1 : -1;
+			int dy = (direction & 2) ? 1 : -1;
+
+			int step = squareAt<SIZE>(x + dx, y + dy);
+			int landing = squareAt<SIZE>(x + 2 * dx, y + 2 * dy);
+			tables.step[square][direction] = (signed char)step;
+			tables.jumpLanding[square][direction] = (signed char)landing;
+			tables.stepMask[square][direction] = step == NO_SQUARE ? 0 : (Bits)1 << step;
+			tables.jumpLandingMask[square][direction] = landing == NO_SQUARE ? 0 : (Bits)1 << landing;
+		}
+	}
+	return tables;
+}
+
+// one set of tables for each board size used (see BasicBoard)
+template <int SIZE, typename Bits>
+inline constexpr SquareTables<SIZE, Bits> BOARD_TABLES = buildSquareTables<SIZE, Bits>();
+
+// the 8x8 tables, which the functions below look in
+inline constexpr const SquareTables<8, bitboard_t>& SQUARE_TABLES = BOARD_TABLES<8, bitboard_t>;
+
+/**
+ * @return Returns the square one diagonal step from a square, or NO_SQUARE over the edge.
+ * @param square The square to step from
+ * @param direction The direction, from 0 to 3
+ */
+constexpr int getStepSquare(int square, int direction) { return SQUARE_TABLES.step[square][direction]; }
+
+/**
+ * @return Returns the square a jump from a square passes over, or NO_SQUARE over the edge.
+ * @param square The square to jump from
+ * @param direction The direction, from 0 to 3
+ */
+constexpr int getJumpOverSquare(int square, int direction) { return SQUARE_TABLES.step[square][direction]; }
+
+/**
+ * @return Returns the square a jump from a square lands on, or NO_SQUARE over the edge.
+ * @param square The square to jump from
+ * @param direction The direction, from 0 to 3
+ */
+constexpr int getJumpLandingSquare(int square, int direction) { return SQUARE_TABLES.jumpLanding[square][direction]; }
+
+/**
+ * @return Returns getStepSquare as a bitboard (empty over the edge).
+ */
+constexpr bitboard_t getStepMask(int square, int direction) { return SQUARE_TABLES.stepMask[square][direction]; }
+
+/**
+ * @return Returns getJumpOverSquare as a bitboard (empty over the edge).
+ */
+constexpr bitboard_t getJumpOverMask(int square, int direction) { return SQUARE_TABLES.stepMask[square][direction]; }
+
+/**
+ * @return Returns getJumpLandingSquare as a bitboard (empty over the edge).
+ */
+constexpr bitboard_t getJumpLandingMask(int square, int direction) { return SQUARE_TABLES.jumpLandingMask[square][direction]; }
+
+// a few spot checks, so a mistake in the tables fails the build
+static_assert(getStepSquare(0, 3) == 4 && getStepSquare(0, 2) == NO_SQUARE, "square 0 steps");
+static_assert(getJumpLandingSquare(0, 3) == 9 && getJumpOverSquare(0, 3) == 4, "square 0 jumps");
+static_assert(getStepSquare(31, 0) == 27 && getJumpLandingSquare(31, 0) == 22, "square 31 moves");
+static_assert(getJumpLandingMask(4, 0) == 0 && getStepMask(4, 1) == ((bitboard_t)1 << 1), "square 4 edges");
+static_assert(BOARD_TABLES<10, std::uint64_t>.step[0][3] == 5 && BOARD_TABLES<10, std::uint64_t>.jumpLanding[0][3] == 11,
+			  "10x10 square 0 moves");
+static_assert(BOARD_TABLES<10, std::uint64_t>.jumpLanding[49][0] == 38 &&
+			  BOARD_TABLES<10, std::uint64_t>.stepMask[49][1] == 0, "10x10 square 49 moves");
+
+#endif
@@ -0,0 +1,61 @@
+#include "TimeManager.h"
+
+#include "Bitboard.h"
+#include "MoveList.h"
+
+#include <algorithm>
+
+/**
+ * Works out the time limits of a search for a move.
+ * @param clock The clock of the side to move
+ * @param board The position it is to move in
+ * @param limits The limits to start from (their depth and node limits are kept)
+ * @return Returns the limits with the soft and hard time limits set for the move.
+ */
+SearchLimits TimeManager::allocate(const GameClock& clock, const BasicBoard<EnglishRules>& board,
+                                   const SearchLimits& limits) const
+{
+    SearchLimits result = limits;
+
+    // (a clock that has run out still gets a moment, rather than no limit at all)
+    int usable = std::max(1, clock.remainingMilliseconds - overhead);
+    int increment = std::max(0, clock.incrementMilliseconds);
+
+    // the share of the clock for this move, plus most of the increment it gets back
+    double target = (double)usable / estimateMovesLeft(clock, board) + increment * 3 / 4.0;
+
+    // how much there is to think about
+    MoveList moves;
+    board.getAllLegalMoves(board.isWhiteToMove(), moves);
+    if (moves.size() <= 1)
+        target = 1;
+    else if (moves[0].isJump())
+        target *= 0.7;
+    else
+        target *= 0.8 + 0.05 * std::min(moves.size(), 12);
+
+    // the deadline leaves room for a search that runs long, but not at the cost of later moves
+    int hard = (int)std::min(target * HARD_LIMIT_FACTOR, (double)usable / HARD_LIMIT_SHARE + increment);
+    hard = std::max(1, std::min(hard, usable));
+    result.maxMilliseconds = hard;
+
+    // an iteration takes about as long as all the ones before it, so the last one started
+    // halfway through the target ends about on it
+    result.softMilliseconds = std::max(1, std::min(hard, (int)(target / 2)));
+    return result;
+}
+
+/**
+ * @return Returns how many more moves the side to move can expect to play.
+ * @param clock Its clock
+ * @param board The position
+ */
+int TimeManager::estimateMovesLeft(const GameClock& clock, const BasicBoard<EnglishRules>& board)
+{
+    // a game with most of its pieces has most of its moves ahead of it
+    int pieces = popCount(board.getOccupiedMask());
+    int movesLeft = std::max((int)MIN_MOVES_LEFT, std::min((int)MAX_MOVES_LEFT, 8 + pieces * 3 / 2));
+    if (clock.movesToGo > 0)
+        movesLeft = std::min(movesLeft, clock.movesToGo);
+    return movesLeft;
+}
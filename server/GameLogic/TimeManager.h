@@ -0,0 +1,76 @@
+#ifndef TIME_MANAGER_H
+#define TIME_MANAGER_H
+
+#include "Typedefs.h"
+#include "BasicBoard.h"
+#include "Search.h"
+
+/**
+ * A player's clock, as it stands when the player is to move.
+ */
+struct GameClock
+{
+	// the time the player has left, in milliseconds
+	int remainingMilliseconds = 0;
+	// the time added to the player's clock after each of its moves, in milliseconds
+	int incrementMilliseconds = 0;
+	// the moves until the next time control adds more time (0 if none does, so the rest of the
+	// game is played on what is left)
+	int movesToGo = 0;
+};
+
+/**
+ * Decides how long a search may take for a move, from the player's clock and the position.
+ *
+ * The time for a move is what is left on the clock shared among the moves the game can be
+ * expected to still last (fewer the fewer pieces are left), plus most of the increment, and
+ * scaled by how much there is to think about: a position with one legal move takes none at
+ * all, forced captures less than usual, and many quiet moves to choose from more. The search
+ * is given two limits from that (see SearchLimits): after the soft one it starts no new
+ * iteration, so it usually stops at an iteration boundary having used about the time meant for
+ * the move, and the hard one is a deadline it is stopped at wherever it is (checked every few
+ * thousand nodes), so no move ever takes more than a small part of what is left.
+ */
+class TimeManager
+{
+	public:
+		// the time kept back from every move for getting it to the other player, in milliseconds
+		const static int DEFAULT_OVERHEAD_MILLISECONDS = 30;
+
+		/**
+		 * Constructor for a time manager
+		 * @param overheadMilliseconds The time to keep back from every move for getting it to
+		 * the other player (and anything else that happens outside the search)
+		 */
+		explicit TimeManager(int overheadMilliseconds = DEFAULT_OVERHEAD_MILLISECONDS) : overhead(overheadMilliseconds) {}
+
+		/**
+		 * Works out the time limits of a search for a move.
+		 * @param clock The clock of the side to move
+		 * @param board The position it is to move in
+		 * @param limits The limits to start from (their depth and node limits are kept)
+		 * @return Returns the limits with the soft and hard time limits set for the move.
+		 */
+		SearchLimits allocate(const GameClock& clock, const BasicBoard<EnglishRules>& board,
+		                      const SearchLimits& limits = SearchLimits()) const;
+
+		/**
+		 * @return Returns how many more moves the side to move can expect to play.
+		 * @param clock Its clock
+		 * @param board The position
+		 */
+		static int estimateMovesLeft(const GameClock& clock, const BasicBoard<EnglishRules>& board);
+
+	private:
+		int overhead;
+
+		// the fewest and most moves a game is expected to still last
+		const static int MIN_MOVES_LEFT = 12;
+		const static int MAX_MOVES_LEFT = 40;
+		// the hard limit is this many times the time meant for the move...
+		const static int HARD_LIMIT_FACTOR = 4;
+		// ...but never more than this part of what is left on the clock
+		const static int HARD_LIMIT_SHARE = 5;
+};
+
+#endif
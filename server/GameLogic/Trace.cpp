@@ -0,0 +1,286 @@
+#include "Trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// how many traces each thread can have waiting, and how long each one can be
+static const unsigned TRACE_BUFFER_ENTRIES = 1024;
+static const int TRACE_TEXT_SIZE = 240;
+
+// how often the background thread drains the buffers, when nobody asks it to sooner
+static const std::chrono::milliseconds DRAIN_INTERVAL(10);
+
+/**
+ * One trace, waiting to be written out.
+ */
+struct TraceEntry
+{
+    std::uint64_t sequence;
+    int level;
+    int length;
+    char text[TRACE_TEXT_SIZE];
+};
+
+/**
+ * One thread's ring buffer of traces. Only the owning thread adds entries (at head), and only the
+ * background thread removes them (at tail), so neither ever has to lock.
+ */
+struct TraceBuffer
+{
+    TraceEntry entries[TRACE_BUFFER_ENTRIES];
+    std::atomic<unsigned> head{0};
+    std::atomic<unsigned> tail{0};
+    std::atomic<unsigned> dropped{0};
+
+    // set once the owning thread has exited, so the buffer can be let go when empty
+    std::atomic<bool> retired{false};
+};
+
+// every trace takes the next number, so traces from different threads are written in order
+static std::atomic<std::uint64_t> nextSequence(0);
+
+/**
+ * The background thread which drains every thread's buffer and writes the traces out.
+ */
+class TraceWriter
+{
+public:
+    static TraceWriter &get()
+    {
+        static TraceWriter writer;
+        return writer;
+    }
+
+    void addBuffer(const std::shared_ptr<TraceBuffer> &buffer)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.push_back(buffer);
+    }
+
+    // asks for a drain now rather than at the next interval
+    void wake() { wakeUp.notify_one(); }
+
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        // wait for a whole pass that starts after this call
+        unsigned long target = passesStarted + 1;
+        flushRequested = true;
+        wakeUp.notify_one();
+        passDone.wait(lock, [&]() { return passesFinished >= target || stopped; });
+    }
+
+    ~TraceWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeUp.notify_one();
+        thread.join();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::condition_variable passDone;
+    std::vector<std::shared_ptr<TraceBuffer>> buffers;
+    bool flushRequested;
+    bool stopping;
+    bool stopped;
+    unsigned long passesStarted;
+    unsigned long passesFinished;
+
+    // only used by the background thread, and kept between passes to avoid allocating
+    std::vector<std::shared_ptr<TraceBuffer>> draining;
+    std::vector<std::pair<TraceBuffer *, unsigned>> drainedHeads;
+    std::vector<const TraceEntry *> pending;
+
+    std::thread thread;
+
+    TraceWriter()
+        : flushRequested(false), stopping(false), stopped(false), passesStarted(0), passesFinished(0),
+          thread(&TraceWriter::run, this)
+    {
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            wakeUp.wait_for(lock, DRAIN_INTERVAL, [&]() { return flushRequested || stopping; });
+            bool finalPass = stopping;
+            flushRequested = false;
+            passesStarted++;
+            draining = buffers;
+
+            lock.unlock();
+            drain();
+            lock.lock();
+
+            // let go of the buffers of threads that have exited, once everything in them is written
+            buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+                                         [](const std::shared_ptr<TraceBuffer> &buffer)
+                                         {
+                                             return buffer->retired.load() &&
+                                                    buffer->head.load() == buffer->tail.load();
+                                         }),
+                          buffers.end());
+            draining.clear();
+
+            passesFinished++;
+            if (finalPass)
+                stopped = true;
+            passDone.notify_all();
+            if (finalPass)
+                return;
+        }
+    }
+
+    void drain()
+    {
+        pending.clear();
+        drainedHeads.clear();
+        for (const std::shared_ptr<TraceBuffer> &buffer : draining)
+        {
+            unsigned tail = buffer->tail.load(std::memory_order_relaxed);
+            unsigned head = buffer->head.load(std::memory_order_acquire);
+            for (unsigned i = tail; i != head; i++)
+                pending.push_back(&buffer->entries[i % TRACE_BUFFER_ENTRIES]);
+            drainedHeads.push_back(std::make_pair(buffer.get(), head));
+
+            unsigned dropped = buffer->dropped.exchange(0);
+            if (dropped > 0)
+                fprintf(stderr, "[trace] %u traces dropped (the buffer was full)\n", dropped);
+        }
+
+        std::sort(pending.begin(), pending.end(),
+                  [](const TraceEntry *a, const TraceEntry *b) { return a->sequence < b->sequence; });
+
+        for (const TraceEntry *entry : pending)
+        {
+            FILE *out = entry->level <= TRACE_LEVEL_WARN ? stderr : stdout;
+            fwrite(entry->text, 1, entry->length, out);
+            if (entry->length == 0 || entry->text[entry->length - 1] != '\n')
+                fputc('\n', out);
+        }
+        if (!pending.empty())
+        {
+            fflush(stdout);
+            fflush(stderr);
+        }
+
+        // only now hand the entries back to their threads
+        for (const std::pair<TraceBuffer *, unsigned> &drained : drainedHeads)
+            drained.first->tail.store(drained.second, std::memory_order_release);
+    }
+};
+
+/**
+ * A stream buffer writing into a fixed array of characters, which stops (failing the stream)
+ * when the array is full.
+ */
+class TraceStreamBuffer : public std::streambuf
+{
+public:
+    void start(char *text, int size) { setp(text, text + size); }
+    int length() const { return (int)(pptr() - pbase()); }
+
+protected:
+    int_type overflow(int_type) override { return traits_type::eof(); }
+};
+
+/**
+ * Everything one thread needs to trace.
+ */
+struct ThreadTrace
+{
+    std::shared_ptr<TraceBuffer> buffer;
+    TraceStreamBuffer streamBuffer;
+    std::ostream stream;
+
+    // the entry being formatted, or overflowEntry if the buffer was full (and the trace will be dropped)
+    TraceEntry *current;
+    TraceEntry overflowEntry;
+
+    ThreadTrace() : buffer(std::make_shared<TraceBuffer>()), stream(&streamBuffer), current(nullptr)
+    {
+        TraceWriter::get().addBuffer(buffer);
+    }
+
+    ~ThreadTrace() { buffer->retired = true; }
+};
+
+static ThreadTrace &getThreadTrace()
+{
+    thread_local ThreadTrace trace;
+    return trace;
+}
+
+/**
+ * @return Returns this thread's stream for formatting a trace, which writes into the
+ * next free entry of this thread's ring buffer.
+ */
+std::ostream &Trace::getStream()
+{
+    ThreadTrace &trace = getThreadTrace();
+    TraceBuffer &buffer = *trace.buffer;
+
+    unsigned head = buffer.head.load(std::memory_order_relaxed);
+    if (head - buffer.tail.load(std::memory_order_acquire) < TRACE_BUFFER_ENTRIES)
+        trace.current = &buffer.entries[head % TRACE_BUFFER_ENTRIES];
+    else
+        trace.current = &trace.overflowEntry;
+
+    trace.streamBuffer.start(trace.current->text, TRACE_TEXT_SIZE);
+    trace.stream.clear();
+    return trace.stream;
+}
+
+/**
+ * Finishes the trace formatted with getStream(), handing it over to be written out.
+ * @param level The level of the trace (one of the TRACE_LEVEL_ values)
+ */
+void Trace::commit(int level)
+{
+    ThreadTrace &trace = getThreadTrace();
+    TraceBuffer &buffer = *trace.buffer;
+
+    if (trace.current == &trace.overflowEntry)
+    {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    trace.current->sequence = nextSequence.fetch_add(1, std::memory_order_relaxed);
+    trace.current->level = level;
+    trace.current->length = trace.streamBuffer.length();
+
+    unsigned head = buffer.head.load(std::memory_order_relaxed) + 1;
+    buffer.head.store(head, std::memory_order_release);
+
+    // don't wait for the next interval if this thread is about to run out of room
+    if (head - buffer.tail.load(std::memory_order_relaxed) == TRACE_BUFFER_ENTRIES * 3 / 4)
+        TraceWriter::get().wake();
+}
+
+/**
+ * Waits until every trace made so far has been written out.
+ * (Worth calling before exiting, or before writing to std::cout directly)
+ */
+void Trace::flush()
+{
+    TraceWriter::get().flush();
+}
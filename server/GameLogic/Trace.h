@@ -0,0 +1,90 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <ostream>
+
+/**
+ * Tracing for the game logic and the server, used instead of writing to std::cout directly.
+ *
+ * Which traces exist is decided when compiling: TRACE_LEVEL (set with -DTRACE_LEVEL=n) is the
+ * most detailed level kept, and every trace more detailed than that expands to nothing, so
+ * its message is never even formatted. Levels are:
+ *
+ *     0 - no traces at all
+ *     1 - TRACE_ERROR  (failures, written to stderr)
+ *     2 - TRACE_WARN   (also written to stderr)
+ *     3 - TRACE_INFO   (what the server is doing: connections, games, moves) - the default
+ *     4 - TRACE_DEBUG  (step by step detail, such as every square the move generator looks at)
+ *
+ * Traces that are kept are written as stream expressions, like:
+ *
+ *     TRACE_INFO("Player " << playerId << " joined game " << gameId);
+ *
+ * The message is formatted by the calling thread straight into a ring buffer owned by that thread,
+ * so tracing takes no locks, never waits on the terminal, and allocates nothing after a thread's
+ * first trace. A background thread drains every thread's buffer, in the order the traces were
+ * made, and writes them out a batch at a time.
+ * (Messages longer than a buffer entry are cut short, and if a thread traces faster than the
+ * buffers are drained, its newest traces are dropped and counted)
+ */
+
+#define TRACE_LEVEL_NONE 0
+#define TRACE_LEVEL_ERROR 1
+#define TRACE_LEVEL_WARN 2
+#define TRACE_LEVEL_INFO 3
+#define TRACE_LEVEL_DEBUG 4
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL TRACE_LEVEL_INFO
+#endif
+
+class Trace
+{
+	public:
+		/**
+		 * @return Returns this thread's stream for formatting a trace, which writes into the
+		 * next free entry of this thread's ring buffer.
+		 */
+		static std::ostream& getStream();
+
+		/**
+		 * Finishes the trace formatted with getStream(), handing it over to be written out.
+		 * @param level The level of the trace (one of the TRACE_LEVEL_ values)
+		 */
+		static void commit(int level);
+
+		/**
+		 * Waits until every trace made so far has been written out.
+		 * (Worth calling before exiting, or before writing to std::cout directly)
+		 */
+		static void flush();
+};
+
+#define TRACE_WRITE(level, message) \
+	do { Trace::getStream() << message; Trace::commit(level); } while (0)
+
+#if TRACE_LEVEL >= TRACE_LEVEL_ERROR
+#define TRACE_ERROR(message) TRACE_WRITE(TRACE_LEVEL_ERROR, message)
+#else
+#define TRACE_ERROR(message) ((void)0)
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_WARN
+#define TRACE_WARN(message) TRACE_WRITE(TRACE_LEVEL_WARN, message)
+#else
+#define TRACE_WARN(message) ((void)0)
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_INFO
+#define TRACE_INFO(message) TRACE_WRITE(TRACE_LEVEL_INFO, message)
+#else
+#define TRACE_INFO(message) ((void)0)
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_DEBUG
+#define TRACE_DEBUG(message) TRACE_WRITE(TRACE_LEVEL_DEBUG, message)
+#else
+#define TRACE_DEBUG(message) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,155 @@
+#include "TranspositionTable.h"
+
+#include <algorithm>
+
+static_assert(sizeof(std::atomic<std::uint64_t>) == 8, "table entries must be sixteen bytes");
+
+/**
+ * Constructor for a table of (at most) the given size.
+ * @param megabytes The size of the table, in megabytes (0 for a table that stores nothing)
+ */
+TranspositionTable::TranspositionTable(std::size_t megabytes)
+    : bucketMask(0), generation(0), probeCount(0), hitCount(0)
+{
+    resize(megabytes);
+}
+
+/**
+ * Reallocates the table to (at most) the given size, emptying it.
+ * @param megabytes The size of the table, in megabytes (0 for a table that stores nothing)
+ */
+void TranspositionTable::resize(std::size_t megabytes)
+{
+    // the largest power of two number of buckets that fits, so a key's bucket is just its low bits
+    std::size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024)
+        count *= 2;
+
+    buckets = std::vector<Bucket>(megabytes > 0 ? count : 0);
+    bucketMask = count - 1;
+    clear();
+}
+
+/**
+ * Empties the table, and resets its counters.
+ */
+void TranspositionTable::clear()
+{
+    for (Bucket& bucket : buckets)
+    {
+        for (Entry& entry : bucket.entries)
+        {
+            entry.check.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+    probeCount = 0;
+    hitCount = 0;
+}
+
+/**
+ * Looks up a position.
+ * @param key The Zobrist key of the position
+ * @param entry The entry to fill in, if the position is found
+ * @return Returns true if the position was found.
+ */
+bool TranspositionTable::probe(hashkey_t key, TableEntry& entry) const
+{
+    if (buckets.empty())
+        return false;
+
+    const Bucket& bucket = buckets[key & bucketMask];
+    for (const Entry& slot : bucket.entries)
+    {
+        std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+        std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if ((check ^ data) != key || getBound(data) == BOUND_NONE)
+            continue;
+
+        entry.move = getMove(data);
+        entry.score = getScore(data);
+        entry.depth = getDepth(data);
+        entry.bound = getBound(data);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Stores the result of searching a position.
+ * @param key The Zobrist key of the position
+ * @param move The best move found, as a move key (or 0 for none, keeping any move already stored)
+ * @param score The score (which must fit in 16 bits)
+ * @param depth The depth searched, from 0 to 255
+ * @param bound What the score says about the real score
+ */
+void TranspositionTable::store(hashkey_t key, std::uint32_t move, int score, int depth, TableBound bound)
+{
+    if (buckets.empty())
+        return;
+
+    Bucket& bucket = buckets[key & bucketMask];
+    Entry* victim = nullptr;
+    int victimWorth = 0;
+    for (Entry& slot : bucket.entries)
+    {
+        std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+        std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+        // the same position is replaced, unless this result is only a bound from a much shallower
+        // search of it during this same search (and it keeps its move if this result has none)
+        if ((check ^ data) == key && getBound(data) != BOUND_NONE)
+        {
+            if (bound != BOUND_EXACT && depth + 3 < getDepth(data) && getAge(data) == generation)
+                return;
+            if (move == 0)
+                move = getMove(data);
+            victim = &slot;
+            break;
+        }
+
+        // otherwise the entry worth least: empty ones, then the shallowest, counting each
+        // search an entry is out of date as a few plies less
+        int worth = getBound(data) == BOUND_NONE ? -1000
+                                                 : getDepth(data) - 4 * (int)((generation - getAge(data)) & AGE_MASK);
+        if (victim == nullptr || worth < victimWorth)
+        {
+            victim = &slot;
+            victimWorth = worth;
+        }
+    }
+
+    std::uint64_t data = pack(move, score, depth, bound, generation);
+    victim->check.store(key ^ data, std::memory_order_relaxed);
+    victim->data.store(data, std::memory_order_relaxed);
+}
+
+/**
+ * @return Returns the fraction of lookups that found their position since the table was last cleared.
+ */
+double TranspositionTable::getHitRate() const
+{
+    std::uint64_t probes = probeCount.load(std::memory_order_relaxed);
+    return probes == 0 ? 0.0 : (double)hitCount.load(std::memory_order_relaxed) / probes;
+}
+
+/**
+ * @return Returns roughly how full the table is with results of the current search, in thousandths.
+ */
+int TranspositionTable::getUsagePermille() const
+{
+    // a sample of the first buckets is close enough
+    std::size_t sampled = std::min<std::size_t>(buckets.size(), 250);
+    int used = 0;
+    for (std::size_t i = 0; i < sampled; i++)
+    {
+        for (const Entry& slot : buckets[i].entries)
+        {
+            std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if (getBound(data) != BOUND_NONE && getAge(data) == generation)
+                used++;
+        }
+    }
+    return sampled == 0 ? 0 : (int)(used * 1000 / (sampled * ENTRIES_PER_BUCKET));
+}
@@ -0,0 +1,172 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Typedefs.h"
+#include "CompactMove.h"
+
+/**
+ * What a stored score says about the real score of a position.
+ */
+enum TableBound
+{
+	// nothing stored
+	BOUND_NONE = 0,
+	// the real score is at most this (no move reached alpha)
+	BOUND_UPPER = 1,
+	// the real score is at least this (a move reached beta)
+	BOUND_LOWER = 2,
+	// the real score is exactly this
+	BOUND_EXACT = 3
+};
+
+/**
+ * What the table holds for a position.
+ */
+struct TableEntry
+{
+	// the best move found, as a move key (see TranspositionTable::getMoveKey), or 0 for none
+	std::uint32_t move;
+	int score;
+	int depth;
+	TableBound bound;
+};
+
+/**
+ * A fixed-size table of search results, keyed by Zobrist key (see Zobrist.h), shared by
+ * every search thread without locks.
+ *
+ * Each entry is sixteen bytes: the key XORed with the entry's data, and the data itself
+ * (best move, score, depth, bound and the search it came from). A reader only accepts an
+ * entry if XORing the two halves back gives its own key, so an entry torn by two threads
+ * writing at once simply reads as a miss. Entries come in buckets of four, one cache line,
+ * and a key can be stored in any entry of its bucket: a new result replaces the same
+ * position if it is there, or otherwise the entry searched least deeply, counting entries
+ * left from earlier searches as shallower the older they are.
+ *
+ * resize and clear must not be called while any search is using the table.
+ */
+class TranspositionTable
+{
+	public:
+		/**
+		 * Constructor for a table of (at most) the given size.
+		 * @param megabytes The size of the table, in megabytes (0 for a table that stores nothing)
+		 */
+		explicit TranspositionTable(std::size_t megabytes = 16);
+
+		/**
+		 * Reallocates the table to (at most) the given size, emptying it.
+		 * @param megabytes The size of the table, in megabytes (0 for a table that stores nothing)
+		 */
+		void resize(std::size_t megabytes);
+
+		/**
+		 * Empties the table, and resets its counters.
+		 */
+		void clear();
+
+		/**
+		 * Starts a new search, so the results of earlier ones are replaced first.
+		 * (Like resize, this is called between searches, not during one)
+		 */
+		void newSearch() { generation = (generation + 1) & AGE_MASK; }
+
+		/**
+		 * Looks up a position.
+		 * @param key The Zobrist key of the position
+		 * @param entry The entry to fill in, if the position is found
+		 * @return Returns true if the position was found.
+		 */
+		bool probe(hashkey_t key, TableEntry& entry) const;
+
+		/**
+		 * Stores the result of searching a position.
+		 * @param key The Zobrist key of the position
+		 * @param move The best move found, as a move key (or 0 for none, keeping any move already stored)
+		 * @param score The score (which must fit in 16 bits)
+		 * @param depth The depth searched, from 0 to 255
+		 * @param bound What the score says about the real score
+		 */
+		void store(hashkey_t key, std::uint32_t move, int score, int depth, TableBound bound);
+
+		/**
+		 * Adds a search's lookups to the table's counters. (Searches count their own lookups and add
+		 * them once, so threads don't fight over the counters on every lookup)
+		 * @param probes The number of lookups
+		 * @param hits The number of those that found their position
+		 */
+		void addProbeCounts(std::uint64_t probes, std::uint64_t hits)
+		{
+			probeCount.fetch_add(probes, std::memory_order_relaxed);
+			hitCount.fetch_add(hits, std::memory_order_relaxed);
+		}
+
+		/**
+		 * @return Returns the fraction of lookups that found their position since the table was last cleared.
+		 */
+		double getHitRate() const;
+
+		/**
+		 * @return Returns roughly how full the table is with results of the current search, in thousandths.
+		 */
+		int getUsagePermille() const;
+
+		/**
+		 * @return Returns the size of the table, in bytes.
+		 */
+		std::size_t getSizeBytes() const { return buckets.size() * sizeof(Bucket); }
+
+		/**
+		 * @return Returns the key a move is stored under: its squares and jump path, which
+		 * together tell it apart from every other move in the same position. (Never 0, since a
+		 * move never starts and ends on the same square)
+		 * @param move The move
+		 */
+		static std::uint32_t getMoveKey(const CompactMove& move) { return (std::uint32_t)(move.toBits() >> 32); }
+
+	private:
+		const static int ENTRIES_PER_BUCKET = 4;
+		const static unsigned AGE_MASK = 63;
+
+		struct Entry
+		{
+			std::atomic<std::uint64_t> check{0};
+			std::atomic<std::uint64_t> data{0};
+		};
+
+		struct alignas(64) Bucket
+		{
+			Entry entries[ENTRIES_PER_BUCKET];
+		};
+
+		std::vector<Bucket> buckets;
+		std::size_t bucketMask;
+		unsigned generation;
+
+		std::atomic<std::uint64_t> probeCount;
+		std::atomic<std::uint64_t> hitCount;
+
+		/**
+		 * @return Returns an entry's data packed into 64 bits: the move in the top half, then the score,
+		 * depth, bound and search generation.
+		 */
+		static std::uint64_t pack(std::uint32_t move, int score, int depth, TableBound bound, unsigned age)
+		{
+			return ((std::uint64_t)move << 32) | ((std::uint64_t)(std::uint16_t)(std::int16_t)score << 16) |
+			       ((std::uint64_t)(depth & 0xff) << 8) | ((std::uint64_t)bound << 6) | (age & AGE_MASK);
+		}
+
+		static std::uint32_t getMove(std::uint64_t data) { return (std::uint32_t)(data >> 32); }
+		static int getScore(std::uint64_t data) { return (std::int16_t)(std::uint16_t)(data >> 16); }
+		static int getDepth(std::uint64_t data) { return (int)((data >> 8) & 0xff); }
+		static TableBound getBound(std::uint64_t data) { return (TableBound)((data >> 6) & 3); }
+		static unsigned getAge(std::uint64_t data) { return (unsigned)(data & AGE_MASK); }
+};
+
+static_assert(sizeof(CompactMove) == 8, "the table stores the top half of a CompactMove's bits");
+
+#endif
@@ -4,6 +4,7 @@
 #include <vector>
 #include <array>
 #include <memory>
+#include <cstdint>
 
 class Move;
 
@@ -23,4 +24,13 @@ typedef std::array<int, 2> coords_t;
 typedef std::vector<std::shared_ptr<Move>> moves_t;
 typedef std::shared_ptr<Move> move_ptr_t;
 
+// The board itself is stored as bitboards over the 32 playable (dark) squares,
+// so one bit per square fits exactly in a 32-bit integer.
+// (see Bitboard.h for the square numbering and helpers)
+typedef std::uint32_t bitboard_t;
+
+// Positions are identified by 64-bit Zobrist keys (see Zobrist.h),
+// which the board keeps up to date as moves are made.
+typedef std::uint64_t hashkey_t;
+
 #endif
@@ -0,0 +1,229 @@
+#ifndef VARIANT_BOARD_H
+#define VARIANT_BOARD_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Typedefs.h"
+#include "Rules.h"
+#include "BasicBoard.h"
+#include "MoveList.h"
+
+/**
+ * A legal move, as seen from outside the board: where it starts and ends, and what it captures.
+ */
+struct VariantMove
+{
+	int from;
+	int to;
+	bool isJump;
+	// the squares of the pieces it captures (which tell apart capture chains joining the same squares)
+	std::uint64_t captures;
+	// where it is in the list getLegalMoves made, so applyMove can make it without generating the moves again
+	int index;
+};
+
+/**
+ * A fixed-capacity list of VariantMoves, kept on the stack like the boards' own move lists.
+ */
+typedef BasicMoveList<VariantMove> VariantMoveList;
+
+/**
+ * A game board whose rules are chosen at run time, for code (like the server's game sessions)
+ * that has to hold games of either variant. Every call is passed on to a BasicBoard of the
+ * chosen rules, so only this thin layer is virtual, and the move generator underneath is the
+ * one compiled for those rules.
+ *
+ * Squares and bitboards are those of the chosen board (see Bitboard.h), with bitboards
+ * widened to 64 bits so they fit every size.
+ */
+class VariantBoard
+{
+	public:
+		virtual ~VariantBoard() {}
+
+		/**
+		 * @return Returns a new board, in the starting position, playing by the given variant's rules.
+		 * @param variant The variant to play
+		 */
+		static std::unique_ptr<VariantBoard> create(GameVariant variant);
+
+		/**
+		 * @return Returns the variant whose rules this board plays by.
+		 */
+		virtual GameVariant getVariant() const = 0;
+
+		/**
+		 * @return Returns the number of squares along each side of the board.
+		 */
+		virtual int getSize() const = 0;
+
+		/**
+		 * @return Returns the playable square at these coordinates, or -1 if they are off the board
+		 * or on a square that can't hold a piece.
+		 * @param x The x coordinate
+		 * @param y The y coordinate
+		 */
+		virtual int getSquareFromCoords(int x, int y) const = 0;
+
+		/**
+		 * @return Returns the x and y coordinates of a playable square.
+		 * @param square The square
+		 */
+		virtual coords_t getCoordsFromSquare(int square) const = 0;
+
+		/**
+		 * @return Returns the bitboard of all pieces (kings included) of the given color.
+		 * @param isWhite The color of the pieces
+		 */
+		virtual std::uint64_t getPieceMask(bool isWhite) const = 0;
+
+		/**
+		 * @return Returns the bitboard of all kings of the given color.
+		 * @param isWhite The color of the kings
+		 */
+		virtual std::uint64_t getKingMask(bool isWhite) const = 0;
+
+		/**
+		 * @return Returns the number of pieces (kings included) of the given color.
+		 * @param isWhite The color of the pieces
+		 */
+		virtual int getPieceCount(bool isWhite) const = 0;
+
+		/**
+		 * @return Returns true if any piece of the given side can jump.
+		 * @param isWhite The side to check
+		 */
+		virtual bool hasAnyCapture(bool isWhite) const = 0;
+
+		/**
+		 * @return Returns the Zobrist key of the position (see BasicBoard::getHash).
+		 */
+		virtual hashkey_t getHash() const = 0;
+
+		/**
+		 * Lists every legal move for one side. (Captures are mandatory, so if any jump is
+		 * available only the jumps are listed)
+		 * @param isWhite The side to list the moves of
+		 * @param moves The list to fill (it is cleared first)
+		 */
+		virtual void getLegalMoves(bool isWhite, VariantMoveList& moves) const = 0;
+
+		/**
+		 * Makes the legal move of the given side that starts, ends and captures as the given one does, if there is one.
+		 * A move from the last getLegalMoves of this position is made straight from that list; any
+		 * other is looked for among the legal moves.
+		 * @param isWhite The side making the move
+		 * @param move The move (as getLegalMoves lists it)
+		 * @return Returns true if the move was legal, and so was made.
+		 */
+		virtual bool applyMove(bool isWhite, const VariantMove& move) = 0;
+
+		/**
+		 * Moves a piece from one square to another without checking the move is legal
+		 * (or capturing anything). The piece is still crowned if it ends on the far row.
+		 * @param fromSquare The square of the piece to move
+		 * @param toSquare The square to put it on
+		 */
+		virtual void forceMove(int fromSquare, int toSquare) = 0;
+};
+
+/**
+ * A VariantBoard holding a BasicBoard of the given rules.
+ */
+template <class Rules>
+class VariantBoardOf : public VariantBoard
+{
+	public:
+		typedef BasicBoard<Rules> board_type;
+
+		/**
+		 * @return Returns the board itself, for callers that know which rules it plays by.
+		 */
+		const board_type& getBoard() const { return board; }
+
+		GameVariant getVariant() const override { return Rules::VARIANT; }
+		int getSize() const override { return Rules::SIZE; }
+		int getSquareFromCoords(int x, int y) const override { return board_type::getSquareFromCoords(x, y); }
+		coords_t getCoordsFromSquare(int square) const override { return board_type::getCoordsFromSquare(square); }
+		std::uint64_t getPieceMask(bool isWhite) const override { return board.getPieceMask(isWhite); }
+		std::uint64_t getKingMask(bool isWhite) const override { return board.getKingMask(isWhite); }
+		int getPieceCount(bool isWhite) const override { return board.getPieceCount(isWhite); }
+		bool hasAnyCapture(bool isWhite) const override { return board.hasAnyCapture(isWhite); }
+		hashkey_t getHash() const override { return board.getHash(); }
+
+		void getLegalMoves(bool isWhite, VariantMoveList& moves) const override
+		{
+			listedMoves.clear();
+			board.getAllLegalMoves(isWhite, listedMoves);
+			listedHash = board.getHash();
+			listedWhite = isWhite;
+			hasListedMoves = true;
+
+			moves.clear();
+			for (int i = 0; i < listedMoves.size(); i++)
+			{
+				const typename board_type::move_type& move = listedMoves[i];
+				moves.push_back(VariantMove{ move.getFrom(), move.getTo(), move.isJump(), move.getCaptureMask(), i });
+			}
+		}
+
+		bool applyMove(bool isWhite, const VariantMove& variantMove) override
+		{
+			// the move getLegalMoves listed for this very position, if it still has it
+			if (!hasListedMoves || listedHash != board.getHash() || listedWhite != isWhite ||
+			    variantMove.index < 0 || variantMove.index >= listedMoves.size() ||
+			    !matches(listedMoves[variantMove.index], variantMove))
+			{
+				typename board_type::move_list_type legalMoves;
+				board.getAllLegalMoves(isWhite, legalMoves);
+				for (const typename board_type::move_type& move : legalMoves)
+				{
+					if (matches(move, variantMove))
+					{
+						board.makeMove(move);
+						hasListedMoves = false;
+						return true;
+					}
+				}
+				return false;
+			}
+			board.makeMove(listedMoves[variantMove.index]);
+			hasListedMoves = false;
+			return true;
+		}
+
+		void forceMove(int fromSquare, int toSquare) override
+		{
+			board.makeMove(typename board_type::move_type(fromSquare, toSquare));
+			hasListedMoves = false;
+		}
+
+	private:
+		board_type board;
+
+		// the moves getLegalMoves last listed, and the position and side it listed them for
+		mutable typename board_type::move_list_type listedMoves;
+		mutable hashkey_t listedHash = 0;
+		mutable bool listedWhite = false;
+		mutable bool hasListedMoves = false;
+
+		static bool matches(const typename board_type::move_type& move, const VariantMove& variantMove)
+		{
+			return move.getFrom() == variantMove.from && move.getTo() == variantMove.to &&
+			       move.getCaptureMask() == variantMove.captures;
+		}
+};
+
+/**
+ * @return Returns a new board, in the starting position, playing by the given variant's rules.
+ * @param variant The variant to play
+ */
+inline std::unique_ptr<VariantBoard> VariantBoard::create(GameVariant variant)
+{
+	if (variant == INTERNATIONAL_DRAUGHTS)
+		return std::unique_ptr<VariantBoard>(new VariantBoardOf<InternationalRules>());
+	return std::unique_ptr<VariantBoard>(new VariantBoardOf<EnglishRules>());
+}
+
+#endif
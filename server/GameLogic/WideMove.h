@@ -0,0 +1,83 @@
+#ifndef WIDE_MOVE_H
+#define WIDE_MOVE_H
+
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * A complete move on a board with more than 32 playable squares (see Rules.h), packed into
+ * sixteen bytes: its starting and ending squares, and a 64-bit bitboard of every square it captures.
+ *
+ * Unlike CompactMove it keeps no path of jump directions, since a flying king can land anywhere
+ * along a diagonal. Under majority capture two moves are only different if they start, end or
+ * capture differently, so the path isn't needed to tell them apart or to apply them.
+ */
+class WideMove
+{
+	public:
+		// left uninitialized, so arrays of moves cost nothing to create
+		WideMove() = default;
+
+		/**
+		 * Constructor for a non-jumping move (or the start of a jumping one)
+		 * @param from The starting square
+		 * @param to The ending square
+		 */
+		WideMove(int from, int to) :
+			captures(0), from((std::uint8_t)from), to((std::uint8_t)to), jumpCount(0)
+			{};
+
+		/**
+		 * @return Returns a copy of this move extended by one more jump.
+		 * @param capturedSquare The square of the piece being jumped
+		 * @param landingSquare The square the jump lands on
+		 */
+		WideMove withCapture(int capturedSquare, int landingSquare) const
+		{
+			WideMove move = *this;
+			move.captures |= (std::uint64_t)1 << capturedSquare;
+			move.to = (std::uint8_t)landingSquare;
+			move.jumpCount++;
+			return move;
+		}
+
+		/**
+		 * @return Returns the starting square of this move.
+		 */
+		int getFrom() const { return from; }
+
+		/**
+		 * @return Returns the ending square of this move.
+		 */
+		int getTo() const { return to; }
+
+		/**
+		 * @return Returns the number of jumps in this move (0 if it is not a jump).
+		 */
+		int getJumpCount() const { return jumpCount; }
+
+		/**
+		 * @return Returns true if this move jumps (and so captures) any pieces.
+		 */
+		bool isJump() const { return captures != 0; }
+
+		/**
+		 * @return Returns a bitboard of the squares of every piece captured by this move.
+		 */
+		std::uint64_t getCaptureMask() const { return captures; }
+
+		bool operator==(const WideMove& other) const
+		{ return captures == other.captures && from == other.from && to == other.to; }
+		bool operator!=(const WideMove& other) const { return !(*this == other); }
+
+	private:
+		std::uint64_t captures;
+		std::uint8_t from;
+		std::uint8_t to;
+		std::uint8_t jumpCount;
+};
+
+static_assert(sizeof(WideMove) == 16, "WideMove must stay sixteen bytes");
+static_assert(std::is_trivially_copyable<WideMove>::value, "WideMove must be trivially copyable");
+
+#endif
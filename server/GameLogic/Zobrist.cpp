@@ -0,0 +1,36 @@
+#include "Zobrist.h"
+
+// The numbers are the SplitMix64 sequence from a fixed seed. Each one is a function of its
+// index alone, so the tables are worked out by the compiler instead of at start up.
+static constexpr hashkey_t ZOBRIST_SEED = 0x636865636b657273ULL;
+static constexpr hashkey_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15ULL;
+
+static constexpr hashkey_t finishMix(hashkey_t z) { return z ^ (z >> 31); }
+static constexpr hashkey_t secondMix(hashkey_t z) { return finishMix((z ^ (z >> 27)) * 0x94d049bb133111ebULL); }
+static constexpr hashkey_t firstMix(hashkey_t z) { return secondMix((z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL); }
+
+/**
+ * @return Returns the nth number of the sequence.
+ * @param n The index of the number
+ */
+static constexpr hashkey_t zobristNumber(int n)
+{
+    return firstMix(ZOBRIST_SEED + (hashkey_t)(n + 1) * GOLDEN_GAMMA);
+}
+
+#define ZOBRIST_4(n) zobristNumber(n), zobristNumber(n + 1), zobristNumber(n + 2), zobristNumber(n + 3)
+#define ZOBRIST_32(n) ZOBRIST_4(n), ZOBRIST_4(n + 4), ZOBRIST_4(n + 8), ZOBRIST_4(n + 12), \
+                      ZOBRIST_4(n + 16), ZOBRIST_4(n + 20), ZOBRIST_4(n + 24), ZOBRIST_4(n + 28)
+#define ZOBRIST_64(n) ZOBRIST_32(n), ZOBRIST_32(n + 32)
+
+// indexed by [isWhite][isKing][square]
+const hashkey_t Zobrist::PIECE_KEYS[2][2][MAX_SQUARES] = {
+    { { ZOBRIST_64(0) }, { ZOBRIST_64(64) } },
+    { { ZOBRIST_64(128) }, { ZOBRIST_64(192) } }
+};
+
+const hashkey_t Zobrist::BLACK_TO_MOVE_KEY = zobristNumber(256);
+
+#undef ZOBRIST_64
+#undef ZOBRIST_32
+#undef ZOBRIST_4
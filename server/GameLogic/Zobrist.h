@@ -0,0 +1,39 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include "Typedefs.h"
+
+/**
+ * The random numbers behind the Zobrist keys Board keeps for its positions.
+ *
+ * A position's key is the XOR of one number for every piece on it (by color, rank and square)
+ * and one more if black is to move, so a move only has to XOR in and out the few numbers it changes.
+ * The numbers are fixed (not seeded at run time), so the same position has the same key
+ * in every run and every program, and keys can be stored in files.
+ */
+class Zobrist
+{
+	public:
+		/**
+		 * @return Returns the number for a piece on a square.
+		 * @param isWhite The color of the piece
+		 * @param isKing Whether the piece is a king
+		 * @param square The square, from 0 to 63 (see Bitboard.h - boards of every size use the same numbers)
+		 */
+		static hashkey_t getPieceKey(bool isWhite, bool isKing, int square)
+		{ return PIECE_KEYS[isWhite][isKing][square]; }
+
+		/**
+		 * @return Returns the number included in the key when black is to move.
+		 */
+		static hashkey_t getBlackToMoveKey() { return BLACK_TO_MOVE_KEY; }
+
+		// the most playable squares a board can have (a square for every bit of a 64-bit bitboard)
+		const static int MAX_SQUARES = 64;
+
+	private:
+		static const hashkey_t PIECE_KEYS[2][2][MAX_SQUARES];
+		static const hashkey_t BLACK_TO_MOVE_KEY;
+};
+
+#endif
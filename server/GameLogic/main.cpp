@@ -1,15 +1,27 @@
 #include "Player.h"
 #include "HumanPlayer.h"
+#include "AIPlayer.h"
+#include "MonteCarloPlayer.h"
+#include "EndgameDatabase.h"
+#include "OpeningBook.h"
 #include "Board.h"
 #include "Piece.h"
 #include "Move.h"
+#include "MoveList.h"
 
 #include <vector>
 #include <iostream>
 #include <memory> // Add this include for unique_ptr
+#include <algorithm>
+#include <cstdlib>
+#include <string>
 
 /**
  * File responsible for running the 2-player checkers game.
+ * Either player (or both) can be the computer:
+ *   checkers [--ai white|black|both] [--time MS] [--depth N] [--nodes N] [--hash MB] [--threads N]
+ *                [--egdb DIR] [--book FILE] [--clock MS] [--increment MS] [--ponder]
+ *                [--engine alphabeta|mcts] [--playouts N] [--weights FILE]
  *
  * @author Mckenna Cisler
  * @version 5.18.2016
@@ -18,6 +30,12 @@
 bool isPlayer1 = true;
 bool endGameNow = false; // an easily accessible "end" variable
 
+// the last thing a computer player said, so it stays on screen above the board
+std::string lastAnnouncement;
+
+// the key of every position the game has been in, for spotting repetitions
+std::vector<hashkey_t> positionHistory;
+
 /**
  * Clears the terminal screen
  */
@@ -25,6 +43,19 @@ void clearScreen()
 {
 	// see http://stackoverflow.com/a/32008479/3155372
 	std::cout << "\033[2J\033[1;1H";
+	if (!lastAnnouncement.empty())
+		std::cout << lastAnnouncement << '\n' << '\n';
+}
+
+/**
+ * Tells the players something (like the move a computer player made),
+ * and keeps showing it until the next announcement
+ * @param message What to say
+ */
+void announce(const std::string &message)
+{
+	lastAnnouncement = message;
+	std::cout << message << std::endl;
 }
 
 /**
@@ -46,32 +77,25 @@ bool endGame(const Board &board)
 		return true;
 	else
 	{
-		// otherwise search the board for pieces of both colors, and if none of one color are present,
-		// the other player has won.
-		int movableWhiteNum = 0;
-		int movableBlackNum = 0;
-		for (int pos = 0; pos < Board::SIZE * Board::SIZE; pos++)
-		{
-			// make sure the piece exists, and if so sum movable pieces for each color)
-			Piece *pieceHere = board.getValueAt(pos);
-			if (pieceHere != nullptr)
-			{
-				// only consider piece if it has possible moves
-				if (!pieceHere->getAllPossibleMoves(board).empty())
-				{
-					if (pieceHere->isWhite)
-						movableWhiteNum++;
-					else
-						movableBlackNum++;
-				}
-			}
-		}
+		// otherwise generate each side's legal moves, and if one side has none
+		// (because it has no pieces left, or they are all blocked) the other player has won.
+		MoveList whiteMoves;
+		MoveList blackMoves;
+		board.getAllLegalMoves(true, whiteMoves);
+		board.getAllLegalMoves(false, blackMoves);
+		int movableWhiteNum = whiteMoves.size();
+		int movableBlackNum = blackMoves.size();
 
 		using namespace std;
 
+		// the game is also drawn once the same position comes up a third time
+		int occurrences = (int)std::count(positionHistory.begin(), positionHistory.end(), board.getHash());
+
 		// determine if anyone won (or if no one had any moves left)
 		if (movableWhiteNum + movableBlackNum == 0)
 			cout << "The game was a stalemate..." << endl;
+		else if (occurrences >= 3)
+			cout << "The same position has come up three times, so the game is a draw." << endl;
 		else if (movableWhiteNum == 0)
 			cout << "Congratulations, Black, you have won the game gloriously!" << endl;
 		else if (movableBlackNum == 0)
@@ -83,16 +107,176 @@ bool endGame(const Board &board)
 		return true;
 	}
 }
-int main()
+/**
+ * Prints how to run the game
+ */
+void printUsage()
+{
+	std::cout << "Usage: checkers [--ai white|black|both] [--time MS] [--depth N] [--nodes N] [--hash MB] [--threads N] [--egdb DIR] [--book FILE]" << std::endl;
+	std::cout << "                [--clock MS] [--increment MS] [--ponder]" << std::endl;
+	std::cout << "                [--engine alphabeta|mcts] [--playouts N] [--weights FILE]" << std::endl;
+	std::cout << "  --ai      which side(s) the computer plays (by default, two people play)" << std::endl;
+	std::cout << "  --time    the most time the computer may think per move, in milliseconds (default 500, 0 for no limit)" << std::endl;
+	std::cout << "  --depth   the deepest the computer may search, in moves" << std::endl;
+	std::cout << "  --nodes   the most positions the computer may look at per move" << std::endl;
+	std::cout << "  --hash    the size of the table each computer player remembers positions in, in megabytes (default 16)" << std::endl;
+	std::cout << "  --threads how many threads each computer player searches with (default 1)" << std::endl;
+	std::cout << "  --egdb    a directory of endgame databases for the computer to look endgames up in (see checkers_egdbgen)" << std::endl;
+	std::cout << "  --book    an opening book for the computer to play its first moves from (see checkers_bookbuild)" << std::endl;
+	std::cout << "  --clock   the computer's time for the whole game, in milliseconds (instead of a time per move)" << std::endl;
+	std::cout << "  --increment the time added to the computer's clock after each of its moves, in milliseconds" << std::endl;
+	std::cout << "  --ponder  let the computer think on its opponent's time" << std::endl;
+	std::cout << "  --engine  how the computer picks its moves: alphabeta search (the default) or mcts (Monte Carlo tree search)" << std::endl;
+	std::cout << "  --playouts the most playouts the mcts computer may run per move (--time, --threads and --hash also apply to it)" << std::endl;
+	std::cout << "  --weights the evaluation weights the computer plays with (see checkers_tune; default eval.weights, if there is one)" << std::endl;
+}
+
+/**
+ * How the computer players are set up, from the command line.
+ */
+struct ComputerSettings
+{
+	// how much the computer may search for each move
+	SearchLimits limits;
+	// the size of each computer player's transposition table, in megabytes
+	size_t hashMegabytes = 16;
+	// how many threads each computer player searches with
+	int threads = 1;
+	// the endgame database and opening book the computer uses (or null for none)
+	const EndgameDatabase *endgames = nullptr;
+	const OpeningBook *book = nullptr;
+	// the computer's clock, if it plays on one (its time for the game and increment, in milliseconds)
+	int clockMilliseconds = 0;
+	int incrementMilliseconds = 0;
+	// whether the computer thinks on its opponent's time
+	bool ponder = false;
+	// whether the computer uses the Monte Carlo tree search instead, and its playouts per move (0 for no limit)
+	bool monteCarlo = false;
+	std::uint64_t playouts = 0;
+	// the weights the computer evaluates positions with
+	EvalWeights weights;
+};
+
+/**
+ * @return Returns a new player of the given color, a person or the computer
+ * @param isWhite The color the player plays
+ * @param isComputer Whether the computer plays it
+ * @param settings How the computer is set up, if it plays it
+ */
+std::unique_ptr<Player> createPlayer(bool isWhite, bool isComputer, const ComputerSettings &settings)
+{
+	if (isComputer && settings.monteCarlo)
+	{
+		// (the tree search has no use for the clock, book or endgames, and no limit but time and playouts)
+		MonteCarloLimits limits;
+		limits.maxPlayouts = settings.playouts;
+		limits.maxMilliseconds = settings.limits.maxMilliseconds;
+		if (limits.maxPlayouts == 0 && limits.maxMilliseconds == 0)
+			limits.maxMilliseconds = 500;
+		return std::unique_ptr<Player>(new MonteCarloPlayer(isWhite, limits, std::max<size_t>(1, settings.hashMegabytes), settings.threads,
+		                                                          settings.weights));
+	}
+	if (isComputer)
+	{
+		AIPlayer *player = new AIPlayer(isWhite, settings.limits, settings.hashMegabytes, settings.threads, settings.weights);
+		player->setEndgameDatabase(settings.endgames);
+		player->setOpeningBook(settings.book);
+		if (settings.clockMilliseconds > 0)
+		{
+			GameClock clock;
+			clock.remainingMilliseconds = settings.clockMilliseconds;
+			clock.incrementMilliseconds = settings.incrementMilliseconds;
+			player->setClock(clock);
+		}
+		player->setPondering(settings.ponder);
+		return std::unique_ptr<Player>(player);
+	}
+	return std::unique_ptr<Player>(new HumanPlayer(isWhite));
+}
+
+int main(int argc, char *argv[])
 {
 	try
 	{
+		bool whiteIsComputer = false;
+		bool blackIsComputer = false;
+		ComputerSettings settings;
+		settings.limits.maxMilliseconds = 500;
+		std::string endgameDirectory;
+		std::string bookPath;
+		std::string weightsPath;
+
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			std::string value = i + 1 < argc ? argv[i + 1] : "";
+			if (arg == "--ponder")
+			{
+				settings.ponder = true;
+				continue; // (it takes no value)
+			}
+			else if (arg == "--ai" && (value == "white" || value == "black" || value == "both"))
+			{
+				whiteIsComputer = value != "black";
+				blackIsComputer = value != "white";
+			}
+			else if (arg == "--time" && !value.empty())
+				settings.limits.maxMilliseconds = std::max(0, atoi(value.c_str()));
+			else if (arg == "--depth" && !value.empty())
+				settings.limits.maxDepth = std::max(1, atoi(value.c_str()));
+			else if (arg == "--nodes" && !value.empty())
+				settings.limits.maxNodes = (std::uint64_t)std::max(0LL, atoll(value.c_str()));
+			else if (arg == "--hash" && !value.empty())
+				settings.hashMegabytes = (size_t)std::max(0, atoi(value.c_str()));
+			else if (arg == "--threads" && !value.empty())
+				settings.threads = std::max(1, atoi(value.c_str()));
+			else if (arg == "--egdb" && !value.empty())
+				endgameDirectory = value;
+			else if (arg == "--book" && !value.empty())
+				bookPath = value;
+			else if (arg == "--clock" && !value.empty())
+				settings.clockMilliseconds = std::max(0, atoi(value.c_str()));
+			else if (arg == "--increment" && !value.empty())
+				settings.incrementMilliseconds = std::max(0, atoi(value.c_str()));
+			else if (arg == "--engine" && (value == "alphabeta" || value == "mcts"))
+				settings.monteCarlo = value == "mcts";
+			else if (arg == "--playouts" && !value.empty())
+				settings.playouts = (std::uint64_t)std::max(0LL, atoll(value.c_str()));
+			else if (arg == "--weights" && !value.empty())
+				weightsPath = value;
+			else
+			{
+				printUsage();
+				return 1;
+			}
+			i++; // skip the value
+		}
+
+		// shared by both computer players, since lookups never change it
+		EndgameDatabase endgames;
+		if (!endgameDirectory.empty() && endgames.open(endgameDirectory) == 0)
+			std::cerr << "No complete endgame databases in " << endgameDirectory << std::endl;
+		settings.endgames = endgames.getMaxPieces() > 0 ? &endgames : nullptr;
+		OpeningBook book;
+		if (!bookPath.empty() && !book.open(bookPath))
+			std::cerr << "Could not open the opening book " << bookPath << std::endl;
+		settings.book = book.getSize() > 0 ? &book : nullptr;
+		// the weights checkers_tune wrote, if there are any (a missing eval.weights just means the built-in ones)
+		if (!Evaluator::readWeights(weightsPath.empty() ? "eval.weights" : weightsPath, settings.weights) && !weightsPath.empty())
+			std::cerr << "Could not read the weights file " << weightsPath << std::endl;
+
 		// Generate basic board and setup
 		Board board;
+		positionHistory.push_back(board.getHash());
 
 		// Define players using unique_ptr for automatic memory management
-		std::unique_ptr<Player> player1(new HumanPlayer(true));	 // White player
-		std::unique_ptr<Player> player2(new HumanPlayer(false)); // Black player
+		std::unique_ptr<Player> player1 = createPlayer(true, whiteIsComputer, settings);	 // White player
+		std::unique_ptr<Player> player2 = createPlayer(false, blackIsComputer, settings); // Black player
+
+		// with nobody at the keyboard, show the board after every move instead
+		bool watching = whiteIsComputer && blackIsComputer;
+		if (watching)
+			HumanPlayer::displayBoard(board);
 
 		while (!endGame(board))
 		{
@@ -100,6 +284,10 @@ int main()
 				player1->getMove(board);
 			else
 				player2->getMove(board);
+			positionHistory.push_back(board.getHash());
+
+			if (watching)
+				HumanPlayer::displayBoard(board);
 
 			// Switch players
 			isPlayer1 = !isPlayer1;
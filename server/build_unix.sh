@@ -17,6 +17,7 @@ echo ""
 echo "Build complete! Executables can be found in the build directory."
 echo "- checkers_server: Multiplayer server"
 echo "- checkers: Original single-player game"
+echo "- checkers_perft: Move generator benchmark"
 echo ""
 
 cd ..
\ No newline at end of file
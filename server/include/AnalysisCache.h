@@ -0,0 +1,73 @@
+// server/include/AnalysisCache.h
+#ifndef ANALYSIS_CACHE_H
+#define ANALYSIS_CACHE_H
+
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include "../GameLogic/Typedefs.h"
+#include "../GameLogic/Search.h"
+
+// What an analysis is of: a position (its Zobrist key, which includes the side to move) searched
+// to a depth
+struct AnalysisKey
+{
+    hashkey_t hash;
+    int depth;
+
+    bool operator==(const AnalysisKey &other) const { return hash == other.hash && depth == other.depth; }
+};
+
+struct AnalysisKeyHash
+{
+    size_t operator()(const AnalysisKey &key) const
+    {
+        return (size_t)(key.hash ^ ((std::uint64_t)key.depth * 0x9E3779B97F4A7C15ULL));
+    }
+};
+
+// The results of analyses (see the ANALYZE command), so a position asked about again, by
+// spectators, replays or hints, is answered at once instead of searched again.
+//
+// Holds at most a fixed number of results, dropping the least recently used ones to make room.
+// Any number of threads can use it at once: it is split into shards by key, each with its own
+// lock, list and index, so a lookup or insert only ever locks one shard, for a constant time.
+class AnalysisCache
+{
+public:
+    explicit AnalysisCache(size_t capacity = 4096);
+
+    AnalysisCache(const AnalysisCache &) = delete;
+    AnalysisCache &operator=(const AnalysisCache &) = delete;
+
+    // Copies out the result for the key, if there is one (making it the most recently used)
+    bool find(const AnalysisKey &key, SearchResult &result);
+    // Stores a result, replacing any for the same key
+    void insert(const AnalysisKey &key, const SearchResult &result);
+
+    size_t getSize();
+    std::uint64_t getHits() const { return hits; }
+    std::uint64_t getMisses() const { return misses; }
+
+private:
+    static const int SHARD_COUNT = 16;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        // most recently used first
+        std::list<std::pair<AnalysisKey, SearchResult>> entries;
+        std::unordered_map<AnalysisKey, std::list<std::pair<AnalysisKey, SearchResult>>::iterator, AnalysisKeyHash> index;
+    };
+
+    Shard shards[SHARD_COUNT];
+    size_t shardCapacity;
+    std::atomic<std::uint64_t> hits;
+    std::atomic<std::uint64_t> misses;
+
+    Shard &getShard(const AnalysisKey &key);
+};
+
+#endif // ANALYSIS_CACHE_H
@@ -0,0 +1,86 @@
+// server/include/SearchExecutor.h
+#ifndef SEARCH_EXECUTOR_H
+#define SEARCH_EXECUTOR_H
+
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include "../GameLogic/Search.h"
+#include "../GameLogic/TranspositionTable.h"
+
+class EndgameDatabase;
+
+// Runs engine searches for the server's games on a fixed number of threads of its own, apart
+// from the ThreadPool serving TCP clients and the WebSocket thread, so a search never holds up
+// a network thread. Each thread has its own Search and transposition table, handed to the jobs
+// it runs.
+//
+// Jobs are queued per owner (a game session, say) and the owners take turns: a thread always
+// takes the next job of the owner after the last one served, so a session with several searches
+// queued can't starve the others. The queue holds at most maxQueued jobs; submit refuses more.
+class SearchExecutor
+{
+public:
+    typedef std::function<void(Search &)> Job;
+
+    // the computer's strength levels, weakest first (see getLevelLimits)
+    static const int MIN_LEVEL = 1;
+    static const int MAX_LEVEL = 5;
+    // no search on the executor runs longer than this, whatever its level, so a thread is never
+    // tied up for long
+    static const int MAX_SEARCH_MILLISECONDS = 3000;
+
+    // Every thread's search evaluates positions with the given weights
+    SearchExecutor(size_t numThreads, size_t maxQueued, size_t hashMegabytes = 16,
+                   const EvalWeights &weights = EvalWeights());
+    ~SearchExecutor();
+
+    // Sets the endgame database every thread's search looks positions up in (call before submitting)
+    void setEndgameDatabase(const EndgameDatabase *endgames);
+
+    // Queues a job for the given owner; returns false if the queue is full or the executor is shut down
+    bool submit(int owner, Job job);
+    // Drops the owner's queued jobs (one already running still finishes)
+    void cancel(int owner);
+    // Stops the running searches, drops the queued jobs and joins the threads
+    void shutdown();
+
+    size_t getQueuedCount();
+    size_t getThreadCount() const { return workers.size(); }
+
+    // The limits of a search at a strength level, from MIN_LEVEL to MAX_LEVEL
+    static SearchLimits getLevelLimits(int level);
+
+private:
+    // one thread's engine, kept from job to job
+    struct Engine
+    {
+        TranspositionTable table;
+        Search search;
+        Engine(size_t hashMegabytes, const EvalWeights &weights) : table(hashMegabytes), search(weights, &table) {}
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Engine>> engines;
+
+    std::mutex queueMutex;
+    std::condition_variable condition;
+    // each owner's jobs, and the owners with jobs in the order they are to be served
+    std::unordered_map<int, std::deque<Job>> queues;
+    std::deque<int> owners;
+    size_t queued;
+    size_t maxQueued;
+    bool stopping;
+    // stops every running search once set
+    std::atomic<bool> stopSignal;
+
+    void workerLoop(Engine &engine);
+};
+
+#endif // SEARCH_EXECUTOR_H
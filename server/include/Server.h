@@ -8,7 +8,9 @@
 #include <mutex>
 #include <atomic>
 #include <unordered_map>
+#include <functional>
 #include "SocketWrapper.h"
+#include "AnalysisCache.h"
 #define _WEBSOCKETPP_CPP11_THREAD_
 
 #define ASIO_STANDALONE
@@ -16,12 +18,16 @@
 #include "../websocketpp/websocketpp/server.hpp"
 #include "../websocketpp/websocketpp/config/asio_no_tls.hpp"
 #include "../src/DatabaseManager.h"
+#include "../GameLogic/Rules.h"
+#include "../GameLogic/EndgameDatabase.h"
+#include "../GameLogic/TimeManager.h"
 
 // Declare the function before any class definitions
 void killPreviousInstances();
 
 class GameSession;
 class ThreadPool;
+class SearchExecutor;
 
 class Server
 {
@@ -30,10 +36,16 @@ private:
     socket_t serverSocket; // Changed from int to socket_t
     std::atomic<bool> running;
     ThreadPool *threadPool;
+    // runs the computer's searches for games against it, on threads of its own
+    SearchExecutor *searchExecutor;
+    TimeManager timeManager;
     DatabaseManager dbManager;
     bool dbInitialized;
     int nextSessionId;
 
+    // shared by every game session, to end decided endgames (empty unless opened)
+    EndgameDatabase endgames;
+
     std::mutex sessionsMutex;
     std::unordered_map<int, GameSession *> gameSessions;
     std::unordered_map<int, std::string > gameCodes;
@@ -52,6 +64,27 @@ private:
     void onWebSocketOpen(websocketpp::connection_hdl hdl);
     void onWebSocketClose(websocketpp::connection_hdl hdl);
     
+    // Sends a move's result and the board to the session's WebSocket clients
+    void broadcastMoveResult(GameSession *session, bool success, int fromX, int fromY, int toX, int toY);
+
+    // the results of ANALYZE, shared by every client, and the analyses being searched with
+    // everyone waiting for each (so a position asked about by many at once is searched once)
+    typedef std::function<void(bool searched, const SearchResult &result, bool cached)> AnalysisCallback;
+    AnalysisCache analysisCache;
+    std::mutex analysesMutex;
+    std::unordered_map<AnalysisKey, std::vector<AnalysisCallback>, AnalysisKeyHash> pendingAnalyses;
+
+    // Answers an ANALYZE request: the callback gets the cached result at once, or the search's once
+    // it has run on the search executor (searched is false if the executor had no room for it)
+    void requestAnalysis(int owner, const BasicBoard<EnglishRules> &position, int depth, AnalysisCallback callback);
+    void finishAnalysis(const AnalysisKey &key, bool searched, const SearchResult &result);
+    // Reads the position (given, or else the session's) and depth of an ANALYZE command;
+    // returns false with the reason if there is nothing to analyze
+    bool parseAnalyzeCommand(const std::string &message, GameSession *session, BasicBoard<EnglishRules> &position,
+                             int &depth, std::string &error);
+    // The game the client is playing, or -1
+    int findActiveSession(const std::string &clientId);
+
     void recordWin(const std::string& username);
     void recordLoss(const std::string& username);
 
@@ -62,14 +95,36 @@ private:
 std::unordered_map<std::string, std::pair<std::string, std::string>> registeredUsers;
 
 public:
-    Server(int port, int numThreads);
+    // at most this many searches wait for a search thread at once
+    static const int MAX_QUEUED_SEARCHES = 64;
+    // the computer plays as this followed by "L", its level, "-" and the game's ID (so every game against it
+    // has an opponent of its own); no one can register a name starting with it
+    static constexpr const char *ENGINE_ID_PREFIX = "Computer-";
+    // what an ANALYZE search may do: at most this many nodes (and MAX_SEARCH_MILLISECONDS), to the
+    // depth asked for, by default the first and at most the second
+    static const int ANALYSIS_NODES = 2000000;
+    static const int DEFAULT_ANALYSIS_DEPTH = 12;
+    static const int MAX_ANALYSIS_DEPTH = 24;
+    // how many analyses are kept
+    static const int ANALYSIS_CACHE_SIZE = 4096;
+
+    // The computer's searches (games and analyses) evaluate positions with the given weights
+    Server(int port, int numThreads, int searchThreads = 2, const EvalWeights &weights = EvalWeights());
     ~Server();
 
     bool start();
     void stop();
 
-    int createGameSession(const std::string &player1Id);
+    // (sessionId 0 takes the next free ID; anything else must have been reserved with reserveSessionId)
+    int createGameSession(const std::string &player1Id, GameVariant variant = ENGLISH_CHECKERS, int sessionId = 0);
+    int reserveSessionId();
     bool joinGameSession(int sessionId, const std::string &player2Id);
+    // Creates a started English game between a player and the computer at a strength level
+    // (see SearchExecutor::getLevelLimits); returns its ID, or -1 if the computer is too busy.
+    // Call scheduleEngineMove once the player's connection is added, in case the computer plays white
+    int createEngineGameSession(const std::string &playerId, int level, bool playerIsWhite);
+    // Queues a search for the computer's move, if it is the computer's turn in the session
+    void scheduleEngineMove(int sessionId);
     GameSession *getGameSession(int sessionId);
 
     void handleClientConnection(socket_t clientSocket); // Changed from int to socket_t
@@ -80,6 +135,7 @@ public:
     int getPort() const { return port; }
 
     bool initializeDatabase();
+    int openEndgameDatabase(const std::string &directory);
     bool registerUser(const std::string& username, const std::string& email, const std::string& password);
     bool authenticateUser(const std::string& username, const std::string& password);
     bool saveGameState(int sessionId, const std::string& boardState);
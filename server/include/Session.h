@@ -7,9 +7,10 @@
 #include <vector>
 #include <atomic>
 #include "../src/DatabaseManager.h"
-#include "../GameLogic/Board.h"
-#include "../GameLogic/Move.h"
-#include "../GameLogic/Piece.h"
+#include <memory>
+#include "../GameLogic/VariantBoard.h"
+#include "../GameLogic/TimeManager.h"
+#include <chrono>
 #include "SocketWrapper.h"
 #define _WEBSOCKETPP_CPP11_THREAD_
 #include <nlohmann/json.hpp>
@@ -20,6 +21,8 @@
 #include "../websocketpp/websocketpp/server.hpp"
 #include "../websocketpp/websocketpp/config/asio_no_tls.hpp"
 
+class EndgameDatabase;
+
 class GameSession
 {
 private:
@@ -30,11 +33,42 @@ private:
     bool gameStarted;
     DatabaseManager* db;  
     
-    Board gameBoard; // The checkers board
+    std::unique_ptr<VariantBoard> gameBoard; // The board, playing by the rules the game was created with
     std::atomic<bool> isPlayer1Turn;
+    // set once the game has been won, lost or drawn; no more moves are accepted after that
+    std::atomic<bool> gameOver;
+
+    // looked up after every move of an English game, to end decided endgames at once (may be null)
+    const EndgameDatabase* endgames;
+
+    // the players' clocks (white's, then black's), if the game is played on time (see setTimeControl);
+    // the side to move is charged for its turn when it moves, and loses if it has run out
+    bool timed;
+    GameClock clocks[2];
+    std::chrono::steady_clock::time_point turnStart;
+    int elapsedThisTurn() const;
+    bool chargeClock(bool isWhite);
+
+    // whether one side is played by the server's engine (see setEngineOpponent), which, and how strongly
+    bool hasEngine;
+    bool engineIsWhite;
+    int engineLevel;
+    // The board as the engine's board, with the given side to move (English games only)
+    BasicBoard<EnglishRules> getEnglishBoard(bool whiteToMove) const;
+
+    // Zobrist key of every position this game has been in, in order, for spotting repetitions
+    std::vector<hashkey_t> positionHistory;
+    // index in positionHistory of the position after the last capture or man move
+    // (those can't be undone, so no earlier position can ever come up again)
+    size_t lastIrreversibleIndex;
+    void recordPosition(bool irreversible);
+    void sendToAllClients(const std::string &message);
+    void declareWinner(bool whiteWins, const std::string &reason);
+    void declareDraw(const std::string &reason);
+    bool adjudicateEndgame();
     std::mutex gameMutex;
 
-    static int mutexOperationId;
+    static std::atomic<int> mutexOperationId;
     void logMutexAcquire(const std::string &methodName);
     void logMutexRelease(const std::string &methodName);
 
@@ -42,13 +76,19 @@ private:
     std::vector<std::pair<websocketpp::connection_hdl, WebSocketServer*>> wsConnections;
 
 public:
-    GameSession(std::string inviteCode, int id, const std::string &p1Id, DatabaseManager* dbRef);
+    GameSession(std::string inviteCode, int id, const std::string &p1Id, DatabaseManager* dbRef,
+                GameVariant variant = ENGLISH_CHECKERS, const EndgameDatabase* endgameDb = nullptr);
     ~GameSession();
     const std::vector<std::pair<websocketpp::connection_hdl, WebSocketServer*>>& getWsConnections() const {
         return wsConnections;
     }
     bool joinGame(const std::string &p2Id);
-    bool makeMove(const std::string &playerId, int fromX, int fromY, int toX, int toY);
+    // Plays a player's move, if it is legal. A person's move names only its squares, and when several
+    // capture chains join them the first is played; captures (a bitboard of the captured squares)
+    // picks the chain, as the computer does for the one it searched
+    static const std::uint64_t ANY_CAPTURES = ~(std::uint64_t)0;
+    bool makeMove(const std::string &playerId, int fromX, int fromY, int toX, int toY,
+                  std::uint64_t captures = ANY_CAPTURES);
     std::string getBoardState() const; // Return serialized board state
     int getCurrentTurn();             // <-- returns 0 or 1 depending on turn
 
@@ -58,6 +98,7 @@ public:
     int getSessionId() const { return sessionId; }
     bool isGameFull() const { return !player2Id.empty(); }
     bool hasStarted() const { return gameStarted; }
+    bool isGameOver() const { return gameOver; }
 
     bool forceBlackMove(int fromX, int fromY, int toX, int toY);
     const std::string &getPlayer2Id() const { return player2Id; }
@@ -65,8 +106,39 @@ public:
 
     bool playerHasJumps(bool isWhiteTurn);
 
-    const Board &getGameBoard() const { return gameBoard; }
+    const VariantBoard &getGameBoard() const { return *gameBoard; }
+    GameVariant getVariant() const { return gameBoard->getVariant(); }
     bool checkForWinner();
+    bool isRepetitionDraw() const;   // true once the current position has come up three times
+    const std::vector<hashkey_t> &getPositionHistory() const { return positionHistory; }
+
+    // Plays the rest of the game on time: each side starts with initialMilliseconds and gets
+    // incrementMilliseconds back after each of its moves
+    void setTimeControl(int initialMilliseconds, int incrementMilliseconds);
+    bool hasTimeControl() const { return timed; }
+    // A side's clock as it stands right now (the side to move's turn so far already taken off)
+    GameClock getClock(bool isWhite);
+    // How long an engine may search for the side's move: from its clock if the game is on time
+    // (and English, the only variant the engine plays), otherwise just the given limits
+    SearchLimits getMoveLimits(bool isWhite, const TimeManager &timeManager, const SearchLimits &limits = SearchLimits());
+
+    // Hands one side (whose player id this session already has) to the server's engine, playing
+    // at the given strength level (English games only)
+    void setEngineOpponent(bool isWhite, int level);
+    bool hasEngineOpponent() const { return hasEngine; }
+    bool isEngineWhite() const { return engineIsWhite; }
+    int getEngineLevel() const { return engineLevel; }
+    // The position and game history for searching the engine's move; returns how many positions the
+    // game has been through (to pass to makeEngineMove), or 0 if it isn't the engine's turn
+    size_t getEngineSearch(BasicBoard<EnglishRules> &position, std::vector<hashkey_t> &history);
+    // Plays the engine's move, unless the game has moved on since getEngineSearch said it had
+    // positionCount positions (the result of a search of a position no longer on the board is dropped)
+    bool makeEngineMove(size_t positionCount, const CompactMove &move);
+    // Ends the game when the engine's side has no moves left
+    void engineHasNoMoves();
+    // The current position, with the side to move, for analyzing; false if the game isn't English
+    // (the only variant the engine plays)
+    bool getAnalysisPosition(BasicBoard<EnglishRules> &position);
 
     // Add a method to add WebSocket handle
     void addWebSocketHandle(websocketpp::connection_hdl hdl, WebSocketServer* server) {
@@ -0,0 +1,66 @@
+// server/src/AnalysisCache.cpp
+#include "../include/AnalysisCache.h"
+
+#include <algorithm>
+
+AnalysisCache::AnalysisCache(size_t capacity)
+    : shardCapacity(std::max<size_t>(1, capacity / SHARD_COUNT)), hits(0), misses(0)
+{
+}
+
+bool AnalysisCache::find(const AnalysisKey &key, SearchResult &result)
+{
+    Shard &shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end())
+    {
+        misses++;
+        return false;
+    }
+
+    // move it to the front, so it is the last to go
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    result = it->second->second;
+    hits++;
+    return true;
+}
+
+void AnalysisCache::insert(const AnalysisKey &key, const SearchResult &result)
+{
+    Shard &shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end())
+    {
+        it->second->second = result;
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+
+    // make room by dropping the least recently used result
+    if (shard.entries.size() >= shardCapacity)
+    {
+        shard.index.erase(shard.entries.back().first);
+        shard.entries.pop_back();
+    }
+    shard.entries.emplace_front(key, result);
+    shard.index[key] = shard.entries.begin();
+}
+
+size_t AnalysisCache::getSize()
+{
+    size_t size = 0;
+    for (Shard &shard : shards)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size += shard.entries.size();
+    }
+    return size;
+}
+
+AnalysisCache::Shard &AnalysisCache::getShard(const AnalysisKey &key)
+{
+    // the top bits, since the index of each shard uses the low ones
+    return shards[(AnalysisKeyHash()(key) >> 60) % SHARD_COUNT];
+}
@@ -0,0 +1,144 @@
+// server/src/SearchExecutor.cpp
+#include "../include/SearchExecutor.h"
+#include "../GameLogic/Trace.h"
+
+#include <algorithm>
+
+SearchExecutor::SearchExecutor(size_t numThreads, size_t maxQueued, size_t hashMegabytes, const EvalWeights &weights)
+    : queued(0), maxQueued(maxQueued), stopping(false), stopSignal(false)
+{
+    for (size_t i = 0; i < std::max<size_t>(1, numThreads); ++i)
+    {
+        engines.emplace_back(new Engine(hashMegabytes, weights));
+        engines.back()->search.setStopSignal(&stopSignal);
+    }
+    for (std::unique_ptr<Engine> &engine : engines)
+    {
+        Engine *threadEngine = engine.get();
+        workers.emplace_back([this, threadEngine] { workerLoop(*threadEngine); });
+    }
+    TRACE_INFO("Search executor started with " << engines.size() << " threads");
+}
+
+SearchExecutor::~SearchExecutor()
+{
+    shutdown();
+}
+
+void SearchExecutor::setEndgameDatabase(const EndgameDatabase *endgames)
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    for (std::unique_ptr<Engine> &engine : engines)
+        engine->search.setEndgameDatabase(endgames);
+}
+
+bool SearchExecutor::submit(int owner, Job job)
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (stopping || queued >= maxQueued)
+            return false;
+
+        std::deque<Job> &queue = queues[owner];
+        // an owner with nothing queued joins the back of the line
+        if (queue.empty())
+            owners.push_back(owner);
+        queue.push_back(std::move(job));
+        queued++;
+    }
+    condition.notify_one();
+    return true;
+}
+
+void SearchExecutor::cancel(int owner)
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    auto it = queues.find(owner);
+    if (it == queues.end())
+        return;
+    queued -= it->second.size();
+    queues.erase(it);
+    owners.erase(std::remove(owners.begin(), owners.end(), owner), owners.end());
+}
+
+void SearchExecutor::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (stopping)
+            return;
+        stopping = true;
+        queues.clear();
+        owners.clear();
+        queued = 0;
+    }
+    stopSignal = true;
+    condition.notify_all();
+
+    for (std::thread &worker : workers)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+    TRACE_INFO("Search executor stopped");
+}
+
+size_t SearchExecutor::getQueuedCount()
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return queued;
+}
+
+SearchLimits SearchExecutor::getLevelLimits(int level)
+{
+    level = std::max(MIN_LEVEL, std::min(MAX_LEVEL, level));
+
+    // the weaker levels see only a few moves ahead; the stronger ones are held back by time instead
+    static const int depths[] = { 1, 3, 5, 9, Search::MAX_DEPTH };
+    static const int milliseconds[] = { 100, 200, 300, 1000, 2500 };
+    SearchLimits limits;
+    limits.maxDepth = depths[level - MIN_LEVEL];
+    limits.maxMilliseconds = std::min((int)MAX_SEARCH_MILLISECONDS, milliseconds[level - MIN_LEVEL]);
+    return limits;
+}
+
+void SearchExecutor::workerLoop(Engine &engine)
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            condition.wait(lock, [this] { return stopping || !owners.empty(); });
+            if (stopping)
+                return;
+
+            // take the next owner's oldest job, and send the owner to the back of the line if it has more
+            int owner = owners.front();
+            owners.pop_front();
+            std::deque<Job> &queue = queues[owner];
+            job = std::move(queue.front());
+            queue.pop_front();
+            queued--;
+            if (queue.empty())
+                queues.erase(owner);
+            else
+                owners.push_back(owner);
+        }
+
+        try
+        {
+            // so the table knows which of its entries are from earlier jobs
+            engine.table.newSearch();
+            job(engine.search);
+        }
+        catch (const std::exception &e)
+        {
+            TRACE_ERROR("Exception in search job: " << e.what());
+        }
+        catch (...)
+        {
+            TRACE_ERROR("Unknown exception in search job");
+        }
+    }
+}
@@ -3,8 +3,9 @@
 #include "../include/ThreadPool.h"
 #include "../include/Session.h"
 #include "../include/SocketWrapper.h"
+#include "../include/SearchExecutor.h"
+#include "../GameLogic/Trace.h"
 
-#include <iostream>
 #include <cstring>
 #include <thread>
 #include <chrono>
@@ -12,6 +13,8 @@
 #include <vector>
 #include <sstream>
 #include <iomanip>
+#include <future>
+#include <memory>
 
 void killPreviousInstances()
 {
@@ -33,23 +36,26 @@ void killPreviousInstances()
     std::this_thread::sleep_for(std::chrono::milliseconds(500));
 }
 
-Server::Server(int port, int numThreads)
+Server::Server(int port, int numThreads, int searchThreads, const EvalWeights &weights)
     : port(port),
       serverSocket(SOCKET_ERROR_VALUE),
       running(false),
       nextSessionId(1),
-      dbInitialized(false)
+      dbInitialized(false),
+      analysisCache(ANALYSIS_CACHE_SIZE)
 {
     // Initialize socket library (Windows needs this)
     SocketWrapper::initialize();
 
     // Create the thread pool
     threadPool = new ThreadPool(numThreads);
+    // and the computer's own threads, so its searches never hold up a client
+    searchExecutor = new SearchExecutor(std::max(1, searchThreads), MAX_QUEUED_SEARCHES, 16, weights);
     dbInitialized = dbManager.initialize();
     if (!dbInitialized) {
-        std::cerr << "Warning: Database initialization failed" << std::endl;
+        TRACE_WARN("Warning: Database initialization failed");
     } else {
-        std::cout << "Database initialized successfully" << std::endl;
+        TRACE_INFO("Database initialized successfully");
     }
 }
 
@@ -168,6 +174,7 @@ Server::~Server()
 
     // Clean up thread pool
     delete threadPool;
+    delete searchExecutor;
 
     // Cleanup socket library (Windows needs this)
     SocketWrapper::cleanup();
@@ -179,14 +186,14 @@ bool Server::start()
      serverSocket = SocketWrapper::createSocket();
      if (serverSocket == SOCKET_ERROR_VALUE)
      {
-         std::cerr << "Failed to create socket: " << SocketWrapper::getLastError() << std::endl;
+         TRACE_ERROR("Failed to create socket: " << SocketWrapper::getLastError());
          return false;
      }
  
      // Set socket options
      if (!SocketWrapper::setReuseAddr(serverSocket))
      {
-         std::cerr << "Failed to set socket options: " << SocketWrapper::getLastError() << std::endl;
+         TRACE_ERROR("Failed to set socket options: " << SocketWrapper::getLastError());
          SocketWrapper::closeSocket(serverSocket);
          return false;
      }
@@ -205,13 +212,13 @@ bool Server::start()
              break;
          }
  
-         std::cerr << "Failed to bind to port " << (port + attempt)
-                   << ": " << SocketWrapper::getLastError() << std::endl;
+         TRACE_WARN("Failed to bind to port " << (port + attempt)
+                    << ": " << SocketWrapper::getLastError());
      }
  
      if (!bound)
      {
-         std::cerr << "Failed to bind to any port after " << MAX_PORT_ATTEMPTS << " attempts" << std::endl;
+         TRACE_ERROR("Failed to bind to any port after " << MAX_PORT_ATTEMPTS << " attempts");
          SocketWrapper::closeSocket(serverSocket);
          return false;
      }
@@ -219,7 +226,7 @@ bool Server::start()
      // Listen for connections
      if (!SocketWrapper::listenSocket(serverSocket, 10))
      {
-         std::cerr << "Failed to listen: " << SocketWrapper::getLastError() << std::endl;
+         TRACE_ERROR("Failed to listen: " << SocketWrapper::getLastError());
          SocketWrapper::closeSocket(serverSocket);
          return false;
      }
@@ -261,24 +268,137 @@ bool Server::start()
          std::thread wsThread(&WebSocketServer::run, &wsServer);
          wsThread.detach();  // Using detach instead of leaving the thread local
          
-         std::cout << "WebSocket server started on port 8080" << std::endl;
+         TRACE_INFO("WebSocket server started on port 8080");
      } catch (const websocketpp::exception& e) {
-         std::cerr << "WebSocket server error: " << e.what() << std::endl;
+         TRACE_ERROR("WebSocket server error: " << e.what());
          // Continue running the TCP server even if WebSocket fails
      }
  
-     std::cout << "Server started on port " << port << std::endl;
+     TRACE_INFO("Server started on port " << port);
      return true;
 }
 
+// Reads a position written the way PDN files do ("W:W9,10,K14:B22,23"): the side to move, then each
+// side's pieces by square number, K marking kings. Squares are numbered 1 to 32 from the top left,
+// row by row, as the board is shown.
+static bool parsePosition(const std::string &text, BasicBoard<EnglishRules> &position)
+{
+    std::istringstream fields(text);
+    std::string field;
+    if (!std::getline(fields, field, ':') || (field != "W" && field != "B" && field != "w" && field != "b"))
+        return false;
+    bool whiteToMove = toupper(field[0]) == 'W';
+
+    bitboard_t pieces[2] = { 0, 0 };
+    bitboard_t kings = 0;
+    while (std::getline(fields, field, ':'))
+    {
+        if (field.empty() || (toupper(field[0]) != 'W' && toupper(field[0]) != 'B'))
+            return false;
+        bool isWhite = toupper(field[0]) == 'W';
+        std::istringstream squares(field.substr(1));
+        std::string square;
+        while (std::getline(squares, square, ','))
+        {
+            bool isKing = !square.empty() && toupper(square[0]) == 'K';
+            int number = atoi(square.c_str() + (isKing ? 1 : 0));
+            if (number < 1 || number > 32)
+                return false;
+            bitboard_t mask = (bitboard_t)1 << (number - 1);
+            if ((pieces[0] | pieces[1]) & mask)
+                return false;
+            pieces[isWhite ? 0 : 1] |= mask;
+            if (isKing)
+                kings |= mask;
+        }
+    }
+    position = BasicBoard<EnglishRules>(pieces[0], pieces[1], kings, whiteToMove);
+    return true;
+}
+
+static std::string describeSquare(int square)
+{
+    coords_t coords = BasicBoard<EnglishRules>::getCoordsFromSquare(square);
+    return "[" + std::to_string(coords[0]) + "," + std::to_string(coords[1]) + "]";
+}
+
+// A move as JSON: where it starts, where it ends, and every square it lands on on the way
+static std::string describeMoveJson(const CompactMove &move)
+{
+    int landings[CompactMove::MAX_JUMPS];
+    int count = move.getLandingSquares(landings);
+    std::string json = "{\"from\":" + describeSquare(move.getFrom()) + ",\"to\":" + describeSquare(move.getTo()) + ",\"path\":[";
+    for (int i = 0; i < count; i++)
+        json += (i > 0 ? "," : "") + describeSquare(landings[i]);
+    return json + "]}";
+}
+
+static std::string describeAnalysisJson(const SearchResult &result, int depth, bool cached)
+{
+    std::ostringstream json;
+    json << "{\"type\":\"analysis\",";
+    json << "\"hasMove\":" << (result.hasMove ? "true" : "false") << ",";
+    if (result.hasMove)
+        json << "\"bestMove\":" << describeMoveJson(result.bestMove) << ",";
+    // for the side to move, in hundredths of a man (or a win or loss the search has proved)
+    json << "\"score\":" << result.score << ",";
+    if (Search::isWinScore(result.score))
+        json << "\"winIn\":" << (result.score > 0 ? 1 : -1) * (Search::WIN_SCORE - std::abs(result.score)) << ",";
+    json << "\"pv\":[";
+    for (size_t i = 0; i < result.principalVariation.size(); i++)
+        json << (i > 0 ? "," : "") << describeMoveJson(result.principalVariation[i]);
+    json << "],";
+    json << "\"depth\":" << result.depth << ",\"requestedDepth\":" << depth << ",";
+    json << "\"nodes\":" << result.nodes << ",\"cached\":" << (cached ? "true" : "false") << "}";
+    return json.str();
+}
+
+static std::string describeAnalysisText(const SearchResult &result, int depth, bool cached)
+{
+    if (!result.hasMove)
+        return "Analysis: the side to move has no moves and has lost\n";
+
+    std::ostringstream text;
+    text << "Analysis: best move " << describeSquare(result.bestMove.getFrom()) << " to " << describeSquare(result.bestMove.getTo());
+    if (Search::isWinScore(result.score))
+        text << ", " << (result.score > 0 ? "wins" : "loses") << " in " << Search::WIN_SCORE - std::abs(result.score) << " plies";
+    else
+        text << ", score " << std::showpos << std::fixed << std::setprecision(2) << result.score / 100.0 << std::noshowpos;
+    text << ", depth " << result.depth;
+    if (result.depth < depth)
+        text << " (of " << depth << " asked for)";
+    text << ", line:";
+    for (const CompactMove &move : result.principalVariation)
+        text << " " << describeSquare(move.getFrom()) << "-" << describeSquare(move.getTo());
+    text << " (" << result.nodes << " nodes" << (cached ? ", cached" : "") << ")\n";
+    return text.str();
+}
+
+// Whether an analysis is as deep as the one asked for will ever be, so it can be cached: it reached the
+// depth, or stopped for a reason load has nothing to do with (no move or only one, or a win seen to the end).
+// A search the node or time limit cut short isn't, so a later request can search it again, deeper
+static bool isCompleteAnalysis(const SearchResult &result, int depth)
+{
+    if (!result.hasMove || result.depth == 0 || result.depth >= depth)
+        return true;
+    return Search::isWinScore(result.score) && Search::WIN_SCORE - std::abs(result.score) <= result.depth;
+}
+
+// Analyses are queued on the search executor under an owner of their own for each client, apart
+// from the game sessions' (which are positive), so clients take turns with each other and the games
+static int getAnalysisOwner(const std::string &client)
+{
+    return -1 - (int)(std::hash<std::string>()(client) % 1000000);
+}
+
 void Server::onWebSocketOpen(websocketpp::connection_hdl hdl) {
-    std::cout << "WebSocket connection opened" << std::endl;
+    TRACE_INFO("WebSocket connection opened");
     // Store connection handle with placeholder client ID
     wsConnections[hdl] = "Unknown";
 }
 
 void Server::onWebSocketClose(websocketpp::connection_hdl hdl) {
-    std::cout << "WebSocket connection closed" << std::endl;
+    TRACE_INFO("WebSocket connection closed");
     // Remove from connections map
     wsConnections.erase(hdl);
 }
@@ -293,7 +413,7 @@ void Server::recordLoss(const std::string& username) {
 
 void Server::onWebSocketMessage(websocketpp::connection_hdl hdl, message_ptr msg) {
     std::string message = msg->get_payload();
-    std::cout << "Received WebSocket message: " << message << std::endl;
+    TRACE_DEBUG("Received WebSocket message: " << message);
     
     // Process commands similar to handleClientConnection
     std::string upperMessage = message;
@@ -310,11 +430,11 @@ void Server::onWebSocketMessage(websocketpp::connection_hdl hdl, message_ptr msg
             std::string command, username, password;
             iss >> command >> username >> password;  
 
-            std::cout << "[LOGIN] Trying username: " << username << std::endl;
+            TRACE_INFO("[LOGIN] Trying username: " << username);
 
     if (!username.empty() && !password.empty()) {
         std::string hashed = SHA256::hash(password);
-        std::cout << "[LOGIN] Password (hashed): " << hashed << std::endl;
+        TRACE_DEBUG("[LOGIN] Password (hashed): " << hashed);
 
         if (dbManager.validateUser(username, hashed)) {
             wsConnections[hdl] = username;
@@ -348,17 +468,47 @@ void Server::onWebSocketMessage(websocketpp::connection_hdl hdl, message_ptr msg
                 response = "{ \"type\": \"error\", \"message\": \"Registration failed. Username may already exist.\" }";
             }  
               
+            } else if (upperMessage.find("CREATE_AI") == 0) {
+            // Format: CREATE_AI [level] [white|black] (the level from 1 to 5, the color the player plays)
+            std::string command, levelName, colorName;
+            iss >> command >> levelName >> colorName;
+            int level = levelName.empty() ? 3 : atoi(levelName.c_str());
+            bool playerIsWhite = colorName != "black" && colorName != "BLACK";
+
+            std::string clientId = wsConnections[hdl];
+            if (clientId == "Unknown") {
+                response = "{ \"type\": \"error\", \"message\": \"Please login first\" }";
+            } else if (level < SearchExecutor::MIN_LEVEL || level > SearchExecutor::MAX_LEVEL) {
+                response = "{ \"type\": \"error\", \"message\": \"The computer's level must be from 1 to 5\" }";
+            } else {
+                int gameSessionId = createEngineGameSession(clientId, level, playerIsWhite);
+                GameSession* session = getGameSession(gameSessionId);
+                if (session) {
+                    session->addWebSocketHandle(hdl, &wsServer);
+                    response = session->getBoardStateJson();
+                    // (only now that its clients are added, if the computer plays white)
+                    scheduleEngineMove(gameSessionId);
+                } else {
+                    response = "{ \"type\": \"error\", \"message\": \"The computer is too busy to play right now\" }";
+                }
+            }
             } else if (upperMessage.find("CREATE") == 0) {
+            // Format: CREATE [english|international]
+            std::string command, variantName;
+            iss >> command >> variantName;
+            GameVariant variant = getVariantFromName(variantName);
+
             std::string clientId = wsConnections[hdl];
             if (clientId != "Unknown") {
-                int gameSessionId = createGameSession(clientId);
+                int gameSessionId = createGameSession(clientId, variant);
     
                 GameSession* session = getGameSession(gameSessionId);
                 if (session) {
                     session->addWebSocketHandle(hdl, &wsServer);
                 }
     
-                response = "{ \"type\": \"game_created\", \"gameCode\": \"" + gameCodes[gameSessionId] + "\" }";
+                response = "{ \"type\": \"game_created\", \"gameCode\": \"" + gameCodes[gameSessionId] +
+                           "\", \"variant\": \"" + getVariantName(variant) + "\" }";
             } else {
                 response = "{ \"type\": \"error\", \"message\": \"Please login first\" }";
             }
@@ -370,18 +520,18 @@ void Server::onWebSocketMessage(websocketpp::connection_hdl hdl, message_ptr msg
                 if (clientId != "Unknown") {
                     std::string code = message.substr(pos + 1);
                     int sessionId = 0;
-                    std::cout << "Client " << clientId << " attempting to join with code " << code << std::endl;
+                    TRACE_INFO("Client " << clientId << " attempting to join with code " << code);
 
                     for (const auto& [key, value] : gameCodes){
                      if (value == code){
                       sessionId = key;
                      }
                     }
-                    std::cout << "Trying to JOIN session with code: " << code << std::endl;
-                    std::cout << "Resolved session ID: " << sessionId << std::endl;
-                    std::cout << "Client ID: " << clientId << std::endl;
+                    TRACE_DEBUG("Trying to JOIN session with code: " << code);
+                    TRACE_DEBUG("Resolved session ID: " << sessionId);
+                    TRACE_DEBUG("Client ID: " << clientId);
                     if (!gameSessions.count(sessionId)) {
-                        std::cout << " Session ID " << sessionId << " not found in gameSessions!" << std::endl;
+                        TRACE_INFO(" Session ID " << sessionId << " not found in gameSessions!");
                     }
                     if (joinGameSession(sessionId, clientId)) {
                         GameSession* session = getGameSession(sessionId);
@@ -409,7 +559,7 @@ void Server::onWebSocketMessage(websocketpp::connection_hdl hdl, message_ptr msg
                 if (authenticateUser(username, password)) {
                     int wins = dbManager.getWins(username);
                     int losses = dbManager.getLosses(username);
-                    std::cout << "[LOGIN] Wins: " << wins << ", Losses: " << losses << std::endl;
+                    TRACE_INFO("[LOGIN] Wins: " << wins << ", Losses: " << losses);
                     
                     response = "{ \"type\": \"login_success\", \"username\": \"" + username +
                                "\", \"wins\": " + std::to_string(wins) +
@@ -419,12 +569,39 @@ void Server::onWebSocketMessage(websocketpp::connection_hdl hdl, message_ptr msg
             }
         }
         
+        else if (upperMessage.find("ANALYZE") == 0) {
+            // Format: ANALYZE [position] [depth] (the client's game if no position is given)
+            std::string clientId = wsConnections[hdl];
+            GameSession* session = clientId != "Unknown" ? getGameSession(findActiveSession(clientId)) : nullptr;
+            BasicBoard<EnglishRules> position;
+            int depth;
+            std::string error;
+            if (!parseAnalyzeCommand(message, session, position, depth, error)) {
+                response = "{ \"type\": \"error\", \"message\": \"" + error + "\" }";
+            } else {
+                // answered when the search is done (or at once, if the position is cached)
+                std::string requester = clientId != "Unknown" ? clientId : "ws:" + std::to_string((uintptr_t)hdl.lock().get());
+                requestAnalysis(getAnalysisOwner(requester), position, depth, [this, hdl, depth](bool searched, const SearchResult &result, bool cached) {
+                    std::string reply = searched ? describeAnalysisJson(result, depth, cached)
+                                                 : "{ \"type\": \"error\", \"message\": \"The server is too busy to analyze right now\" }";
+                    try {
+                        wsServer.send(hdl, reply, websocketpp::frame::opcode::text);
+                    } catch (const websocketpp::exception& e) {
+                        TRACE_ERROR("Failed to send analysis: " << e.what());
+                    }
+                });
+                return;
+            }
+        }
         else if (upperMessage.find("MOVE") == 0) {
     // Format: MOVE fromX fromY toX toY
     std::string clientId = wsConnections[hdl];
     int gameSessionId = -1;
 
   for (const auto& [id, session] : gameSessions) {
+    // finished games don't hold on to their players
+    if (session->isGameOver())
+        continue;
     if (session->getPlayer2Id() == clientId || session->getPlayer1Id() == clientId) {
         gameSessionId = id;
         break;
@@ -438,25 +615,10 @@ void Server::onWebSocketMessage(websocketpp::connection_hdl hdl, message_ptr msg
             if (session) {
                 bool moveResult = session->makeMove(clientId, fromX, fromY, toX, toY);
 
-             std::ostringstream moveJson;
-            moveJson << "{";
-            moveJson << "\"type\":\"MoveResult\",";
-            moveJson << "\"success\":" << (moveResult ? "true" : "false") << ",";
-            moveJson << "\"from\":[" << fromX << "," << fromY << "],";
-            moveJson << "\"to\":[" << toX << "," << toY << "],";
-            moveJson << "\"board\":" << session->getBoardStateJson() << ",";  // Keep this if getBoardState() still returns json
-            moveJson << "\"nextTurn\":" << session->getCurrentTurn();
-            moveJson << "}";
-
-            std::string jsonStr = moveJson.str();
-
                 // Send to all players in the session
-                for (auto& conn : session->getWsConnections()) {
-                    try {
-                        conn.second->send(conn.first, jsonStr, websocketpp::frame::opcode::text);
-                    } catch (const websocketpp::exception& e) {
-                        std::cerr << "WebSocket send failed: " << e.what() << std::endl;
-                    }
+                broadcastMoveResult(session, moveResult, fromX, fromY, toX, toY);
+                if (moveResult) {
+                    scheduleEngineMove(gameSessionId);
                 }
             }
         } else {
@@ -472,7 +634,7 @@ void Server::onWebSocketMessage(websocketpp::connection_hdl hdl, message_ptr msg
         // Add other commands (MOVE, STATE, etc.)
         
     } catch (const std::exception& e) {
-        std::cerr << "Exception processing WebSocket command: " << e.what() << std::endl;
+        TRACE_ERROR("Exception processing WebSocket command: " << e.what());
         response = "{ \"type\": \"error\", \"message\": \"Server error processing command\" }";
     }
     
@@ -480,7 +642,7 @@ void Server::onWebSocketMessage(websocketpp::connection_hdl hdl, message_ptr msg
     try {
         wsServer.send(hdl, response, websocketpp::frame::opcode::text);
     } catch (const websocketpp::exception& e) {
-        std::cerr << "Failed to send WebSocket response: " << e.what() << std::endl;
+        TRACE_ERROR("Failed to send WebSocket response: " << e.what());
     }
 }
 
@@ -502,6 +664,19 @@ void Server::stop()
         acceptThread.join();
     }
 
+    // Finish the computer's searches before the sessions they play in go
+    searchExecutor->shutdown();
+
+    // the analyses still queued were dropped with the executor's queue, so answer whoever waits for them
+    std::vector<AnalysisKey> unfinished;
+    {
+        std::lock_guard<std::mutex> analysesLock(analysesMutex);
+        for (const auto &pending : pendingAnalyses)
+            unfinished.push_back(pending.first);
+    }
+    for (const AnalysisKey &key : unfinished)
+        finishAnalysis(key, false, SearchResult());
+
     // Close all client sockets
     std::lock_guard<std::mutex> lock(sessionsMutex);
     for (auto &pair : gameSessions)
@@ -512,7 +687,7 @@ void Server::stop()
   
     gameCodes.clear();
 
-    std::cout << "Server stopped" << std::endl;
+    TRACE_INFO("Server stopped");
 }
 
 void Server::acceptConnections()
@@ -533,13 +708,13 @@ void Server::acceptConnections()
                 break;
             }
 
-            std::cerr << "Failed to accept connection: " << SocketWrapper::getLastError() << std::endl;
+            TRACE_ERROR("Failed to accept connection: " << SocketWrapper::getLastError());
             continue;
         }
 
-        std::cout << "New connection from "
-                  << inet_ntoa(clientAddress.sin_addr) << ":"
-                  << ntohs(clientAddress.sin_port) << std::endl;
+        TRACE_INFO("New connection from "
+                   << inet_ntoa(clientAddress.sin_addr) << ":"
+                   << ntohs(clientAddress.sin_port));
 
         // Handle the connection in the thread pool
         threadPool->enqueue([this, clientSocket]()
@@ -576,7 +751,7 @@ void Server::handleClientConnection(socket_t clientSocket)
                 // Null-terminate the received data
                 buffer[bytesRead] = '\0';
                 std::string message(buffer);
-                std::cout << "Received: " << message << std::endl;
+                TRACE_DEBUG("Received: " << message);
 
                 // Create uppercase version for case-insensitive command matching
                 std::string upperMessage = message;
@@ -600,12 +775,56 @@ void Server::handleClientConnection(socket_t clientSocket)
                             SocketWrapper::sendData(clientSocket, response.c_str(), response.length());
                         }
                     }
+                    else if (upperMessage.find("CREATE_AI") == 0)
+                    {
+                        // Format: CREATE_AI [level] [white|black]
+                        std::istringstream iss(message);
+                        std::string command, levelName, colorName;
+                        iss >> command >> levelName >> colorName;
+                        int level = levelName.empty() ? 3 : atoi(levelName.c_str());
+                        bool playerIsWhite = colorName != "black" && colorName != "BLACK";
+
+                        std::string response;
+                        if (clientId == "Unknown")
+                        {
+                            response = "Please login first with LOGIN username\n";
+                        }
+                        else if (level < SearchExecutor::MIN_LEVEL || level > SearchExecutor::MAX_LEVEL)
+                        {
+                            response = "The computer's level must be from 1 to 5\n";
+                        }
+                        else
+                        {
+                            int sessionId = createEngineGameSession(clientId, level, playerIsWhite);
+                            GameSession *session = getGameSession(sessionId);
+                            if (session)
+                            {
+                                gameSessionId = sessionId;
+                                session->addClientSocket(clientSocket);
+                                response = "Game created with ID: " + std::to_string(sessionId) + " against the computer (level " +
+                                           std::to_string(level) + "), you play " + (playerIsWhite ? "white" : "black") + "\n";
+                                // (only now that the client is added, if the computer plays white)
+                                scheduleEngineMove(sessionId);
+                            }
+                            else
+                            {
+                                response = "The computer is too busy to play right now\n";
+                            }
+                        }
+                        SocketWrapper::sendData(clientSocket, response.c_str(), response.length());
+                    }
                     else if (upperMessage.find("CREATE") == 0)
                     {
+                        // Format: CREATE [english|international]
+                        std::istringstream iss(message);
+                        std::string command, variantName;
+                        iss >> command >> variantName;
+                        GameVariant variant = getVariantFromName(variantName);
+
                         // Create a new game
                         if (clientId != "Unknown")
                         {
-                            gameSessionId = createGameSession(clientId);
+                            gameSessionId = createGameSession(clientId, variant);
 
                             // Get the session and add this client's socket
                             GameSession *session = getGameSession(gameSessionId);
@@ -614,7 +833,8 @@ void Server::handleClientConnection(socket_t clientSocket)
                                 session->addClientSocket(clientSocket);
                             }
 
-                            std::string response = "Game created with ID: " + std::to_string(gameSessionId) + "\n";
+                            std::string response = "Game created with ID: " + std::to_string(gameSessionId) +
+                                                   " (" + getVariantName(variant) + ")\n";
                             SocketWrapper::sendData(clientSocket, response.c_str(), response.length());
                         }
                         else
@@ -664,17 +884,21 @@ void Server::handleClientConnection(socket_t clientSocket)
                                 GameSession *session = getGameSession(gameSessionId);
                                 if (session)
                                 {
-                                    std::cout << "*** Before move call for " << clientId << " ***" << std::endl;
+                                    TRACE_DEBUG("*** Before move call for " << clientId << " ***");
 
                                     bool moveResult = session->makeMove(clientId, fromX, fromY, toX, toY);
 
-                                    std::cout << "*** After move call, result: " << (moveResult ? "success" : "failure") << " ***" << std::endl;
+                                    TRACE_DEBUG("*** After move call, result: " << (moveResult ? "success" : "failure") << " ***");
 
                                     if (!moveResult)
                                     {
                                         std::string response = "Invalid move\n";
                                         SocketWrapper::sendData(clientSocket, response.c_str(), response.length());
                                     }
+                                    else
+                                    {
+                                        scheduleEngineMove(gameSessionId);
+                                    }
                                 }
                                 else
                                 {
@@ -694,6 +918,35 @@ void Server::handleClientConnection(socket_t clientSocket)
                             SocketWrapper::sendData(clientSocket, response.c_str(), response.length());
                         }
                     }
+                    else if (upperMessage.find("ANALYZE") == 0)
+                    {
+                        // Format: ANALYZE [position] [depth] (this client's game if no position is given)
+                        GameSession *session = gameSessionId != -1 ? getGameSession(gameSessionId) : nullptr;
+                        BasicBoard<EnglishRules> position;
+                        int depth;
+                        std::string error;
+                        std::string response;
+                        if (!parseAnalyzeCommand(message, session, position, depth, error))
+                        {
+                            response = error + "\n";
+                        }
+                        else
+                        {
+                            // this connection's thread only waits for its own answer; the search runs on the executor
+                            auto reply = std::make_shared<std::promise<std::string>>();
+                            std::future<std::string> answer = reply->get_future();
+                            std::string requester = clientId != "Unknown" ? clientId : "tcp:" + std::to_string((long long)clientSocket);
+                            requestAnalysis(getAnalysisOwner(requester), position, depth, [this, reply, depth](bool searched, const SearchResult &result, bool cached) {
+                                if (searched)
+                                    reply->set_value(describeAnalysisText(result, depth, cached));
+                                else
+                                    reply->set_value(running ? "The server is too busy to analyze right now\n" : "The server is shutting down\n");
+                            });
+                            // every request is answered: searched, turned away, or dropped when the server stops
+                            response = answer.get();
+                        }
+                        SocketWrapper::sendData(clientSocket, response.c_str(), response.length());
+                    }
                     else if (upperMessage.find("STATE") == 0)
                     {
                         // Get current game state
@@ -717,10 +970,12 @@ void Server::handleClientConnection(socket_t clientSocket)
                         // Send available commands
                         std::string response = "Available commands:\n";
                         response += "LOGIN username - Log in with a username\n";
-                        response += "CREATE - Create a new game\n";
+                        response += "CREATE [english|international] - Create a new game (8x8 checkers by default)\n";
+                        response += "CREATE_AI [level] [white|black] - Play the computer (level 1 to 5, default 3; white by default)\n";
                         response += "JOIN gameId - Join an existing game\n";
                         response += "MOVE fromX fromY toX toY - Make a move\n";
                         response += "STATE - Get the current game state\n";
+                        response += "ANALYZE [position] [depth] - Get the best move, score and line for your game or a position (e.g. W:W9,10,K14:B22,23)\n";
                         response += "HELP - Show this help message\n";
                         SocketWrapper::sendData(clientSocket, response.c_str(), response.length());
                     }
@@ -733,42 +988,48 @@ void Server::handleClientConnection(socket_t clientSocket)
                 }
                 catch (const std::exception &e)
                 {
-                    std::cerr << "Exception processing command: " << e.what() << std::endl;
+                    TRACE_ERROR("Exception processing command: " << e.what());
                     std::string response = "Server error processing command\n";
                     SocketWrapper::sendData(clientSocket, response.c_str(), response.length());
                 }
                 catch (...)
                 {
-                    std::cerr << "Unknown exception processing command" << std::endl;
+                    TRACE_ERROR("Unknown exception processing command");
                     std::string response = "Server error processing command\n";
                     SocketWrapper::sendData(clientSocket, response.c_str(), response.length());
                 }
             }
             catch (const std::exception &e)
             {
-                std::cerr << "Exception in client communication loop: " << e.what() << std::endl;
+                TRACE_ERROR("Exception in client communication loop: " << e.what());
             }
             catch (...)
             {
-                std::cerr << "Unknown exception in client communication loop" << std::endl;
+                TRACE_ERROR("Unknown exception in client communication loop");
             }
         }
     }
     catch (const std::exception &e)
     {
-        std::cerr << "Exception in handleClientConnection: " << e.what() << std::endl;
+        TRACE_ERROR("Exception in handleClientConnection: " << e.what());
     }
     catch (...)
     {
-        std::cerr << "Unknown exception in handleClientConnection" << std::endl;
+        TRACE_ERROR("Unknown exception in handleClientConnection");
     }
 
     // Close the client socket
     SocketWrapper::closeSocket(clientSocket);
-    std::cout << "Client disconnected: " << clientId << std::endl;
+    TRACE_INFO("Client disconnected: " << clientId);
 }
 
-int Server::createGameSession(const std::string &player1Id)
+int Server::reserveSessionId()
+{
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    return nextSessionId++;
+}
+
+int Server::createGameSession(const std::string &player1Id, GameVariant variant, int sessionId)
 {
     std::lock_guard<std::mutex> lock(sessionsMutex);
 
@@ -785,8 +1046,10 @@ int Server::createGameSession(const std::string &player1Id)
     }
 
     // Create a new game session
-    int sessionId = nextSessionId++;
-    GameSession* session = new GameSession(inviteCode, sessionId, player1Id, &dbManager);  // pass dbManager
+    if (sessionId == 0)
+        sessionId = nextSessionId++;
+    const EndgameDatabase* endgameDb = endgames.getMaxPieces() > 0 ? &endgames : nullptr;
+    GameSession* session = new GameSession(inviteCode, sessionId, player1Id, &dbManager, variant, endgameDb);  // pass dbManager
 
     // Store it
     gameSessions[sessionId] = session;
@@ -795,7 +1058,224 @@ int Server::createGameSession(const std::string &player1Id)
     return sessionId;
 }
 
+int Server::createEngineGameSession(const std::string &playerId, int level, bool playerIsWhite)
+{
+    // a full queue would only leave the new game waiting on its first move
+    if (searchExecutor->getQueuedCount() >= (size_t)MAX_QUEUED_SEARCHES)
+    {
+        TRACE_WARN("Not starting a game against the computer: " << MAX_QUEUED_SEARCHES << " searches already queued");
+        return -1;
+    }
+
+    int sessionId = reserveSessionId();
+    std::string engineId = ENGINE_ID_PREFIX + ("L" + std::to_string(level) + "-" + std::to_string(sessionId));
+    createGameSession(playerIsWhite ? playerId : engineId, ENGLISH_CHECKERS, sessionId);
+    joinGameSession(sessionId, playerIsWhite ? engineId : playerId);
+    GameSession *session = getGameSession(sessionId);
+    if (session == nullptr)
+        return -1;
+    session->setEngineOpponent(!playerIsWhite, level);
+    return sessionId;
+}
+
+void Server::scheduleEngineMove(int sessionId)
+{
+    GameSession *session = getGameSession(sessionId);
+    if (session == nullptr || !session->hasEngineOpponent())
+        return;
+
+    // copied now, so the search never touches the session while it runs
+    BasicBoard<EnglishRules> position;
+    std::vector<hashkey_t> history;
+    size_t positionCount = session->getEngineSearch(position, history);
+    if (positionCount == 0)
+        return;
+    SearchLimits limits = session->getMoveLimits(session->isEngineWhite(), timeManager,
+                                                 SearchExecutor::getLevelLimits(session->getEngineLevel()));
+    if (limits.maxMilliseconds <= 0 || limits.maxMilliseconds > SearchExecutor::MAX_SEARCH_MILLISECONDS)
+        limits.maxMilliseconds = SearchExecutor::MAX_SEARCH_MILLISECONDS;
+
+    bool queued = searchExecutor->submit(sessionId, [this, sessionId, position, history, positionCount, limits](Search &search) {
+        search.setGameHistory(history);
+        SearchResult result = search.run(position, limits);
+
+        // the session outlives the search (the executor is shut down before sessions are deleted)
+        GameSession *session = getGameSession(sessionId);
+        if (session == nullptr)
+            return;
+        if (!result.hasMove)
+        {
+            session->engineHasNoMoves();
+            return;
+        }
+
+        int fromSquare = result.bestMove.getFrom();
+        int toSquare = result.bestMove.getTo();
+        if (session->makeEngineMove(positionCount, result.bestMove))
+        {
+            coords_t from = session->getGameBoard().getCoordsFromSquare(fromSquare);
+            coords_t to = session->getGameBoard().getCoordsFromSquare(toSquare);
+            TRACE_INFO("Game " << sessionId << ": the computer moved (" << from[0] << "," << from[1] << ") to ("
+                       << to[0] << "," << to[1] << ") after " << result.nodes << " nodes, depth " << result.depth);
+            broadcastMoveResult(session, true, from[0], from[1], to[0], to[1]);
+        }
+    });
+    if (!queued)
+        TRACE_ERROR("Game " << sessionId << ": could not queue the computer's search");
+}
+
+void Server::requestAnalysis(int owner, const BasicBoard<EnglishRules> &position, int depth, AnalysisCallback callback)
+{
+    AnalysisKey key = { position.getHash(), depth };
+    SearchResult result;
+    if (analysisCache.find(key, result))
+    {
+        callback(true, result, true);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(analysesMutex);
+        // someone else's search of the position answers this request too
+        std::vector<AnalysisCallback> &waiting = pendingAnalyses[key];
+        waiting.push_back(callback);
+        if (waiting.size() > 1)
+            return;
+    }
+
+    SearchLimits limits;
+    limits.maxDepth = depth;
+    limits.maxNodes = ANALYSIS_NODES;
+    limits.maxMilliseconds = SearchExecutor::MAX_SEARCH_MILLISECONDS;
+    bool queued = searchExecutor->submit(owner, [this, key, position, limits](Search &search) {
+        // the position alone is analyzed, whatever game it came from, so any game can share the result
+        search.setGameHistory(std::vector<hashkey_t>());
+        SearchResult result = search.run(position, limits);
+        if (isCompleteAnalysis(result, key.depth))
+            analysisCache.insert(key, result);
+        finishAnalysis(key, true, result);
+    });
+    if (!queued)
+    {
+        TRACE_WARN("Could not queue an analysis: " << MAX_QUEUED_SEARCHES << " searches already queued");
+        finishAnalysis(key, false, SearchResult());
+    }
+}
+
+void Server::finishAnalysis(const AnalysisKey &key, bool searched, const SearchResult &result)
+{
+    std::vector<AnalysisCallback> waiting;
+    {
+        std::lock_guard<std::mutex> lock(analysesMutex);
+        auto it = pendingAnalyses.find(key);
+        if (it == pendingAnalyses.end())
+            return;
+        waiting.swap(it->second);
+        pendingAnalyses.erase(it);
+    }
+
+    // (outside the lock, since they send to the network)
+    for (AnalysisCallback &callback : waiting)
+        callback(searched, result, false);
+}
+
+bool Server::parseAnalyzeCommand(const std::string &message, GameSession *session, BasicBoard<EnglishRules> &position,
+                                 int &depth, std::string &error)
+{
+    std::istringstream iss(message);
+    std::string command, word;
+    iss >> command;
+
+    depth = DEFAULT_ANALYSIS_DEPTH;
+    bool hasPosition = false;
+    while (iss >> word)
+    {
+        if (word.find(':') != std::string::npos)
+        {
+            if (!parsePosition(word, position))
+            {
+                error = "Invalid position. Use, e.g.: W:W9,10,K14:B22,23 (side to move, then each side's squares 1-32, K for kings)";
+                return false;
+            }
+            hasPosition = true;
+        }
+        else if (isdigit((unsigned char)word[0]))
+        {
+            // the node budget is the server's to set, but the depth can be asked for
+            depth = std::max(1, std::min((int)MAX_ANALYSIS_DEPTH, atoi(word.c_str())));
+        }
+        else
+        {
+            error = "Invalid analyze format. Use: ANALYZE [position] [depth]";
+            return false;
+        }
+    }
+
+    if (!hasPosition)
+    {
+        if (session == nullptr)
+        {
+            error = "Give a position to analyze, or join a game first";
+            return false;
+        }
+        if (!session->getAnalysisPosition(position))
+        {
+            error = "Only 8x8 checkers positions can be analyzed";
+            return false;
+        }
+    }
+    return true;
+}
+
+int Server::findActiveSession(const std::string &clientId)
+{
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    for (const auto &[id, session] : gameSessions)
+    {
+        // finished games don't hold on to their players
+        if (!session->isGameOver() && (session->getPlayer1Id() == clientId || session->getPlayer2Id() == clientId))
+            return id;
+    }
+    return -1;
+}
+
+void Server::broadcastMoveResult(GameSession *session, bool success, int fromX, int fromY, int toX, int toY)
+{
+    std::ostringstream moveJson;
+    moveJson << "{";
+    moveJson << "\"type\":\"MoveResult\",";
+    moveJson << "\"success\":" << (success ? "true" : "false") << ",";
+    moveJson << "\"from\":[" << fromX << "," << fromY << "],";
+    moveJson << "\"to\":[" << toX << "," << toY << "],";
+    moveJson << "\"board\":" << session->getBoardStateJson() << ",";  // Keep this if getBoardState() still returns json
+    moveJson << "\"nextTurn\":" << session->getCurrentTurn();
+    moveJson << "}";
+
+    std::string jsonStr = moveJson.str();
+    for (auto& conn : session->getWsConnections()) {
+        try {
+            conn.second->send(conn.first, jsonStr, websocketpp::frame::opcode::text);
+        } catch (const websocketpp::exception& e) {
+            TRACE_ERROR("WebSocket send failed: " << e.what());
+        }
+    }
+}
+
+// Opens the endgame databases games look their endgames up in; returns the most pieces they cover.
+// Call before the server starts, since sessions read them without locking.
+int Server::openEndgameDatabase(const std::string &directory)
+{
+    int maxPieces = endgames.open(directory);
+    if (maxPieces == 0)
+        TRACE_WARN("No complete endgame databases in " << directory);
+    searchExecutor->setEndgameDatabase(maxPieces > 0 ? &endgames : nullptr);
+    return maxPieces;
+}
+
 bool Server::registerUser(const std::string& username, const std::string& email, const std::string& password) {
+    // the computer's names are its own, so no one is credited with its games
+    if (username.compare(0, std::strlen(ENGINE_ID_PREFIX), ENGINE_ID_PREFIX) == 0)
+        return false;
     std::string hashed = SHA256::hash(password);
     return dbManager.createUser(username, email, hashed);
 }
@@ -1,37 +1,49 @@
 // server/src/Session.cpp - update with board handling
 #include "../include/Session.h"
 #include "../include/SocketWrapper.h"
-#include <iostream>
+#include "../GameLogic/Trace.h"
+#include "../GameLogic/EndgameDatabase.h"
 #include <sstream>
 
 #include "../include/nlohmann/json.hpp"
 using nlohmann::json;
 
-GameSession::GameSession(std::string inviteCode, int id, const std::string &p1Id, DatabaseManager* dbRef)
+GameSession::GameSession(std::string inviteCode, int id, const std::string &p1Id, DatabaseManager* dbRef,
+                         GameVariant variant, const EndgameDatabase* endgameDb)
     : sessionId(id),
       player1Id(p1Id),
       gameStarted(false),
-      gameBoard(), // Initialize a new board
+      db(dbRef),
+      gameBoard(VariantBoard::create(variant)), // Initialize a new board of the chosen variant
       isPlayer1Turn(true),
-      db(dbRef)
+      gameOver(false),
+      endgames(endgameDb),
+      timed(false),
+      turnStart(std::chrono::steady_clock::now()),
+      hasEngine(false),
+      engineIsWhite(false),
+      engineLevel(0),
+      lastIrreversibleIndex(0)
 {
-    std::cout << "Game session " << id << " created with player: " << p1Id << std::endl;
+    positionHistory.push_back(gameBoard->getHash());
+    TRACE_INFO("Game session " << id << " (" << getVariantName(variant) << ") created with player: " << p1Id);
 }
 
 
 
-int GameSession::mutexOperationId = 0;
+std::atomic<int> GameSession::mutexOperationId(0);
 
-void GameSession::logMutexAcquire(const std::string &methodName)
+// (the operation ids are counted whatever the trace level, so the numbering doesn't depend on it)
+void GameSession::logMutexAcquire([[maybe_unused]] const std::string &methodName)
 {
-    int opId = ++mutexOperationId;
-    std::cout << "MUTEX [" << opId << "] ACQUIRING in " << methodName << std::endl;
+    [[maybe_unused]] int operationId = ++mutexOperationId;
+    TRACE_DEBUG("MUTEX [" << operationId << "] ACQUIRING in " << methodName);
 }
 
-void GameSession::logMutexRelease(const std::string &methodName)
+void GameSession::logMutexRelease([[maybe_unused]] const std::string &methodName)
 {
-    int opId = ++mutexOperationId;
-    std::cout << "MUTEX [" << opId << "] RELEASED in " << methodName << std::endl;
+    [[maybe_unused]] int operationId = ++mutexOperationId;
+    TRACE_DEBUG("MUTEX [" << operationId << "] RELEASED in " << methodName);
 }
 
 GameSession::~GameSession()
@@ -42,7 +54,7 @@ GameSession::~GameSession()
         SocketWrapper::closeSocket(socket);
     }
 
-    std::cout << "Game session " << sessionId << " destroyed" << std::endl;
+    TRACE_INFO("Game session " << sessionId << " destroyed");
 }
 
 bool GameSession::joinGame(const std::string &p2Id)
@@ -52,57 +64,39 @@ bool GameSession::joinGame(const std::string &p2Id)
     // Check if game is already full
     if (!player2Id.empty())
     {
-        std::cout << "[JOIN FAILED] Game already has 2 players." << std::endl;
+        TRACE_INFO("[JOIN FAILED] Game already has 2 players.");
         return false;
     }
 
     // Prevent player1 from joining again
     if (p2Id == player1Id)
     {
-        std::cout << "[JOIN FAILED] Player " << p2Id << " is already player1." << std::endl;
+        TRACE_INFO("[JOIN FAILED] Player " << p2Id << " is already player1.");
         return false;
     }
 
     // Set player 2
     player2Id = p2Id;
     gameStarted = true;
+    // white's clock starts now
+    turnStart = std::chrono::steady_clock::now();
 
-    std::cout << "Player " << p2Id << " joined game session " << sessionId << std::endl;
+    TRACE_INFO("Player " << p2Id << " joined game session " << sessionId);
 
     return true;
 }
 
 bool GameSession::playerHasJumps(bool isWhiteTurn)
 {
-    // Loop through all board positions
-    for (int y = 0; y < Board::SIZE; y++)
+    if (gameBoard->hasAnyCapture(isWhiteTurn))
     {
-        for (int x = 0; x < Board::SIZE; x++)
-        {
-            Piece *pieceAtPos = gameBoard.getValueAt(x, y);
-            // If there's a piece and it belongs to the current player
-            if (pieceAtPos && pieceAtPos->isWhite == isWhiteTurn)
-            {
-                // Get all possible moves
-                moves_t pieceMoves = pieceAtPos->getAllPossibleMoves(gameBoard);
-                for (auto &move : pieceMoves)
-                {
-                    // Check if any move is a jump
-                    std::vector<Piece *> jumpedPieces = move->getJumpedPieces(gameBoard);
-                    if (!jumpedPieces.empty())
-                    {
-                        std::cout << "Jump available for " << (isWhiteTurn ? "White" : "Black")
-                                  << " piece at (" << x << "," << y << ")" << std::endl;
-                        return true;
-                    }
-                }
-            }
-        }
+        TRACE_DEBUG("Jump available for " << (isWhiteTurn ? "White" : "Black"));
+        return true;
     }
     return false;
 }
 
-bool GameSession::makeMove(const std::string &playerId, int fromX, int fromY, int toX, int toY)
+bool GameSession::makeMove(const std::string &playerId, int fromX, int fromY, int toX, int toY, std::uint64_t captures)
 {
     logMutexAcquire("makeMove");
     std::lock_guard<std::mutex> lock(gameMutex);
@@ -110,154 +104,96 @@ bool GameSession::makeMove(const std::string &playerId, int fromX, int fromY, in
     try
     {
         // Print debug info
-        std::cout << "Attempting move by " << playerId << " from ("
-                  << fromX << "," << fromY << ") to ("
-                  << toX << "," << toY << ")" << std::endl;
+        TRACE_INFO("Attempting move by " << playerId << " from ("
+                   << fromX << "," << fromY << ") to ("
+                   << toX << "," << toY << ")");
+
+        // A finished game takes no more moves
+        if (gameOver)
+        {
+            TRACE_INFO("Game " << sessionId << " is already over");
+            logMutexRelease("makeMove - game over");
+            return false;
+        }
 
         // Check if it's this player's turn
         bool isPlayer1 = (playerId == player1Id);
         if ((isPlayer1 && !isPlayer1Turn) || (!isPlayer1 && isPlayer1Turn))
         {
-            std::cout << "Not " << playerId << "'s turn" << std::endl;
+            TRACE_INFO("Not " << playerId << "'s turn");
             logMutexRelease("makeMove - not player's turn");
             return false; // Not this player's turn
         }
 
         // Check bounds
-        if (fromX < 0 || fromX >= Board::SIZE || fromY < 0 || fromY >= Board::SIZE ||
-            toX < 0 || toX >= Board::SIZE || toY < 0 || toY >= Board::SIZE)
+        int size = gameBoard->getSize();
+        if (fromX < 0 || fromX >= size || fromY < 0 || fromY >= size ||
+            toX < 0 || toX >= size || toY < 0 || toY >= size)
         {
-            std::cout << "Move coordinates out of bounds" << std::endl;
+            TRACE_INFO("Move coordinates out of bounds");
             logMutexRelease("makeMove - out of bounds");
             return false;
         }
 
-        // Get the piece at the starting position
-        std::cout << "Getting piece at position (" << fromX << "," << fromY << ")" << std::endl;
-        Piece *piece = gameBoard.getValueAt(fromX, fromY);
+        // Find the piece at the starting position
+        TRACE_DEBUG("Getting piece at position (" << fromX << "," << fromY << ")");
+        int fromSquare = gameBoard->getSquareFromCoords(fromX, fromY);
+        int toSquare = gameBoard->getSquareFromCoords(toX, toY);
+        std::uint64_t fromMask = fromSquare >= 0 ? (std::uint64_t)1 << fromSquare : 0;
 
         // Check if piece exists
-        if (piece == nullptr)
+        if (!((gameBoard->getPieceMask(true) | gameBoard->getPieceMask(false)) & fromMask))
         {
-            std::cout << "No piece at position (" << fromX << "," << fromY << ")" << std::endl;
+            TRACE_INFO("No piece at position (" << fromX << "," << fromY << ")");
             logMutexRelease("makeMove - no piece");
             return false;
         }
 
         // Check if piece belongs to the player
-        if (piece->isWhite != isPlayer1)
+        if (!(gameBoard->getPieceMask(isPlayer1) & fromMask))
         {
-            std::cout << "Piece doesn't belong to " << playerId << std::endl;
+            TRACE_INFO("Piece doesn't belong to " << playerId);
             logMutexRelease("makeMove - wrong piece color");
             return false;
         }
 
-        // Get all possible moves for this piece
-        std::cout << "Generating moves for piece at (" << fromX << "," << fromY
-                  << ") Color: " << (piece->isWhite ? "White" : "Black") << std::endl;
-
-        std::cout << "About to call getAllPossibleMoves..." << std::endl;
-        moves_t possibleMoves = piece->getAllPossibleMoves(gameBoard);
-        std::cout << "getAllPossibleMoves returned successfully with "
-                  << possibleMoves.size() << " moves" << std::endl;
-
-        // Print possible moves for debugging
-        std::cout << "Possible moves for piece at (" << fromX << "," << fromY << "): " << std::endl;
-        for (auto &move : possibleMoves)
+        // Generate every legal move for this player in one pass
+        // (if any jump is available, only the jumps are legal)
+        VariantMoveList legalMoves;
+        gameBoard->getLegalMoves(isPlayer1, legalMoves);
+        bool jumpRequired = !legalMoves.empty() && legalMoves[0].isJump;
+
+        // Print legal moves for debugging
+#if TRACE_LEVEL >= TRACE_LEVEL_DEBUG
+        TRACE_DEBUG("Legal moves for " << (isPlayer1 ? "White" : "Black") << ": "
+                    << legalMoves.size() << (jumpRequired ? " (jumps only)" : ""));
+        for (const VariantMove &move : legalMoves)
         {
-            coords_t endPos = move->getEndingPosition();
-            std::vector<Piece *> jumpedPieces = move->getJumpedPieces(gameBoard);
-            bool isJumpMove = !jumpedPieces.empty();
-            std::cout << "  -> (" << endPos[0] << "," << endPos[1] << ")"
-                      << (isJumpMove ? " [JUMP]" : "") << std::endl;
+            coords_t startPos = gameBoard->getCoordsFromSquare(move.from);
+            coords_t endPos = gameBoard->getCoordsFromSquare(move.to);
+            TRACE_DEBUG("  (" << startPos[0] << "," << startPos[1] << ") -> ("
+                        << endPos[0] << "," << endPos[1] << ")"
+                        << (move.isJump ? " [JUMP]" : ""));
         }
-
-        // Add detailed debugging for ALL pieces with possible moves
-        std::cout << "\n===== DEBUGGING ALL POSSIBLE MOVES =====\n";
-        bool anyJumpAvailable = false;
-        // Loop through all board positions
-        for (int y = 0; y < Board::SIZE; y++)
-        {
-            for (int x = 0; x < Board::SIZE; x++)
-            {
-                Piece *pieceAtPos = gameBoard.getValueAt(x, y);
-                // If there's a piece and it belongs to the current player
-                if (pieceAtPos && pieceAtPos->isWhite == isPlayer1)
-                {
-                    // Get all possible moves
-                    moves_t pieceMoves = pieceAtPos->getAllPossibleMoves(gameBoard);
-                    if (!pieceMoves.empty())
-                    {
-                        std::cout << "Generating moves for piece at (" << x << "," << y
-                                  << ") Color: " << (pieceAtPos->isWhite ? "White" : "Black")
-                                  << std::endl;
-
-                        bool hasJumps = false;
-                        // Display each move
-                        for (auto &m : pieceMoves)
-                        {
-                            coords_t endPos = m->getEndingPosition();
-                            std::vector<Piece *> jumpedPieces = m->getJumpedPieces(gameBoard);
-                            bool isJumpMove = !jumpedPieces.empty();
-                            if (isJumpMove)
-                            {
-                                hasJumps = true;
-                                anyJumpAvailable = true;
-                            }
-
-                            std::cout << "Found possible move to (" << endPos[0] << "," << endPos[1] << ")" << std::endl;
-                        }
-
-                        std::cout << "Total possible moves: " << pieceMoves.size() << std::endl;
-                        std::cout << "Piece at (" << x << "," << y
-                                  << ") Color: " << (pieceAtPos->isWhite ? "White" : "Black")
-                                  << " has " << pieceMoves.size() << " moves:" << std::endl;
-
-                        for (auto &m : pieceMoves)
-                        {
-                            coords_t endPos = m->getEndingPosition();
-                            std::vector<Piece *> jumpedPieces = m->getJumpedPieces(gameBoard);
-                            bool isJumpMove = !jumpedPieces.empty();
-
-                            std::cout << "  -> To (" << endPos[0] << "," << endPos[1] << ")"
-                                      << (isJumpMove ? " [JUMP]" : "") << std::endl;
-                        }
-
-                        if (hasJumps)
-                        {
-                            std::cout << "  ** This piece has jumps available! **" << std::endl;
-                        }
-                        std::cout << std::endl;
-                    }
-                }
-            }
-        }
-        std::cout << "====================================\n\n";
+#endif
 
         // Find if the requested move is valid
-        std::cout << "Checking if requested move matches a possible move..." << std::endl;
+        TRACE_DEBUG("Checking if requested move matches a legal move...");
         bool moveFound = false;
-        move_ptr_t validMove;
-        bool isJumpMove = false;
+        VariantMove validMove;
 
-        for (auto &move : possibleMoves)
+        for (const VariantMove &move : legalMoves)
         {
-            coords_t endPos = move->getEndingPosition();
-
-            if (endPos[0] == toX && endPos[1] == toY)
+            if (move.from == fromSquare && move.to == toSquare && (captures == ANY_CAPTURES || move.captures == captures))
             {
                 validMove = move;
                 moveFound = true;
 
-                // Check if this move is a jump
-                std::vector<Piece *> jumpedPieces = move->getJumpedPieces(gameBoard);
-                isJumpMove = !jumpedPieces.empty();
-
                 // If this is a jump, indicate it
-                if (isJumpMove)
+                if (move.isJump)
                 {
-                    std::cout << "Jump available from (" << fromX << "," << fromY
-                              << ") to (" << toX << "," << toY << ")" << std::endl;
+                    TRACE_DEBUG("Jump available from (" << fromX << "," << fromY
+                                << ") to (" << toX << "," << toY << ")");
                 }
                 break;
             }
@@ -265,29 +201,41 @@ bool GameSession::makeMove(const std::string &playerId, int fromX, int fromY, in
 
         if (!moveFound)
         {
-            std::cout << "Move to (" << toX << "," << toY << ") not found in possible moves" << std::endl;
+            // If ANY jump is available but the selected move is not one of them, the jump must be taken
+            if (jumpRequired)
+            {
+                TRACE_INFO("Jump is available, must take jump move");
+                logMutexRelease("makeMove - jump required");
+                return false;
+            }
+
+            TRACE_INFO("Move to (" << toX << "," << toY << ") not found in possible moves");
             logMutexRelease("makeMove - invalid move");
             return false; // Move not found in possible moves
         }
 
-        // If ANY jump is available but the selected move is not a jump, reject it
-        if (anyJumpAvailable && !isJumpMove)
+        // A player who has run out of time has lost, whatever the move
+        if (timed && !chargeClock(isPlayer1))
         {
-            std::cout << "Jump is available, must take jump move" << std::endl;
-            logMutexRelease("makeMove - jump required");
+            declareWinner(!isPlayer1, std::string(isPlayer1 ? "White" : "Black") + " ran out of time.");
+            logMutexRelease("makeMove - out of time");
             return false;
         }
 
+        // Captures and man moves can never be undone, which limits how far back a repetition can be
+        bool irreversible = validMove.isJump || !(gameBoard->getKingMask(isPlayer1) & fromMask);
+
         // Apply the move
-        std::cout << "Applying move to board..." << std::endl;
-        gameBoard.applyMoveToBoard(validMove, piece);
-        std::cout << "Move applied successfully" << std::endl;
+        TRACE_DEBUG("Applying move to board...");
+        gameBoard->applyMove(isPlayer1, validMove);
+        recordPosition(irreversible);
+        TRACE_DEBUG("Move applied successfully");
 
         // Toggle turn
         isPlayer1Turn = !isPlayer1Turn;
 
-        std::cout << "Move successful, turn is now "
-                  << (isPlayer1Turn ? "Player1" : "Player2") << std::endl;
+        TRACE_INFO("Move successful, turn is now "
+                   << (isPlayer1Turn ? "Player1" : "Player2"));
 
         // Capture the game state while the mutex is still held
         std::string gameState = getBoardState();
@@ -305,7 +253,7 @@ bool GameSession::makeMove(const std::string &playerId, int fromX, int fromY, in
             SocketWrapper::sendData(socket, message.c_str(), message.length());
         }
 
-        std::cout << "Broadcast complete" << std::endl;
+        TRACE_DEBUG("Broadcast complete");
 
         // Check if there's a winner
         checkForWinner();
@@ -314,13 +262,13 @@ bool GameSession::makeMove(const std::string &playerId, int fromX, int fromY, in
     }
     catch (const std::exception &e)
     {
-        std::cerr << "Exception in makeMove: " << e.what() << std::endl;
+        TRACE_ERROR("Exception in makeMove: " << e.what());
         logMutexRelease("makeMove - exception");
         return false;
     }
     catch (...)
     {
-        std::cerr << "Unknown exception in makeMove" << std::endl;
+        TRACE_ERROR("Unknown exception in makeMove");
         logMutexRelease("makeMove - unknown exception");
         return false;
     }
@@ -360,7 +308,7 @@ void GameSession::broadcastGameState()
                   }
               }
 
-    std::cout << "Broadcast completed" << std::endl;
+    TRACE_DEBUG("Broadcast completed");
 }
 
 // Implement in Session.cpp
@@ -370,27 +318,36 @@ bool GameSession::forceBlackMove(int fromX, int fromY, int toX, int toY)
 
     try
     {
-        std::cout << "Force-moving black piece from (" << fromX << "," << fromY
-                  << ") to (" << toX << "," << toY << ")" << std::endl;
+        TRACE_INFO("Force-moving black piece from (" << fromX << "," << fromY
+                   << ") to (" << toX << "," << toY << ")");
 
-        // Get the piece
-        Piece *piece = gameBoard.getValueAt(fromX, fromY);
-        if (!piece || piece->isWhite)
+        // Both squares must be playable squares on the board
+        int fromSquare = gameBoard->getSquareFromCoords(fromX, fromY);
+        int toSquare = gameBoard->getSquareFromCoords(toX, toY);
+        if (fromSquare < 0 || toSquare < 0)
         {
-            std::cout << "No black piece at the specified position" << std::endl;
+            TRACE_INFO("Force-move coordinates are not playable squares");
             return false;
         }
 
-        // Create a move directly
-        move_ptr_t move(new Move(fromX, fromY, toX, toY, nullptr, false));
+        // Get the piece
+        std::uint64_t fromMask = (std::uint64_t)1 << fromSquare;
+        if (!(gameBoard->getPieceMask(false) & fromMask))
+        {
+            TRACE_INFO("No black piece at the specified position");
+            return false;
+        }
 
-        // Apply it to the board
-        gameBoard.applyMoveToBoard(move, piece);
+        // Apply it to the board directly
+        bool irreversible = !(gameBoard->getKingMask(false) & fromMask);
+        gameBoard->forceMove(fromSquare, toSquare);
+        recordPosition(irreversible);
+        turnStart = std::chrono::steady_clock::now();
 
         // Toggle turn
         isPlayer1Turn = !isPlayer1Turn;
 
-        std::cout << "Force-move successful" << std::endl;
+        TRACE_INFO("Force-move successful");
 
         // Broadcast the state update
         try
@@ -401,26 +358,26 @@ bool GameSession::forceBlackMove(int fromX, int fromY, int toX, int toY)
                 std::string message = state + "\n";
                 SocketWrapper::sendData(socket, message.c_str(), message.length());
             }
-            std::cout << "Broadcast complete" << std::endl;
+            TRACE_DEBUG("Broadcast complete");
 
             // Check if there's a winner
             checkForWinner();
         }
         catch (const std::exception &e)
         {
-            std::cout << "Error broadcasting state: " << e.what() << std::endl;
+            TRACE_ERROR("Error broadcasting state: " << e.what());
         }
 
         return true;
     }
     catch (const std::exception &e)
     {
-        std::cout << "Exception in forceBlackMove: " << e.what() << std::endl;
+        TRACE_ERROR("Exception in forceBlackMove: " << e.what());
         return false;
     }
     catch (...)
     {
-        std::cout << "Unknown exception in forceBlackMove" << std::endl;
+        TRACE_ERROR("Unknown exception in forceBlackMove");
         return false;
     }
 }
@@ -435,21 +392,29 @@ std::string GameSession::getBoardState() const
     ss << "Turn: " << (isPlayer1Turn ? "Player1" : "Player2") << "\n\n";
 
     // Add ASCII board representation
-    ss << "  0 1 2 3 4 5 6 7\n";
-    for (int y = 0; y < Board::SIZE; y++)
+    int size = gameBoard->getSize();
+    std::uint64_t occupied = gameBoard->getPieceMask(true) | gameBoard->getPieceMask(false);
+    ss << " ";
+    for (int x = 0; x < size; x++)
+    {
+        ss << " " << x;
+    }
+    ss << "\n";
+    for (int y = 0; y < size; y++)
     {
         ss << y << " ";
-        for (int x = 0; x < Board::SIZE; x++)
+        for (int x = 0; x < size; x++)
         {
-            Piece *piece = gameBoard.getValueAt(x, y);
-            if (piece != nullptr)
+            int square = gameBoard->getSquareFromCoords(x, y);
+            std::uint64_t squareMask = square >= 0 ? (std::uint64_t)1 << square : 0;
+            if (occupied & squareMask)
             {
                 // Show piece type - white (W) or black (B)
-                ss << (piece->isWhite ? "W" : "B");
+                bool isWhite = (gameBoard->getPieceMask(true) & squareMask) != 0;
+                ss << (isWhite ? "W" : "B");
 
-                // Check if it's a king using the piece's getString() method
-                // which should include 'K' for kings
-                if (piece->getString().find("K") != std::string::npos)
+                // Check if it's a king
+                if (gameBoard->getKingMask(isWhite) & squareMask)
                 {
                     ss << "K";
                 }
@@ -458,7 +423,7 @@ std::string GameSession::getBoardState() const
                     ss << " ";
                 }
             }
-            else if (gameBoard.isCheckerboardSpace(x, y))
+            else if (square >= 0)
             {
                 ss << ". ";
             }
@@ -482,27 +447,32 @@ std::string GameSession::getBoardStateJson() const {
     ss << "\"gameInfo\":{";
     ss << "\"player1Id\":\"" << player1Id << "\",";
     ss << "\"player2Id\":\"" << player2Id << "\",";
-    ss << "\"currentTurn\":\"" << (isPlayer1Turn ? "Player1" : "Player2") << "\"";
+    ss << "\"currentTurn\":\"" << (isPlayer1Turn ? "Player1" : "Player2") << "\",";
+    ss << "\"variant\":\"" << getVariantName(gameBoard->getVariant()) << "\",";
+    ss << "\"size\":" << gameBoard->getSize();
     ss << "},";
 
     ss << "\"board\":[";
     if (gameStarted) {
-        for (int y = 0; y < Board::SIZE; ++y) {
+        int size = gameBoard->getSize();
+        for (int y = 0; y < size; ++y) {
             ss << "[";
-            for (int x = 0; x < Board::SIZE; ++x) {
-                Piece* piece = gameBoard.getValueAt(x, y);
-                if (piece) {
+            for (int x = 0; x < size; ++x) {
+                int square = gameBoard->getSquareFromCoords(x, y);
+                std::uint64_t squareMask = square >= 0 ? (std::uint64_t)1 << square : 0;
+                if ((gameBoard->getPieceMask(true) | gameBoard->getPieceMask(false)) & squareMask) {
+                    bool isWhite = (gameBoard->getPieceMask(true) & squareMask) != 0;
                     ss << "{";
-                    ss << "\"isWhite\":" << (piece->isWhite ? "true" : "false") << ",";
-                    ss << "\"isKing\":" << (piece->getString().find("K") != std::string::npos ? "true" : "false");
+                    ss << "\"isWhite\":" << (isWhite ? "true" : "false") << ",";
+                    ss << "\"isKing\":" << ((gameBoard->getKingMask(isWhite) & squareMask) ? "true" : "false");
                     ss << "}";
                 } else {
                     ss << "null";
                 }
-                if (x < Board::SIZE - 1) ss << ",";
+                if (x < size - 1) ss << ",";
             }
             ss << "]";
-            if (y < Board::SIZE - 1) ss << ",";
+            if (y < size - 1) ss << ",";
         }
     }
     ss << "]";
@@ -522,70 +492,250 @@ void GameSession::addClientSocket(socket_t socket)
 
 bool GameSession::checkForWinner()
 {
-    int whiteCount = 0;
-    int blackCount = 0;
+    if (gameOver)
+        return true;
 
     // Count all pieces on the board
-    for (int y = 0; y < Board::SIZE; y++)
-    {
-        for (int x = 0; x < Board::SIZE; x++)
-        {
-            Piece *pieceAtPos = gameBoard.getValueAt(x, y);
-            if (pieceAtPos != nullptr)
-            {
-                if (pieceAtPos->isWhite)
-                    whiteCount++;
-                else
-                    blackCount++;
-            }
-        }
-    }
+    int whiteCount = gameBoard->getPieceCount(true);
+    int blackCount = gameBoard->getPieceCount(false);
 
-    std::cout << "Piece count - White: " << whiteCount << ", Black: " << blackCount << std::endl;
+    TRACE_DEBUG("Piece count - White: " << whiteCount << ", Black: " << blackCount);
 
     // If either player has no pieces left, the other player wins
     if (whiteCount == 0 || blackCount == 0)
     {
-        std::string message;
-        if (whiteCount == 0)
-            message = "BLACK WINS! Player " + player2Id + " is victorious!\n";
-            if (db) {
-                db->incrementWins(player2Id);
-                db->incrementLosses(player1Id);
-            }        
-            else {
-            message = "WHITE WINS! Player " + player1Id + " is victorious!\n";
-            if (db) {
-                db->incrementWins(player1Id);
-                db->incrementLosses(player2Id);
-            }        
-            }
-        std::cout << message;
+        declareWinner(whiteCount > 0, "");
+        return true;
+    }
 
-        // Broadcast the win message to all clients
-            for (socket_t socket : clientSockets)
-            {
-                SocketWrapper::sendData(socket, message.c_str(), message.length());
-            }
+    // Endless king shuffles end the game as a draw
+    if (isRepetitionDraw())
+    {
+        declareDraw("The same position has come up three times.");
+        return true;
+    }
 
-            for (auto& conn : GameSession::wsConnections)
-            {
-                try {
-                    conn.second->send(conn.first, message, websocketpp::frame::opcode::text);
-                } catch (const websocketpp::exception& e) {
-                    std::cerr << "WebSocket send error: " << e.what() << std::endl;
-                }
-            }
+    return adjudicateEndgame();
+}
 
+// Ends the game once the endgame database knows how it ends with best play, rather than
+// leaving the players to shuffle kings around a result that can't change
+bool GameSession::adjudicateEndgame()
+{
+    if (endgames == nullptr || gameBoard->getVariant() != ENGLISH_CHECKERS ||
+        gameBoard->getPieceCount(true) + gameBoard->getPieceCount(false) > endgames->getMaxPieces())
+        return false;
 
+    // English boards only use the low 32 bits
+    bool whiteToMove = isPlayer1Turn;
+    int distance = 0;
+    EndgameResult result = endgames->probe((bitboard_t)gameBoard->getPieceMask(true), (bitboard_t)gameBoard->getPieceMask(false),
+                                           (bitboard_t)(gameBoard->getKingMask(true) | gameBoard->getKingMask(false)),
+                                           whiteToMove, &distance);
+    if (result == ENDGAME_DRAW)
+    {
+        declareDraw("The endgame database shows this position is a draw.");
+        return true;
+    }
+    if (result == ENDGAME_WIN || result == ENDGAME_LOSS)
+    {
+        bool whiteWins = (result == ENDGAME_WIN) == whiteToMove;
+        declareWinner(whiteWins, "The endgame database shows a forced win in " + std::to_string(distance) + " plies.");
         return true;
     }
-
     return false;
 }
 
+void GameSession::declareWinner(bool whiteWins, const std::string &reason)
+{
+    gameOver = true;
+
+    const std::string &winnerId = whiteWins ? player1Id : player2Id;
+    const std::string &loserId = whiteWins ? player2Id : player1Id;
+    std::string message = std::string(whiteWins ? "WHITE" : "BLACK") + " WINS! Player " + winnerId + " is victorious!";
+    if (!reason.empty())
+        message += " " + reason;
+    message += "\n";
+    // (the computer has no record, only the person playing it)
+    if (db)
+    {
+        if (!hasEngine || engineIsWhite != whiteWins)
+            db->incrementWins(winnerId);
+        if (!hasEngine || engineIsWhite == whiteWins)
+            db->incrementLosses(loserId);
+    }
+    TRACE_INFO(message);
+
+    // Broadcast the win message to all clients
+    sendToAllClients(message);
+}
+
+void GameSession::declareDraw(const std::string &reason)
+{
+    gameOver = true;
+
+    std::string message = "DRAW! " + reason + "\n";
+    TRACE_INFO(message);
+    sendToAllClients(message);
+}
+
+void GameSession::sendToAllClients(const std::string &message)
+{
+    for (socket_t socket : clientSockets)
+    {
+        SocketWrapper::sendData(socket, message.c_str(), message.length());
+    }
+
+    for (auto& conn : GameSession::wsConnections)
+    {
+        try {
+            conn.second->send(conn.first, message, websocketpp::frame::opcode::text);
+        } catch (const websocketpp::exception& e) {
+            TRACE_ERROR("WebSocket send error: " << e.what());
+        }
+    }
+}
+
+void GameSession::recordPosition(bool irreversible)
+{
+    if (irreversible)
+        lastIrreversibleIndex = positionHistory.size();
+    positionHistory.push_back(gameBoard->getHash());
+}
+
+bool GameSession::isRepetitionDraw() const
+{
+    // The key includes the side to move, so only every other position can match the current one
+    hashkey_t current = positionHistory.back();
+    int occurrences = 0;
+    for (size_t i = positionHistory.size() - 1; ; i -= 2)
+    {
+        if (positionHistory[i] == current && ++occurrences >= 3)
+            return true;
+        if (i < lastIrreversibleIndex + 2)
+            return false;
+    }
+}
+
 
 
+void GameSession::setTimeControl(int initialMilliseconds, int incrementMilliseconds)
+{
+    std::lock_guard<std::mutex> lock(gameMutex);
+    for (GameClock &clock : clocks)
+    {
+        clock.remainingMilliseconds = initialMilliseconds;
+        clock.incrementMilliseconds = incrementMilliseconds;
+    }
+    timed = true;
+    turnStart = std::chrono::steady_clock::now();
+    TRACE_INFO("Game " << sessionId << " is played on time: " << initialMilliseconds << " ms + "
+               << incrementMilliseconds << " ms a move");
+}
+
+GameClock GameSession::getClock(bool isWhite)
+{
+    std::lock_guard<std::mutex> lock(gameMutex);
+    GameClock clock = clocks[isWhite ? 0 : 1];
+    if (timed && gameStarted && !gameOver && isWhite == isPlayer1Turn)
+        clock.remainingMilliseconds -= elapsedThisTurn();
+    return clock;
+}
+
+SearchLimits GameSession::getMoveLimits(bool isWhite, const TimeManager &timeManager, const SearchLimits &limits)
+{
+    if (!timed || gameBoard->getVariant() != ENGLISH_CHECKERS)
+        return limits;
+
+    GameClock clock = getClock(isWhite);
+    std::lock_guard<std::mutex> lock(gameMutex);
+    return timeManager.allocate(clock, getEnglishBoard(isWhite), limits);
+}
+
+void GameSession::setEngineOpponent(bool isWhite, int level)
+{
+    std::lock_guard<std::mutex> lock(gameMutex);
+    hasEngine = gameBoard->getVariant() == ENGLISH_CHECKERS;
+    engineIsWhite = isWhite;
+    engineLevel = level;
+    TRACE_INFO("Game " << sessionId << ": the computer plays " << (isWhite ? "white" : "black") << " at level " << level);
+}
+
+size_t GameSession::getEngineSearch(BasicBoard<EnglishRules> &position, std::vector<hashkey_t> &history)
+{
+    std::lock_guard<std::mutex> lock(gameMutex);
+    if (!hasEngine || !gameStarted || gameOver || engineIsWhite != isPlayer1Turn)
+        return 0;
+
+    position = getEnglishBoard(engineIsWhite);
+    // (only the positions since the last capture or man move can come up again)
+    history.assign(positionHistory.begin() + lastIrreversibleIndex, positionHistory.end());
+    return positionHistory.size();
+}
+
+bool GameSession::makeEngineMove(size_t positionCount, const CompactMove &move)
+{
+    coords_t from, to;
+    {
+        std::lock_guard<std::mutex> lock(gameMutex);
+        if (!hasEngine || gameOver || positionHistory.size() != positionCount)
+        {
+            TRACE_INFO("Game " << sessionId << " moved on during the computer's search; dropping its move");
+            return false;
+        }
+        from = gameBoard->getCoordsFromSquare(move.getFrom());
+        to = gameBoard->getCoordsFromSquare(move.getTo());
+    }
+
+    // played like any other player's move, so it is checked, timed and broadcast the same way, but
+    // with its captures, so it is the capture chain the search chose even if another joins the same squares
+    return makeMove(engineIsWhite ? player1Id : player2Id, from[0], from[1], to[0], to[1], move.getCaptureMask());
+}
+
+void GameSession::engineHasNoMoves()
+{
+    std::lock_guard<std::mutex> lock(gameMutex);
+    if (!hasEngine || gameOver)
+        return;
+    declareWinner(!engineIsWhite, "The computer has no moves left.");
+}
+
+bool GameSession::getAnalysisPosition(BasicBoard<EnglishRules> &position)
+{
+    std::lock_guard<std::mutex> lock(gameMutex);
+    if (gameBoard->getVariant() != ENGLISH_CHECKERS)
+        return false;
+    position = getEnglishBoard(isPlayer1Turn);
+    return true;
+}
+
+BasicBoard<EnglishRules> GameSession::getEnglishBoard(bool whiteToMove) const
+{
+    // English boards only use the low 32 bits
+    return BasicBoard<EnglishRules>((bitboard_t)gameBoard->getPieceMask(true), (bitboard_t)gameBoard->getPieceMask(false),
+                                    (bitboard_t)(gameBoard->getKingMask(true) | gameBoard->getKingMask(false)), whiteToMove);
+}
+
+// The milliseconds the side to move has been thinking for
+int GameSession::elapsedThisTurn() const
+{
+    auto elapsed = std::chrono::steady_clock::now() - turnStart;
+    return (int)std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+// Charges the side to move for its turn and starts the other side's; returns false if it had
+// run out of time
+bool GameSession::chargeClock(bool isWhite)
+{
+    GameClock &clock = clocks[isWhite ? 0 : 1];
+    clock.remainingMilliseconds -= elapsedThisTurn();
+    turnStart = std::chrono::steady_clock::now();
+    if (clock.remainingMilliseconds < 0)
+        return false;
+    clock.remainingMilliseconds += clock.incrementMilliseconds;
+    return true;
+}
+
 int GameSession::getCurrentTurn() {
     return isPlayer1Turn ? 0 : 1;
 }
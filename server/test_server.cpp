@@ -4,6 +4,9 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
 
 #include "GameLogic/Board.h"
 #include "GameLogic/Piece.h"
@@ -72,7 +75,7 @@ void debugBlackPiece()
               << std::endl;
 }
 
-int main()
+int main(int argc, char *argv[])
 {
     // Initialize socket library (Windows needs this)
     SocketWrapper::initialize();
@@ -81,8 +84,31 @@ int main()
     // Kill any previous instances of the server
    // killPreviousInstances();
 
+    // Usage: checkers_server [--egdb DIR] [--search-threads N] [--weights FILE]
+    // (endgame databases from checkers_egdbgen, to end games once their endgame is decided, how
+    // many threads the computer opponent's searches share, 2 by default, and the evaluation
+    // weights it plays with, from checkers_tune, eval.weights by default if there is one)
+    int searchThreads = 2;
+    std::string weightsPath;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::string(argv[i]) == "--search-threads")
+            searchThreads = std::max(1, atoi(argv[i + 1]));
+        if (std::string(argv[i]) == "--weights")
+            weightsPath = argv[i + 1];
+    }
+    EvalWeights weights;
+    if (!Evaluator::readWeights(weightsPath.empty() ? "eval.weights" : weightsPath, weights) && !weightsPath.empty())
+        std::cerr << "Could not read the weights file " << weightsPath << std::endl;
+
     // Create a server starting at port 8080 with 4 worker threads
-    Server server(8080, 4);
+    Server server(8080, 4, searchThreads, weights);
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::string(argv[i]) == "--egdb")
+            server.openEndgameDatabase(argv[i + 1]);
+    }
 
     std::cout << "Starting server..." << std::endl;
     if (!server.start())
@@ -104,6 +130,7 @@ int main()
     std::cout << "\nTest commands:" << std::endl;
     std::cout << "LOGIN username - Log in with a username" << std::endl;
     std::cout << "CREATE - Create a new game" << std::endl;
+    std::cout << "CREATE_AI [level] [white|black] - Play the computer" << std::endl;
     std::cout << "JOIN gameId - Join an existing game" << std::endl;
     std::cout << "MOVE fromX fromY toX toY - Make a move" << std::endl;
     std::cout << "STATE - Get the current game state" << std::endl;
@@ -0,0 +1,352 @@
+// server/tools/bookbuild.cpp
+//
+// Builds an opening book (see GameLogic/OpeningBook.h) from played games: every position the
+// games went through in their first moves, every move played in it and how those games ended.
+//
+// Usage: checkers_bookbuild [options] GAMES...
+//   --output FILE     the book to write (default opening.book)
+//   --plies N         how many moves into each game to take positions from (default 24)
+//   --min-games N     leave out moves played in fewer than N games (default 2)
+//   --threads N       the threads to work with (default: one per core)
+//
+// Each games file has one game per line: the result ("1-0" if white won, "0-1" if black won,
+// "1/2-1/2" for a draw), then the moves, each the squares it goes from and to the way the game
+// names them, e.g. "C3-D4", or "B2xD4" for a jump. A jump of several captures can be written
+// with only its first and last squares ("B2xF6") or with every square it lands on ("B2xD4xF6"),
+// which a king's jumps need when two of them start and end on the same squares. Move numbers
+// ("12.") are skipped, as are blank lines, lines starting with '#' and games with any other
+// result. A game is read up to its first illegal (or ambiguous) move.
+//
+// The files are memory-mapped and cut into pieces the threads take one at a time. Each thread
+// tallies the moves it sees in a table of its own, which it sorts and merges every so often,
+// and the threads' tables are merged at the end. A move's weight is the points it scored (two
+// for a win, one for a draw), scaled down if need be to fit 16 bits, so the book never plays
+// a move that only ever lost.
+
+#include "../GameLogic/BasicBoard.h"
+#include "../GameLogic/MappedFile.h"
+#include "../GameLogic/MoveList.h"
+#include "../GameLogic/OpeningBook.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// the bytes of a games file a thread takes at a time
+static const std::size_t PIECE_SIZE = 1 << 20;
+
+// the tallies a thread gathers before it first sorts and merges them
+static const std::size_t FIRST_REDUCE = 1 << 20;
+
+// A piece of a games file: the games whose lines start in [begin, end).
+struct FilePiece
+{
+    const MappedFile *file;
+    std::size_t begin;
+    std::size_t end;
+};
+
+// What the threads found, added up.
+struct BuildCounts
+{
+    std::atomic<std::uint64_t> games{0};
+    std::atomic<std::uint64_t> skipped{0};
+    std::atomic<std::uint64_t> illegal{0};
+};
+
+// Sorts tallies and merges the ones for the same move of the same position.
+static void reduceTallies(std::vector<BookEntry> &tallies)
+{
+    std::sort(tallies.begin(), tallies.end());
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < tallies.size(); i++)
+    {
+        if (kept > 0 && !(tallies[kept - 1] < tallies[i]))
+        {
+            BookEntry &last = tallies[kept - 1];
+            last.wins += tallies[i].wins;
+            last.draws += tallies[i].draws;
+            last.losses += tallies[i].losses;
+        }
+        else
+            tallies[kept++] = tallies[i];
+    }
+    tallies.resize(kept);
+}
+
+// Reads a square name ("C3"), returning its square, or -1 if it isn't a playable square.
+static int parseSquare(const char *&text, const char *end)
+{
+    if (end - text < 2)
+        return -1;
+    int x = (text[0] >= 'a' ? text[0] - 'a' : text[0] - 'A');
+    int y = text[1] - '1';
+    text += 2;
+    return BasicBoard<EnglishRules>::getSquareFromCoords(x, y);
+}
+
+// Replays one game, adding a tally for each of its first moves.
+static void readGame(const char *text, const char *end, int plies, std::vector<BookEntry> &tallies, BuildCounts &counts)
+{
+    // split the line into words
+    std::vector<std::pair<const char *, const char *>> words;
+    while (text < end)
+    {
+        while (text < end && (*text == ' ' || *text == '\t' || *text == '\r'))
+            text++;
+        const char *start = text;
+        while (text < end && *text != ' ' && *text != '\t' && *text != '\r')
+            text++;
+        if (text > start)
+            words.emplace_back(start, text);
+    }
+    if (words.empty() || *words[0].first == '#')
+        return;
+
+    // the points white scored, out of two
+    std::string result(words[0].first, words[0].second);
+    int whitePoints = result == "1-0" ? 2 : result == "0-1" ? 0 : result == "1/2-1/2" ? 1 : -1;
+    if (whitePoints < 0)
+    {
+        counts.skipped++;
+        return;
+    }
+    counts.games++;
+
+    BasicBoard<EnglishRules> board;
+    int ply = 0;
+    for (std::size_t i = 1; i < words.size() && ply < plies; i++)
+    {
+        const char *word = words[i].first;
+        const char *wordEnd = words[i].second;
+        if (wordEnd[-1] == '.')
+            continue;
+
+        // the squares the move goes through, e.g. "B2xD4xF6"
+        int squares[CompactMove::MAX_JUMPS + 1];
+        int squareCount = 0;
+        bool readable = true;
+        while (readable && squareCount <= CompactMove::MAX_JUMPS)
+        {
+            squares[squareCount] = parseSquare(word, wordEnd);
+            readable = squares[squareCount++] >= 0;
+            if (word == wordEnd || (*word != '-' && *word != 'x' && *word != 'X'))
+                break;
+            word++;
+        }
+        readable = readable && word == wordEnd && squareCount >= 2;
+
+        // the one legal move that goes through those squares
+        MoveList moves;
+        board.getAllLegalMoves(board.isWhiteToMove(), moves);
+        int found = -1, matches = 0;
+        for (int j = 0; j < moves.size() && readable; j++)
+        {
+            int landings[CompactMove::MAX_JUMPS];
+            int landingCount = moves[j].getLandingSquares(landings);
+            bool same = moves[j].getFrom() == squares[0] && moves[j].getTo() == squares[squareCount - 1] &&
+                        (squareCount == 2 || std::equal(squares + 1, squares + squareCount, landings, landings + landingCount));
+            if (same)
+            {
+                found = j;
+                matches++;
+            }
+        }
+        if (matches != 1)
+        {
+            counts.illegal++;
+            return;
+        }
+
+        int from = squares[0];
+        int to = squares[squareCount - 1];
+        int points = board.isWhiteToMove() ? whitePoints : 2 - whitePoints;
+        BookEntry tally = {board.getHash(), (std::uint8_t)from, (std::uint8_t)to, 0,
+                           (std::uint32_t)(points == 2), (std::uint32_t)(points == 1), (std::uint32_t)(points == 0)};
+        tallies.push_back(tally);
+        board.makeMove(moves[found]);
+        ply++;
+    }
+}
+
+// Reads the games of the pieces the thread takes, returning its tallies (sorted and merged).
+static std::vector<BookEntry> readPieces(const std::vector<FilePiece> &pieces, std::atomic<std::size_t> &nextPiece,
+                                         int plies, BuildCounts &counts)
+{
+    std::vector<BookEntry> tallies;
+    std::size_t reduceAt = FIRST_REDUCE;
+    for (std::size_t p = nextPiece++; p < pieces.size(); p = nextPiece++)
+    {
+        const FilePiece &piece = pieces[p];
+        const char *data = (const char *)piece.file->getData();
+        const char *fileEnd = data + piece.file->getSize();
+
+        // a line that starts in the piece before is that piece's
+        const char *line = data + piece.begin;
+        if (piece.begin > 0 && line[-1] != '\n')
+        {
+            while (line < fileEnd && *line != '\n')
+                line++;
+            line = std::min(line + 1, fileEnd);
+        }
+        while (line < data + piece.end)
+        {
+            const char *lineEnd = line;
+            while (lineEnd < fileEnd && *lineEnd != '\n')
+                lineEnd++;
+            readGame(line, lineEnd, plies, tallies, counts);
+            line = std::min(lineEnd + 1, fileEnd);
+        }
+
+        // merging every so often keeps the table to about the size of the moves seen
+        if (tallies.size() >= reduceAt)
+        {
+            reduceTallies(tallies);
+            reduceAt = std::max(FIRST_REDUCE, tallies.size() * 2);
+        }
+    }
+    reduceTallies(tallies);
+    return tallies;
+}
+
+// Merges the threads' sorted tables into one, keeping the moves played often enough, and weighs them.
+static std::vector<BookEntry> mergeTallies(std::vector<std::vector<BookEntry>> &tables, std::uint64_t minGames)
+{
+    std::vector<BookEntry> book;
+    std::vector<std::size_t> next(tables.size(), 0);
+    while (true)
+    {
+        int first = -1;
+        for (std::size_t t = 0; t < tables.size(); t++)
+        {
+            if (next[t] < tables[t].size() && (first < 0 || tables[t][next[t]] < tables[first][next[first]]))
+                first = (int)t;
+        }
+        if (first < 0)
+            break;
+
+        BookEntry entry = tables[first][next[first]++];
+        for (std::size_t t = 0; t < tables.size(); t++)
+        {
+            if (next[t] < tables[t].size() && !(entry < tables[t][next[t]]))
+            {
+                const BookEntry &same = tables[t][next[t]++];
+                entry.wins += same.wins;
+                entry.draws += same.draws;
+                entry.losses += same.losses;
+            }
+        }
+        if (entry.getGames() >= minGames)
+            book.push_back(entry);
+    }
+
+    // weigh each position's moves by their points, scaled together if the best doesn't fit 16 bits
+    for (std::size_t first = 0, last; first < book.size(); first = last)
+    {
+        std::uint64_t mostPoints = 0;
+        for (last = first; last < book.size() && book[last].key == book[first].key; last++)
+            mostPoints = std::max(mostPoints, 2 * (std::uint64_t)book[last].wins + book[last].draws);
+        for (std::size_t i = first; i < last; i++)
+        {
+            std::uint64_t points = 2 * (std::uint64_t)book[i].wins + book[i].draws;
+            if (mostPoints > 0xffff)
+                points = points == 0 ? 0 : std::max<std::uint64_t>(1, points * 0xffff / mostPoints);
+            book[i].weight = (std::uint16_t)points;
+        }
+    }
+    return book;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: checkers_bookbuild [--output FILE] [--plies N] [--min-games N] [--threads N] GAMES..." << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string output = "opening.book";
+    int plies = 24;
+    std::uint64_t minGames = 2;
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--output" && i + 1 < argc)
+            output = argv[++i];
+        else if (arg == "--plies" && i + 1 < argc)
+            plies = std::max(1, atoi(argv[++i]));
+        else if (arg == "--min-games" && i + 1 < argc)
+            minGames = (std::uint64_t)std::max(1, atoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc)
+            threads = std::max(1, atoi(argv[++i]));
+        else if (!arg.empty() && arg[0] != '-')
+            inputs.push_back(arg);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+    if (inputs.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<MappedFile>> files;
+    std::vector<FilePiece> pieces;
+    for (const std::string &input : inputs)
+    {
+        files.emplace_back(new MappedFile());
+        if (!files.back()->open(input))
+        {
+            std::cerr << "Could not read " << input << std::endl;
+            return 1;
+        }
+        for (std::size_t begin = 0; begin < files.back()->getSize(); begin += PIECE_SIZE)
+            pieces.push_back(FilePiece{files.back().get(), begin, std::min(begin + PIECE_SIZE, files.back()->getSize())});
+    }
+
+    std::cout << "Reading " << inputs.size() << " file(s) with " << threads << " threads, " << plies
+              << " moves into each game" << std::endl;
+    BuildCounts counts;
+    std::atomic<std::size_t> nextPiece(0);
+    std::vector<std::vector<BookEntry>> tables(threads);
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++)
+        workers.emplace_back([&, t] { tables[t] = readPieces(pieces, nextPiece, plies, counts); });
+    tables[0] = readPieces(pieces, nextPiece, plies, counts);
+    for (std::thread &worker : workers)
+        worker.join();
+
+    std::vector<BookEntry> book = mergeTallies(tables, minGames);
+    std::uint64_t positions = 0;
+    for (std::size_t i = 0; i < book.size(); i++)
+        positions += i == 0 || book[i].key != book[i - 1].key;
+
+    // written under a temporary name until it is complete, so a book file is never half written
+    std::string temporaryPath = output + ".part";
+    if (!OpeningBook::write(temporaryPath, book) || std::rename(temporaryPath.c_str(), output.c_str()) != 0)
+    {
+        std::cerr << "Could not write " << output << std::endl;
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << counts.games << " games (" << counts.skipped << " without a result skipped, " << counts.illegal
+              << " cut short by an illegal move) in " << seconds << " s, " << (std::uint64_t)(counts.games / std::max(seconds, 1e-9))
+              << " games/s" << std::endl;
+    std::cout << "Wrote " << output << ": " << book.size() << " moves in " << positions << " positions, "
+              << book.size() * OpeningBook::ENTRY_SIZE / 1024 << " KB" << std::endl;
+    return 0;
+}
@@ -0,0 +1,690 @@
+// server/tools/egdbgen.cpp
+//
+// Generates endgame databases: the result (win, loss or draw) and, for wins and losses, the
+// number of moves to the end of the game with best play, for every position with up to a
+// given number of pieces, by retrograde analysis.
+//
+// Usage: checkers_egdbgen [options]
+//   --pieces N        every position with up to N pieces (default 6, at most 8)
+//   --output DIR      the directory to write the slices to (default egdb)
+//   --threads N       the threads to work with (default: one per core)
+//   --verify          check every slice against its successors once it is done (slow)
+//
+// Positions are numbered by GameLogic/EndgameIndex.h, one file per slice (how many men and kings
+// each side has), holding a 16-bit EndgameValue for every position of the slice with white to
+// move, compressed in blocks that GameLogic/EndgameDatabase.h looks positions up in. A slice only depends on slices with fewer pieces (reached by capturing) or fewer men
+// (reached by crowning), so the slices are solved in that order, and a slice and the one with
+// its colors swapped are solved together, since moves without a capture or crowning go back
+// and forth between them. Each pair is written out as soon as it is solved, and a slice is
+// dropped from memory once nothing left to solve can reach it. Slices already in the directory
+// are loaded instead of solved again, so an interrupted run picks up where it left off.
+//
+// The moves are BasicBoard<EnglishRules>'s, which are exactly the moves Board (and Piece) allow
+// and the server enforces: captures are mandatory, every jump in a chain is a move of its own,
+// and a side with no move left has lost.
+
+#include "../GameLogic/BasicBoard.h"
+#include "../GameLogic/EndgameDatabase.h"
+#include "../GameLogic/EndgameIndex.h"
+#include "../GameLogic/MoveList.h"
+#include "../GameLogic/SquareTables.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+#if defined(_WIN32)
+#include <direct.h>
+#endif
+
+typedef BasicBoard<EnglishRules> EndgameBoard;
+
+// the positions a thread takes at a time from the range being worked on
+static const std::uint64_t CHUNK_SIZE = 4096;
+
+// Threads that work through a range of positions together. The threads are started once and
+// wait between ranges; the calling thread works on each range too.
+class WorkerPool
+{
+public:
+    explicit WorkerPool(int threads) : generation(0), busy(0), shuttingDown(false), count(0)
+    {
+        for (int i = 1; i < threads; i++)
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            shuttingDown = true;
+        }
+        wake.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+    // Calls work(first, last) on pieces of [0, total) from every thread, returning once all are done.
+    void forEach(std::uint64_t total, const std::function<void(std::uint64_t, std::uint64_t)> &work)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = work;
+            count = total;
+            next = 0;
+            busy = (int)workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        runChunks();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return busy == 0; });
+    }
+
+    int getThreadCount() const { return (int)workers.size() + 1; }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::uint64_t generation;
+    int busy;
+    bool shuttingDown;
+
+    std::function<void(std::uint64_t, std::uint64_t)> job;
+    std::uint64_t count;
+    std::atomic<std::uint64_t> next;
+
+    void runChunks()
+    {
+        while (true)
+        {
+            std::uint64_t first = next.fetch_add(CHUNK_SIZE);
+            if (first >= count)
+                return;
+            job(first, std::min(count, first + CHUNK_SIZE));
+        }
+    }
+
+    void workerLoop()
+    {
+        std::uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            wake.wait(lock, [this, seen] { return shuttingDown || generation != seen; });
+            if (shuttingDown)
+                return;
+            seen = generation;
+
+            lock.unlock();
+            runChunks();
+            lock.lock();
+            if (--busy == 0)
+                finished.notify_all();
+        }
+    }
+};
+
+// A solved slice, kept while slices still to be solved can reach it.
+struct SolvedSlice
+{
+    EndgameIndex index;
+    std::vector<std::uint16_t> values;
+
+    explicit SolvedSlice(const EndgameSlice &slice) : index(slice) {}
+};
+
+// every slice solved (or loaded) so far and still needed, by getSliceCode
+static std::vector<std::unique_ptr<SolvedSlice>> solvedSlices;
+
+// a number for each slice, for finding it without searching
+static int getSliceCode(const EndgameSlice &slice)
+{
+    const int base = EndgameIndex::MAX_PIECES + 1;
+    return ((slice.whiteMen * base + slice.whiteKings) * base + slice.blackMen) * base + slice.blackKings;
+}
+
+// Looks up a position with white to move in the solved slices.
+static std::uint16_t lookUp(bitboard_t white, bitboard_t black, bitboard_t kings)
+{
+    // a side with no pieces has no moves
+    if (white == 0)
+        return EndgameValue::pack(ENDGAME_LOSS, 0);
+
+    EndgameSlice slice = EndgameSlice::fromPosition(white, black, kings);
+    const SolvedSlice *solved = solvedSlices[getSliceCode(slice)].get();
+    if (solved == nullptr)
+    {
+        // the order slices are solved in should make this impossible
+        std::cerr << "Slice " << slice.getName() << " is needed before it has been solved" << std::endl;
+        std::abort();
+    }
+    return solved->values[solved->index.getIndex(white, black, kings)];
+}
+
+// The position reached by a move, turned around so it has white to move again (see EndgameIndex::rotate).
+struct Successor
+{
+    bitboard_t white;
+    bitboard_t black;
+    bitboard_t kings;
+};
+
+static Successor getSuccessor(const EndgameBoard &board, const CompactMove &move)
+{
+    EndgameBoard next = board;
+    next.makeMove(move);
+    return Successor{EndgameIndex::rotate(next.getPieceMask(false)), EndgameIndex::rotate(next.getPieceMask(true)),
+                     EndgameIndex::rotate(next.getKingMask(true) | next.getKingMask(false))};
+}
+
+// A slice being solved: its values so far, and what the retrograde analysis keeps for each position.
+struct WorkingSlice
+{
+    // a capture or crowning reaches a draw, so the position can't be lost
+    static const std::uint8_t HAS_DRAW = 1;
+    // every move within the pair has been found to lose
+    static const std::uint8_t ALL_LOST = 2;
+
+    EndgameIndex index;
+    std::unique_ptr<std::atomic<std::uint16_t>[]> values;
+    // the moves within the pair whose result isn't known yet
+    std::unique_ptr<std::atomic<std::uint8_t>[]> remaining;
+    std::unique_ptr<std::atomic<std::uint8_t>[]> flags;
+    // the quickest win and the slowest loss by a capture or crowning (0 for none)
+    std::unique_ptr<std::uint16_t[]> conversionWin;
+    std::unique_ptr<std::uint16_t[]> conversionLoss;
+
+    // the slice with the colors swapped (this one, if they are the same)
+    WorkingSlice *partner;
+
+    explicit WorkingSlice(const EndgameSlice &slice)
+        : index(slice), values(new std::atomic<std::uint16_t>[index.getSize()]),
+          remaining(new std::atomic<std::uint8_t>[index.getSize()]), flags(new std::atomic<std::uint8_t>[index.getSize()]),
+          conversionWin(new std::uint16_t[index.getSize()]), conversionLoss(new std::uint16_t[index.getSize()]),
+          partner(nullptr)
+    {
+    }
+
+    EndgameBoard getBoard(std::uint64_t position) const
+    {
+        bitboard_t white, black, kings;
+        index.getPosition(position, white, black, kings);
+        return EndgameBoard(white, black, kings, true);
+    }
+
+    // sets a position's value, unless another thread already has
+    bool resolve(std::uint64_t position, std::uint16_t value)
+    {
+        std::uint16_t unknown = 0;
+        return values[position].compare_exchange_strong(unknown, value, std::memory_order_relaxed);
+    }
+};
+
+// Works out what the moves of a position lead to: counts the moves within the pair, and looks up
+// where the captures and crownings lead. Returns the highest distance it saw.
+static int initializePosition(WorkingSlice &slice, std::uint64_t position)
+{
+    EndgameBoard board = slice.getBoard(position);
+    MoveList moves;
+    board.getAllLegalMoves(true, moves);
+
+    slice.remaining[position].store(0, std::memory_order_relaxed);
+    slice.flags[position].store(0, std::memory_order_relaxed);
+    slice.conversionWin[position] = 0;
+    slice.conversionLoss[position] = 0;
+    if (moves.empty())
+    {
+        slice.values[position].store(EndgameValue::pack(ENDGAME_LOSS, 0), std::memory_order_relaxed);
+        return 0;
+    }
+    slice.values[position].store(0, std::memory_order_relaxed);
+
+    int remaining = 0;
+    int win = 0;
+    int loss = 0;
+    bool draw = false;
+    for (const CompactMove &move : moves)
+    {
+        Successor next = getSuccessor(board, move);
+        if (EndgameSlice::fromPosition(next.white, next.black, next.kings) == slice.partner->index.getSlice())
+        {
+            remaining++;
+            continue;
+        }
+
+        // a capture or a crowning, into a slice that is already solved
+        std::uint16_t value = lookUp(next.white, next.black, next.kings);
+        int distance = EndgameValue::getDistance(value) + 1;
+        switch (EndgameValue::getResult(value))
+        {
+            case ENDGAME_LOSS:
+                win = win == 0 ? distance : std::min(win, distance);
+                break;
+            case ENDGAME_WIN:
+                loss = std::max(loss, distance);
+                break;
+            default:
+                draw = true;
+                break;
+        }
+    }
+
+    slice.remaining[position].store((std::uint8_t)remaining, std::memory_order_relaxed);
+    slice.conversionWin[position] = (std::uint16_t)win;
+    slice.conversionLoss[position] = (std::uint16_t)loss;
+    std::uint8_t flags = draw ? WorkingSlice::HAS_DRAW : 0;
+    if (remaining == 0)
+        flags |= WorkingSlice::ALL_LOST;
+    slice.flags[position].store(flags, std::memory_order_relaxed);
+    return std::max(win, loss);
+}
+
+// Calls visit(index) with the number, in the partner slice, of every position that can reach
+// the given one (with white to move) by a move within the pair: one black piece stepping back,
+// from a position where black had no capture (so the step was allowed).
+template <class Visit>
+static void forEachPredecessor(const WorkingSlice &slice, std::uint64_t position, Visit visit)
+{
+    bitboard_t white, black, kings;
+    slice.index.getPosition(position, white, black, kings);
+    bitboard_t empty = ~(white | black);
+
+    bitboard_t pieces = black;
+    while (pieces)
+    {
+        int square = popLowestSquare(pieces);
+        bitboard_t squareBit = (bitboard_t)1 << square;
+        bool isKing = (kings & squareBit) != 0;
+
+        // black men move toward -y, so they came from +y (directions 2 and 3); kings from anywhere
+        for (int direction = isKing ? 0 : 2; direction < 4; direction++)
+        {
+            bitboard_t fromBit = getStepMask(square, direction);
+            if (!(fromBit & empty))
+                continue;
+
+            bitboard_t previousBlack = (black & ~squareBit) | fromBit;
+            bitboard_t previousKings = isKing ? (kings & ~squareBit) | fromBit : kings;
+            if (EndgameBoard(white, previousBlack, previousKings, false).hasAnyCapture(false))
+                continue;
+
+            visit(slice.partner->index.getIndex(EndgameIndex::rotate(previousBlack), EndgameIndex::rotate(white),
+                                                EndgameIndex::rotate(previousKings)));
+        }
+    }
+}
+
+// Passes on a position's result, found at the last level, to the positions that can reach it.
+static void propagate(WorkingSlice &slice, std::uint64_t position, EndgameResult result, int level)
+{
+    WorkingSlice &partner = *slice.partner;
+    forEachPredecessor(slice, position, [&](std::uint64_t previous)
+    {
+        if (partner.values[previous].load(std::memory_order_relaxed) != 0)
+            return;
+
+        // moving here makes the other side lose, so the position before wins
+        if (result == ENDGAME_LOSS)
+        {
+            partner.resolve(previous, EndgameValue::pack(ENDGAME_WIN, level));
+            return;
+        }
+
+        // one more of its moves loses; once they all do (and no capture or crowning saves it), it loses
+        if (partner.remaining[previous].fetch_sub(1, std::memory_order_relaxed) != 1)
+            return;
+        std::uint8_t flags = partner.flags[previous].load(std::memory_order_relaxed);
+        if (partner.conversionWin[previous] != 0 || (flags & WorkingSlice::HAS_DRAW))
+            return;
+        if (partner.conversionLoss[previous] <= level)
+            partner.resolve(previous, EndgameValue::pack(ENDGAME_LOSS, level));
+        else
+            partner.flags[previous].fetch_or(WorkingSlice::ALL_LOST, std::memory_order_relaxed);
+    });
+}
+
+// Solves a slice and the one with its colors swapped (which may be the same slice).
+static std::vector<std::unique_ptr<WorkingSlice>> solvePair(const EndgameSlice &slice, WorkerPool &pool)
+{
+    std::vector<std::unique_ptr<WorkingSlice>> pair;
+    pair.emplace_back(new WorkingSlice(slice));
+    if (slice.getSwapped() != slice)
+    {
+        pair.emplace_back(new WorkingSlice(slice.getSwapped()));
+        pair[0]->partner = pair[1].get();
+        pair[1]->partner = pair[0].get();
+    }
+    else
+        pair[0]->partner = pair[0].get();
+
+    // what every position's moves lead to, and the positions with none (lost at distance 0)
+    std::atomic<int> lastPending(0);
+    for (std::unique_ptr<WorkingSlice> &working : pair)
+    {
+        WorkingSlice &current = *working;
+        pool.forEach(current.index.getSize(), [&](std::uint64_t first, std::uint64_t last)
+        {
+            int highest = 0;
+            for (std::uint64_t position = first; position < last; position++)
+                highest = std::max(highest, initializePosition(current, position));
+            int seen = lastPending.load();
+            while (highest > seen && !lastPending.compare_exchange_weak(seen, highest))
+                ;
+        });
+    }
+
+    // then one distance at a time: the results found at the last level decide the positions that
+    // can reach them, and positions whose best capture or crowning lasts this long are decided
+    for (int level = 1; level <= EndgameValue::MAX_DISTANCE; level++)
+    {
+        std::atomic<bool> progress(false);
+        for (std::unique_ptr<WorkingSlice> &working : pair)
+        {
+            WorkingSlice &current = *working;
+            pool.forEach(current.index.getSize(), [&](std::uint64_t first, std::uint64_t last)
+            {
+                bool found = false;
+                for (std::uint64_t position = first; position < last; position++)
+                {
+                    std::uint16_t value = current.values[position].load(std::memory_order_relaxed);
+                    if (value != 0)
+                    {
+                        if (EndgameValue::getDistance(value) == level - 1 && EndgameValue::getResult(value) != ENDGAME_DRAW)
+                        {
+                            propagate(current, position, EndgameValue::getResult(value), level);
+                            found = true;
+                        }
+                        continue;
+                    }
+
+                    if (current.conversionWin[position] == level)
+                        found |= current.resolve(position, EndgameValue::pack(ENDGAME_WIN, level));
+                    else if (current.conversionLoss[position] == level && current.conversionWin[position] == 0 &&
+                             (current.flags[position].load(std::memory_order_relaxed) & WorkingSlice::ALL_LOST) &&
+                             !(current.flags[position].load(std::memory_order_relaxed) & WorkingSlice::HAS_DRAW))
+                        found |= current.resolve(position, EndgameValue::pack(ENDGAME_LOSS, level));
+                }
+                if (found)
+                    progress = true;
+            });
+        }
+        if (!progress && level > lastPending)
+            break;
+    }
+
+    // whatever neither side can force is a draw
+    for (std::unique_ptr<WorkingSlice> &working : pair)
+    {
+        WorkingSlice &current = *working;
+        pool.forEach(current.index.getSize(), [&](std::uint64_t first, std::uint64_t last)
+        {
+            for (std::uint64_t position = first; position < last; position++)
+                if (current.values[position].load(std::memory_order_relaxed) == 0)
+                    current.values[position].store(EndgameValue::pack(ENDGAME_DRAW, 0), std::memory_order_relaxed);
+        });
+    }
+    return pair;
+}
+
+// Checks every position of a solved slice agrees with the results of its moves.
+static std::uint64_t verifySlice(const SolvedSlice &solved, WorkerPool &pool)
+{
+    std::atomic<std::uint64_t> errors(0);
+    pool.forEach(solved.index.getSize(), [&](std::uint64_t first, std::uint64_t last)
+    {
+        for (std::uint64_t position = first; position < last; position++)
+        {
+            bitboard_t white, black, kings;
+            solved.index.getPosition(position, white, black, kings);
+            EndgameBoard board(white, black, kings, true);
+            MoveList moves;
+            board.getAllLegalMoves(true, moves);
+
+            // the best result among the moves: the quickest win, or a draw, or the slowest loss
+            std::uint16_t expected = EndgameValue::pack(ENDGAME_LOSS, 0);
+            for (const CompactMove &move : moves)
+            {
+                Successor next = getSuccessor(board, move);
+                std::uint16_t value = lookUp(next.white, next.black, next.kings);
+                int distance = EndgameValue::getDistance(value) + 1;
+                EndgameResult result = EndgameValue::getResult(value);
+                EndgameResult best = EndgameValue::getResult(expected);
+                if (result == ENDGAME_LOSS)
+                {
+                    if (best != ENDGAME_WIN || distance < EndgameValue::getDistance(expected))
+                        expected = EndgameValue::pack(ENDGAME_WIN, distance);
+                }
+                else if (result == ENDGAME_DRAW)
+                {
+                    if (best == ENDGAME_LOSS)
+                        expected = EndgameValue::pack(ENDGAME_DRAW, 0);
+                }
+                else if (best == ENDGAME_LOSS && distance > EndgameValue::getDistance(expected))
+                    expected = EndgameValue::pack(ENDGAME_LOSS, distance);
+            }
+            if (solved.values[position] != expected)
+                errors++;
+        }
+    });
+    return errors;
+}
+
+static std::string getSlicePath(const std::string &directory, const EndgameSlice &slice)
+{
+    return directory + "/" + EndgameDatabase::getFileName(slice);
+}
+
+// Loads a slice written by an earlier run, returning false if it isn't there (or is damaged).
+static bool loadSlice(const std::string &directory, SolvedSlice &solved)
+{
+    return EndgameDatabase::readSlice(getSlicePath(directory, solved.index.getSlice()), solved.index.getSlice(), solved.values);
+}
+
+// Writes a slice out, under a temporary name until it is complete, so a slice file is never half written.
+static bool writeSlice(const std::string &directory, const SolvedSlice &solved)
+{
+    const EndgameSlice &slice = solved.index.getSlice();
+    std::string path = getSlicePath(directory, slice);
+    std::string temporaryPath = path + ".part";
+    if (!EndgameDatabase::writeSlice(temporaryPath, slice, solved.values))
+        return false;
+    return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+}
+
+static void printSummary(const SolvedSlice &solved, double seconds, const char *how)
+{
+    std::uint64_t wins = 0, losses = 0, draws = 0;
+    int longest = 0;
+    for (std::uint16_t value : solved.values)
+    {
+        EndgameResult result = EndgameValue::getResult(value);
+        wins += result == ENDGAME_WIN;
+        losses += result == ENDGAME_LOSS;
+        draws += result == ENDGAME_DRAW;
+        if (result != ENDGAME_DRAW)
+            longest = std::max(longest, EndgameValue::getDistance(value));
+    }
+    std::cout << solved.index.getSlice().getName() << ": " << solved.values.size() << " positions, " << wins << " won, "
+              << losses << " lost, " << draws << " drawn, longest " << longest << " plies (" << how << " in " << seconds
+              << " s)" << std::endl;
+}
+
+// Returns whether a move (or several) from a slice, or the slice with its colors swapped, can
+// reach another: pieces are only ever removed, and men only ever become kings.
+static bool canReach(const EndgameSlice &from, const EndgameSlice &to)
+{
+    for (const EndgameSlice &start : {from, from.getSwapped()})
+    {
+        for (const EndgameSlice &end : {to, to.getSwapped()})
+        {
+            if (end.whiteMen <= start.whiteMen && end.blackMen <= start.blackMen &&
+                end.whiteMen + end.whiteKings <= start.whiteMen + start.whiteKings &&
+                end.blackMen + end.blackKings <= start.blackMen + start.blackKings)
+                return true;
+        }
+    }
+    return false;
+}
+
+// Lists one slice of every pair with up to the given number of pieces, in an order where every
+// slice comes after all the slices it can reach: fewer pieces first (captures remove pieces),
+// and then fewer men (crowning turns a man into a king).
+static std::vector<EndgameSlice> getSolvingOrder(int maxPieces)
+{
+    std::vector<EndgameSlice> order;
+    for (int pieces = 2; pieces <= maxPieces; pieces++)
+    {
+        for (int men = 0; men <= pieces; men++)
+        {
+            for (int whitePieces = 1; whitePieces < pieces; whitePieces++)
+            {
+                for (int whiteMen = 0; whiteMen <= std::min(whitePieces, men); whiteMen++)
+                {
+                    int blackMen = men - whiteMen;
+                    int blackPieces = pieces - whitePieces;
+                    if (blackMen > blackPieces)
+                        continue;
+                    EndgameSlice slice{whiteMen, whitePieces - whiteMen, blackMen, blackPieces - blackMen};
+                    if (std::find(order.begin(), order.end(), slice.getSwapped()) == order.end())
+                        order.push_back(slice);
+                }
+            }
+        }
+    }
+    return order;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: checkers_egdbgen [--pieces N] [--output DIR] [--threads N] [--verify]" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    int maxPieces = 6;
+    std::string directory = "egdb";
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    bool verify = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--pieces" && i + 1 < argc)
+            maxPieces = std::max(2, std::min((int)EndgameIndex::MAX_PIECES, atoi(argv[++i])));
+        else if (arg == "--output" && i + 1 < argc)
+            directory = argv[++i];
+        else if (arg == "--threads" && i + 1 < argc)
+            threads = std::max(1, atoi(argv[++i]));
+        else if (arg == "--verify")
+            verify = true;
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+#if defined(_WIN32)
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0755);
+#endif
+    WorkerPool pool(threads);
+    const int base = EndgameIndex::MAX_PIECES + 1;
+    solvedSlices.resize(base * base * base * base);
+    std::cout << "Generating every position with up to " << maxPieces << " pieces into " << directory << "/ with "
+              << pool.getThreadCount() << " threads" << std::endl;
+
+    std::vector<EndgameSlice> order = getSolvingOrder(maxPieces);
+    auto startTime = std::chrono::steady_clock::now();
+    std::uint64_t totalErrors = 0;
+    for (size_t next = 0; next < order.size(); next++)
+    {
+        const EndgameSlice &slice = order[next];
+        auto sliceStart = std::chrono::steady_clock::now();
+        std::vector<EndgameSlice> slices = {slice};
+        if (slice.getSwapped() != slice)
+            slices.push_back(slice.getSwapped());
+
+        // load the pair if an earlier run finished it, or else solve it and write it out
+        std::vector<std::unique_ptr<SolvedSlice>> done;
+        for (const EndgameSlice &part : slices)
+        {
+            done.emplace_back(new SolvedSlice(part));
+            if (!loadSlice(directory, *done.back()))
+            {
+                done.clear();
+                break;
+            }
+        }
+        const char *how = "loaded";
+        if (done.empty())
+        {
+            how = "solved";
+            for (std::unique_ptr<WorkingSlice> &working : solvePair(slice, pool))
+            {
+                done.emplace_back(new SolvedSlice(working->index.getSlice()));
+                done.back()->values.resize(working->index.getSize());
+                for (std::uint64_t i = 0; i < working->index.getSize(); i++)
+                    done.back()->values[i] = working->values[i].load(std::memory_order_relaxed);
+            }
+            for (std::unique_ptr<SolvedSlice> &solved : done)
+            {
+                if (!writeSlice(directory, *solved))
+                {
+                    std::cerr << "Could not write " << getSlicePath(directory, solved->index.getSlice()) << std::endl;
+                    return 1;
+                }
+            }
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - sliceStart).count();
+        for (std::unique_ptr<SolvedSlice> &solved : done)
+        {
+            printSummary(*solved, seconds, how);
+            solvedSlices[getSliceCode(solved->index.getSlice())] = std::move(solved);
+        }
+        if (verify)
+        {
+            for (const EndgameSlice &part : slices)
+            {
+                std::uint64_t errors = verifySlice(*solvedSlices[getSliceCode(part)], pool);
+                if (errors > 0)
+                    std::cout << "  MISMATCH: " << errors << " positions of " << part.getName() << " disagree with their moves" << std::endl;
+                totalErrors += errors;
+            }
+        }
+
+        // only keep the slices something still to be solved can reach
+        for (std::unique_ptr<SolvedSlice> &solved : solvedSlices)
+        {
+            if (!solved)
+                continue;
+            bool needed = false;
+            for (size_t later = next + 1; later < order.size() && !needed; later++)
+                needed = canReach(order[later], solved->index.getSlice());
+            if (!needed)
+                solved.reset();
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "Done in " << seconds << " s" << std::endl;
+    if (verify)
+        std::cout << (totalErrors == 0 ? "Verify passed: every position agrees with its moves" : "Verify FAILED") << std::endl;
+    return totalErrors == 0 ? 0 : 2;
+}
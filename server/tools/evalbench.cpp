@@ -0,0 +1,143 @@
+// server/tools/evalbench.cpp
+//
+// Measures how fast positions are scored by the static evaluator (see GameLogic/Evaluation.h):
+// one at a time in a plain loop, and in structure-of-arrays batches with each backend this
+// processor supports. Also checks that every backend gives exactly the loop's scores.
+//
+// Usage: checkers_evalbench [options]
+//   --positions N     score N different positions (default 1000000)
+//   --repeat N        score them N times per method, keeping the best time (default 5)
+//   --seed N          the seed for the random games the positions come from
+//
+// The positions are taken from random games played from the starting position, so they
+// look like the positions a search would score.
+
+#include "../GameLogic/BasicBoard.h"
+#include "../GameLogic/Evaluation.h"
+#include "../GameLogic/CompactMove.h"
+#include "../GameLogic/MoveList.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// the longest random game a position is taken from, in moves
+static const int MAX_GAME_LENGTH = 80;
+
+// Fills the batch with positions from random games: each game is played until it ends
+// (or runs long), and every position along the way is added.
+static void generatePositions(int count, unsigned seed, PositionBatch &batch)
+{
+    std::mt19937 random(seed);
+    batch.reserve(count);
+    while (batch.size() < count)
+    {
+        BasicBoard<EnglishRules> board;
+        for (int ply = 0; ply < MAX_GAME_LENGTH && batch.size() < count; ply++)
+        {
+            MoveList moves;
+            board.getAllLegalMoves(board.isWhiteToMove(), moves);
+            if (moves.size() == 0)
+                break;
+            board.makeMove(moves[random() % moves.size()]);
+            batch.add(board);
+        }
+    }
+}
+
+// Runs the given scoring function the given number of times, returning the fastest time in seconds.
+template <class Function>
+static double timeBest(int repeat, Function score)
+{
+    double best = 0;
+    for (int i = 0; i < repeat; i++)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        score();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        if (i == 0 || seconds < best)
+            best = seconds;
+    }
+    return best;
+}
+
+static void printResult(const std::string &name, int count, double seconds, double baseline)
+{
+    std::cout << name << ": " << count << " positions in " << seconds << " s ("
+              << (std::uint64_t)(seconds > 0 ? count / seconds : 0) << " positions/s";
+    if (baseline > 0 && seconds > 0)
+        std::cout << ", " << baseline / seconds << "x the loop";
+    std::cout << ")" << std::endl;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: checkers_evalbench [--positions N] [--repeat N] [--seed N]" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    int count = 1000000;
+    int repeat = 5;
+    unsigned seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--positions" && i + 1 < argc)
+            count = std::max(1, atoi(argv[++i]));
+        else if (arg == "--repeat" && i + 1 < argc)
+            repeat = std::max(1, atoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = (unsigned)atoi(argv[++i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    PositionBatch batch;
+    generatePositions(count, seed, batch);
+    EvalWeights weights;
+
+    // the baseline: one position at a time, through the same function the search uses
+    std::vector<int> expected(count);
+    const bitboard_t *white = batch.getWhitePieces();
+    const bitboard_t *black = batch.getBlackPieces();
+    const bitboard_t *kings = batch.getKings();
+    double loopSeconds = timeBest(repeat, [&]()
+    {
+        for (int i = 0; i < count; i++)
+            expected[i] = Evaluator::evaluate(white[i], black[i], kings[i], weights);
+    });
+    printResult("Scalar loop", count, loopSeconds, 0);
+
+    bool allMatch = true;
+    for (EvalBackend backend : {EVAL_SCALAR, EVAL_AVX2})
+    {
+        std::string name = std::string("Batch (") + Evaluator::getBackendName(backend) + ")";
+        if (!Evaluator::isSupported(backend))
+        {
+            std::cout << name << ": not supported here" << std::endl;
+            continue;
+        }
+
+        std::vector<int> scores(count);
+        double seconds = timeBest(repeat, [&]() { Evaluator::evaluateBatch(batch, weights, scores.data(), backend); });
+        printResult(name, count, seconds, loopSeconds);
+
+        if (scores != expected)
+        {
+            std::cout << "MISMATCH: " << name << " scores differ from the loop's" << std::endl;
+            allMatch = false;
+        }
+    }
+
+    std::cout << "Best backend here: " << Evaluator::getBackendName(Evaluator::getBestBackend()) << std::endl;
+    return allMatch ? 0 : 2;
+}
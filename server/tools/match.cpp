@@ -0,0 +1,446 @@
+// server/tools/match.cpp
+//
+// Plays two engines (A and B) against each other, many games at once on every core, and works
+// out how much stronger one is: run it before rolling out any change to the search or the
+// evaluation, with the old settings as one engine and the new ones as the other.
+//
+// Usage: checkers_match [options]
+//   --games N          play N games (default 1000, rounded up to an even number)
+//   --threads N        play N games at once (default: one per core)
+//   --depth N          search every move to depth N, for both engines (default 6)
+//   --depth-a N, --depth-b N      the same for one engine
+//   --nodes-a N, --nodes-b N      stop an engine's search after N nodes (default no limit)
+//   --engine-a E, --engine-b E    alphabeta (default) or mcts
+//   --playouts-a N, --playouts-b N  the playouts per move of an mcts engine (default 2000)
+//   --weights-a FILE, --weights-b FILE  an engine's evaluation weights (see checkers_tune)
+//   --hash MB          each engine's transposition table, per game being played (default 4)
+//   --opening-plies N  start every game from N random moves (default 6)
+//   --max-plies N      call a game that gets this long a draw (default 200)
+//   --output FILE      the archive to write the games to (default match.games)
+//   --seed N           the seed for the openings
+//   --quiet            only print the summary, not every game as it finishes
+//
+// Every opening is played twice, with each engine taking white once, so neither gains from
+// the openings. A game ends when a side has no moves (and has lost), when a position comes up
+// for the third time (a draw), or at --max-plies (a draw). As each game finishes, its result
+// is printed with the running score and Elo difference; at the end, the Elo difference of A
+// over B with its 95% error bars, and the games per second.
+//
+// The archive is compact, for keeping thousands of games: an 8 byte header "CKMATCH1", then a
+// record per game, in the order they finished: the game number (4 bytes, little-endian), the
+// result (1 byte: 0 white won, 1 drawn, 2 black won, plus 0x80 if engine A played white), the
+// number of opening plies (1 byte), the number of plies (2 bytes), then one byte per ply: the
+// index of the move played among the legal moves BasicBoard::getAllLegalMoves lists, from the
+// starting position (so every move, jump chains included, is unambiguous).
+//
+// Each thread keeps its own engines and plays one game at a time on a board it copies by value
+// (a few words, no allocation), so playing is all searching.
+
+#include "../GameLogic/BasicBoard.h"
+#include "../GameLogic/MonteCarloSearch.h"
+#include "../GameLogic/MoveList.h"
+#include "../GameLogic/Search.h"
+#include "../GameLogic/TranspositionTable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// the longest game the archive (and a game's move buffer) can hold
+static const int MAX_PLIES_LIMIT = 1000;
+
+// How one engine plays.
+struct EngineSettings
+{
+    bool monteCarlo = false;
+    int depth = 6;
+    std::uint64_t nodes = 0;
+    std::uint64_t playouts = 2000;
+    EvalWeights weights;
+};
+
+// A game's result, from white's side.
+enum GameResult
+{
+    WHITE_WON = 0,
+    DRAWN = 1,
+    BLACK_WON = 2
+};
+
+// One engine, as a thread plays with it: its searcher and tables, kept from game to game.
+class MatchEngine
+{
+    public:
+        MatchEngine(const EngineSettings &settings, std::size_t hashMegabytes)
+            : settings(settings)
+        {
+            if (settings.monteCarlo)
+                monteCarlo.reset(new MonteCarloSearch(std::max<std::size_t>(1, hashMegabytes), 1, settings.weights));
+            else
+            {
+                table.reset(new TranspositionTable(hashMegabytes));
+                search.reset(new Search(settings.weights, table.get()));
+            }
+            limits.maxDepth = settings.depth;
+            limits.maxNodes = settings.nodes;
+        }
+
+        // Forgets everything from the last game.
+        void newGame()
+        {
+            if (table)
+                table->clear();
+            if (monteCarlo)
+                monteCarlo->clear();
+        }
+
+        // Picks a move (the side to move has at least one), given the positions the game has been in.
+        CompactMove chooseMove(const BasicBoard<EnglishRules> &board, const std::vector<hashkey_t> &history)
+        {
+            if (monteCarlo)
+            {
+                MonteCarloLimits monteCarloLimits;
+                monteCarloLimits.maxPlayouts = settings.playouts;
+                return monteCarlo->run(board, monteCarloLimits).bestMove;
+            }
+            // as the game's players do, so the table knows which entries are from earlier moves
+            table->newSearch();
+            search->setGameHistory(history);
+            return search->run(board, limits).bestMove;
+        }
+
+    private:
+        EngineSettings settings;
+        SearchLimits limits;
+        std::unique_ptr<TranspositionTable> table;
+        std::unique_ptr<Search> search;
+        std::unique_ptr<MonteCarloSearch> monteCarlo;
+};
+
+// A finished game, as it is archived.
+struct GameRecord
+{
+    std::uint32_t number = 0;
+    GameResult result = DRAWN;
+    bool engineAIsWhite = true;
+    int openingPlies = 0;
+    int plies = 0;
+    std::uint8_t moves[MAX_PLIES_LIMIT];
+};
+
+// The running totals, from engine A's side, and the archive they are written with.
+class MatchResults
+{
+    public:
+        MatchResults(std::FILE *archive, bool quiet) : archive(archive), quiet(quiet) {}
+
+        // Archives a finished game and prints it with the score so far.
+        void add(const GameRecord &game)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            writeRecord(game);
+
+            bool engineAWon = game.result == (game.engineAIsWhite ? WHITE_WON : BLACK_WON);
+            if (game.result == DRAWN)
+                draws++;
+            else if (engineAWon)
+                wins++;
+            else
+                losses++;
+
+            if (!quiet)
+            {
+                static const char *const resultNames[] = { "1-0", "1/2-1/2", "0-1" };
+                std::cout << std::setw(6) << game.number << "  " << (game.engineAIsWhite ? "A-B" : "B-A") << "  "
+                          << std::setw(7) << resultNames[game.result] << "  " << std::setw(4) << game.plies << " plies   A +"
+                          << wins << " =" << draws << " -" << losses << "   " << describeElo() << std::endl;
+            }
+        }
+
+        // Returns the Elo difference of A over B so far, with its 95% error bars.
+        std::string describeElo() const
+        {
+            int games = wins + draws + losses;
+            if (games == 0)
+                return "no games";
+            double score = (wins + draws / 2.0) / games;
+
+            // the spread of a game's score, and so the standard error of the mean
+            double variance = (wins * (1 - score) * (1 - score) + draws * (0.5 - score) * (0.5 - score) +
+                               losses * score * score) / games;
+            double error = std::sqrt(variance / games);
+            double low = toElo(score - 1.96 * error);
+            double high = toElo(score + 1.96 * error);
+
+            // (adding 0 turns an even score's -0 into 0)
+            std::ostringstream text;
+            text << "Elo " << std::showpos << std::fixed << std::setprecision(1) << toElo(score) + 0.0 << std::noshowpos;
+            if (std::isfinite(low) && std::isfinite(high))
+                text << " +/- " << (high - low) / 2 << " (95%)";
+            else
+                text << " (too few games for error bars)";
+            return text.str();
+        }
+
+        int getWins() const { return wins; }
+        int getDraws() const { return draws; }
+        int getLosses() const { return losses; }
+
+    private:
+        std::mutex mutex;
+        std::FILE *archive;
+        bool quiet;
+        int wins = 0;
+        int draws = 0;
+        int losses = 0;
+
+        // The Elo difference that makes the stronger side expect the given share of the points.
+        static double toElo(double score)
+        {
+            if (score <= 0 || score >= 1)
+                return score <= 0 ? -INFINITY : INFINITY;
+            return -400 * std::log10(1 / score - 1);
+        }
+
+        void writeRecord(const GameRecord &game)
+        {
+            if (archive == nullptr)
+                return;
+            std::uint8_t header[8];
+            for (int i = 0; i < 4; i++)
+                header[i] = (std::uint8_t)(game.number >> (8 * i));
+            header[4] = (std::uint8_t)(game.result | (game.engineAIsWhite ? 0x80 : 0));
+            header[5] = (std::uint8_t)game.openingPlies;
+            header[6] = (std::uint8_t)(game.plies & 0xFF);
+            header[7] = (std::uint8_t)(game.plies >> 8);
+            std::fwrite(header, 1, sizeof(header), archive);
+            std::fwrite(game.moves, 1, game.plies, archive);
+        }
+};
+
+// Plays random moves from the starting position: the opening of the given pair of games.
+static BasicBoard<EnglishRules> makeOpening(std::uint64_t seed, std::uint32_t pair, int plies, GameRecord &game)
+{
+    std::mt19937_64 random(seed * 0x9E3779B97F4A7C15ULL + pair);
+    while (true)
+    {
+        BasicBoard<EnglishRules> board;
+        game.plies = 0;
+        bool finished = false;
+        for (int ply = 0; ply < plies && !finished; ply++)
+        {
+            MoveList moves;
+            board.getAllLegalMoves(board.isWhiteToMove(), moves);
+            if (moves.empty())
+                finished = true;
+            else
+            {
+                int index = (int)(random() % moves.size());
+                board.makeMove(moves[index]);
+                game.moves[game.plies++] = (std::uint8_t)index;
+            }
+        }
+
+        // an opening has to leave a game to play
+        MoveList moves;
+        board.getAllLegalMoves(board.isWhiteToMove(), moves);
+        if (!finished && !moves.empty())
+        {
+            game.openingPlies = game.plies;
+            return board;
+        }
+    }
+}
+
+// Plays one game from its opening to the end.
+static void playGame(BasicBoard<EnglishRules> board, MatchEngine &white, MatchEngine &black, int maxPlies,
+                     std::vector<hashkey_t> &history, GameRecord &game)
+{
+    white.newGame();
+    black.newGame();
+    history.clear();
+    history.push_back(board.getHash());
+    // the last position a repetition could go back to (nothing before a capture or man move can come up again)
+    std::size_t lastIrreversible = 0;
+
+    while (true)
+    {
+        bool whiteToMove = board.isWhiteToMove();
+        MoveList moves;
+        board.getAllLegalMoves(whiteToMove, moves);
+        if (moves.empty())
+        {
+            game.result = whiteToMove ? BLACK_WON : WHITE_WON;
+            return;
+        }
+        if (game.plies >= maxPlies)
+        {
+            game.result = DRAWN;
+            return;
+        }
+
+        CompactMove move = moves.size() == 1 ? moves[0] : (whiteToMove ? white : black).chooseMove(board, history);
+        int index = 0;
+        while (index < moves.size() - 1 && !(moves[index] == move))
+            index++;
+        bool irreversible = move.isJump() || !(board.getKingMask(whiteToMove) & ((bitboard_t)1 << move.getFrom()));
+        board.makeMove(moves[index]);
+        game.moves[game.plies++] = (std::uint8_t)index;
+
+        if (irreversible)
+            lastIrreversible = history.size();
+        history.push_back(board.getHash());
+
+        // the key includes the side to move, so only every other position can match
+        int occurrences = 0;
+        for (std::size_t i = history.size() - 1; ; i -= 2)
+        {
+            if (history[i] == history.back() && ++occurrences >= 3)
+            {
+                game.result = DRAWN;
+                return;
+            }
+            if (i < lastIrreversible + 2)
+                break;
+        }
+    }
+}
+
+static bool parseEngine(const std::string &name, bool &monteCarlo)
+{
+    if (name != "alphabeta" && name != "mcts")
+        return false;
+    monteCarlo = name == "mcts";
+    return true;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: checkers_match [--games N] [--threads N] [--depth N] [--depth-a N] [--depth-b N] [--nodes-a N] [--nodes-b N]" << std::endl;
+    std::cout << "                      [--engine-a alphabeta|mcts] [--engine-b alphabeta|mcts] [--playouts-a N] [--playouts-b N]" << std::endl;
+    std::cout << "                      [--weights-a FILE] [--weights-b FILE]" << std::endl;
+    std::cout << "                      [--hash MB] [--opening-plies N] [--max-plies N] [--output FILE] [--seed N] [--quiet]" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    int games = 1000;
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    EngineSettings engines[2];
+    std::size_t hashMegabytes = 4;
+    int openingPlies = 6;
+    int maxPlies = 200;
+    std::string output = "match.games";
+    std::uint64_t seed = 1;
+    bool quiet = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--quiet")
+            quiet = true;
+        else if (arg == "--games" && hasValue)
+            games = std::max(2, atoi(argv[++i]));
+        else if (arg == "--threads" && hasValue)
+            threads = std::max(1, atoi(argv[++i]));
+        else if (arg == "--depth" && hasValue)
+            engines[0].depth = engines[1].depth = std::max(1, std::min((int)Search::MAX_DEPTH, atoi(argv[++i])));
+        else if ((arg == "--depth-a" || arg == "--depth-b") && hasValue)
+            engines[arg == "--depth-b"].depth = std::max(1, std::min((int)Search::MAX_DEPTH, atoi(argv[++i])));
+        else if ((arg == "--nodes-a" || arg == "--nodes-b") && hasValue)
+            engines[arg == "--nodes-b"].nodes = (std::uint64_t)std::max(0LL, atoll(argv[++i]));
+        else if ((arg == "--engine-a" || arg == "--engine-b") && hasValue && parseEngine(argv[i + 1], engines[arg == "--engine-b"].monteCarlo))
+            i++;
+        else if ((arg == "--playouts-a" || arg == "--playouts-b") && hasValue)
+            engines[arg == "--playouts-b"].playouts = (std::uint64_t)std::max(1LL, atoll(argv[++i]));
+        else if ((arg == "--weights-a" || arg == "--weights-b") && hasValue)
+        {
+            if (!Evaluator::readWeights(argv[++i], engines[arg == "--weights-b"].weights))
+            {
+                std::cerr << "Could not read the weights file " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--hash" && hasValue)
+            hashMegabytes = (std::size_t)std::max(1, atoi(argv[++i]));
+        else if (arg == "--opening-plies" && hasValue)
+            openingPlies = std::max(0, std::min(64, atoi(argv[++i])));
+        else if (arg == "--max-plies" && hasValue)
+            maxPlies = std::max(1, std::min(MAX_PLIES_LIMIT, atoi(argv[++i])));
+        else if (arg == "--output" && hasValue)
+            output = argv[++i];
+        else if (arg == "--seed" && hasValue)
+            seed = (std::uint64_t)atoll(argv[++i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+    games += games % 2;
+
+    std::FILE *archive = std::fopen(output.c_str(), "wb");
+    if (archive == nullptr)
+    {
+        std::cerr << "Could not write " << output << std::endl;
+        return 1;
+    }
+    std::fwrite("CKMATCH1", 1, 8, archive);
+
+    std::cout << games << " games on " << threads << " threads, " << openingPlies << " random opening plies, A: "
+              << (engines[0].monteCarlo ? "mcts" : "alphabeta") << ", B: " << (engines[1].monteCarlo ? "mcts" : "alphabeta")
+              << std::endl;
+
+    MatchResults results(archive, quiet);
+    std::atomic<int> nextGame(0);
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < std::min(threads, games); t++)
+    {
+        workers.emplace_back([&] {
+            MatchEngine engineA(engines[0], hashMegabytes);
+            MatchEngine engineB(engines[1], hashMegabytes);
+            // reused from game to game, like the game record
+            std::vector<hashkey_t> history;
+            history.reserve(MAX_PLIES_LIMIT + 1);
+            std::unique_ptr<GameRecord> game(new GameRecord());
+
+            for (int number = nextGame++; number < games; number = nextGame++)
+            {
+                // games 2n and 2n + 1 play the same opening, with the engines' colors swapped
+                *game = GameRecord();
+                game->number = (std::uint32_t)number;
+                game->engineAIsWhite = number % 2 == 0;
+                BasicBoard<EnglishRules> board = makeOpening(seed, (std::uint32_t)(number / 2), openingPlies, *game);
+                if (game->engineAIsWhite)
+                    playGame(board, engineA, engineB, maxPlies, history, *game);
+                else
+                    playGame(board, engineB, engineA, maxPlies, history, *game);
+                results.add(*game);
+            }
+        });
+    }
+    for (std::thread &worker : workers)
+        worker.join();
+    std::fclose(archive);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "A +" << results.getWins() << " =" << results.getDraws() << " -" << results.getLosses() << ": "
+              << results.describeElo() << ", " << std::fixed << std::setprecision(2)
+              << (seconds > 0 ? games / seconds : 0) << " games/s, archived in " << output << std::endl;
+    return 0;
+}
@@ -0,0 +1,136 @@
+// server/tools/mctsbench.cpp
+//
+// Measures how the Monte Carlo tree search scales with threads (see GameLogic/MonteCarloSearch.h):
+// every position is searched for the same number of playouts with 1, 2, 4, 8 and 16 threads
+// (up to --max-threads), and the playouts per second, overall and per thread, are compared with
+// one thread's. On a machine with a core per thread, playouts per second per thread staying
+// level means the threads aren't getting in each other's way in the shared tree.
+//
+// Usage: checkers_mctsbench [options]
+//   --playouts N      run N playouts on every position (default 20000)
+//   --positions N     search N positions (default 16)
+//   --max-threads N   stop at N threads (default 16)
+//   --tree MB         the size of each node arena (default 32)
+//   --seed N          the seed for the random games the positions come from
+//
+// The positions are taken from random games played from the starting position, and the tree is
+// cleared before every search, so each thread count starts from the same thing.
+
+#include "../GameLogic/BasicBoard.h"
+#include "../GameLogic/MoveList.h"
+#include "../GameLogic/MonteCarloSearch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// how far into a random game a position may be taken from, in moves
+static const int MIN_PLIES = 6;
+static const int MAX_PLIES = 30;
+
+// Plays random games, keeping one position from each that still has a choice of moves.
+static std::vector<BasicBoard<EnglishRules>> generatePositions(int count, unsigned seed)
+{
+    std::mt19937 random(seed);
+    std::vector<BasicBoard<EnglishRules>> positions;
+    while ((int)positions.size() < count)
+    {
+        BasicBoard<EnglishRules> board;
+        int plies = MIN_PLIES + (int)(random() % (MAX_PLIES - MIN_PLIES + 1));
+        bool finished = false;
+        for (int ply = 0; ply < plies && !finished; ply++)
+        {
+            MoveList moves;
+            board.getAllLegalMoves(board.isWhiteToMove(), moves);
+            if (moves.size() == 0)
+                finished = true;
+            else
+                board.makeMove(moves[random() % moves.size()]);
+        }
+
+        MoveList moves;
+        board.getAllLegalMoves(board.isWhiteToMove(), moves);
+        if (!finished && moves.size() > 1)
+            positions.push_back(board);
+    }
+    return positions;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: checkers_mctsbench [--playouts N] [--positions N] [--max-threads N] [--tree MB] [--seed N]" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::uint64_t playouts = 20000;
+    int count = 16;
+    int maxThreads = 16;
+    size_t treeMegabytes = 32;
+    unsigned seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--playouts" && i + 1 < argc)
+            playouts = (std::uint64_t)std::max(1LL, atoll(argv[++i]));
+        else if (arg == "--positions" && i + 1 < argc)
+            count = std::max(1, atoi(argv[++i]));
+        else if (arg == "--max-threads" && i + 1 < argc)
+            maxThreads = std::max(1, atoi(argv[++i]));
+        else if (arg == "--tree" && i + 1 < argc)
+            treeMegabytes = (size_t)std::max(1, atoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = (unsigned)atoi(argv[++i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::vector<BasicBoard<EnglishRules>> positions = generatePositions(count, seed);
+    MonteCarloLimits limits;
+    limits.maxPlayouts = playouts;
+
+    std::cout << count << " positions, " << playouts << " playouts each, " << treeMegabytes << " MB arenas, "
+              << std::thread::hardware_concurrency() << " cores" << std::endl;
+    // powers of two, then the largest count asked for if it isn't one
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    if (threadCounts.back() != maxThreads)
+        threadCounts.push_back(maxThreads);
+
+    double baseline = 0;
+    for (int threads : threadCounts)
+    {
+        MonteCarloSearch search(treeMegabytes, threads, EvalWeights(), seed);
+        double seconds = 0;
+        std::uint64_t done = 0;
+        for (const BasicBoard<EnglishRules> &position : positions)
+        {
+            search.clear();
+            // timed here rather than by the search, so waiting for the workers to stop counts too
+            auto startTime = std::chrono::steady_clock::now();
+            MonteCarloResult result = search.run(position, limits);
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            done += result.playouts;
+        }
+        double rate = seconds > 0 ? done / seconds : 0;
+        if (threads == 1)
+            baseline = rate;
+
+        std::cout << std::setw(2) << threads << " threads: " << std::fixed << std::setprecision(3) << seconds << " s, "
+                  << done << " playouts (" << (std::uint64_t)rate << " playouts/s, " << (std::uint64_t)(rate / threads)
+                  << " per thread), " << std::setprecision(2) << (baseline > 0 ? rate / baseline : 0) << "x one thread"
+                  << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,330 @@
+// server/tools/perft.cpp
+//
+// Counts the leaf positions of the move tree to a fixed depth ("perft"), to measure how fast
+// the move generator is and to check that it generates the right moves.
+//
+// Usage: checkers_perft [depth] [options]
+//   --divide          print the count under each root move
+//   --threads N       split the root moves between N threads
+//   --hash MB         share a transposition table of this many megabytes between the threads
+//   --position POS    start from POS instead of the starting position
+//   --variant V       english (the default, 8x8) or international (10x10 draughts)
+//   --verify          check Board's generator against Piece's at every node (slow, english only)
+//
+// A position is the side to move (W or B), a colon, and one character for each of the
+// playable squares (32, or 50 for international) in square order (see GameLogic/Bitboard.h):
+// w and b for men, W and B for kings, and . for an empty square.
+
+#include "../GameLogic/Board.h"
+#include "../GameLogic/Piece.h"
+#include "../GameLogic/Move.h"
+#include "../GameLogic/MoveList.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char *START_POSITION = "W:wwwwwwwwwwww........bbbbbbbbbbbb";
+
+// A transposition table shared by all threads, without locks: each entry stores its key
+// XORed with its data, so an entry torn by two threads writing at once simply fails to match.
+class PerftTable
+{
+public:
+    explicit PerftTable(size_t megabytes)
+    {
+        size_t count = 1;
+        while (count * 2 * sizeof(Entry) <= megabytes * 1024 * 1024)
+            count *= 2;
+        entries = std::vector<Entry>(megabytes ? count : 0);
+        mask = count - 1;
+    }
+
+    bool enabled() const { return !entries.empty(); }
+
+    bool probe(hashkey_t key, int depth, std::uint64_t &nodes) const
+    {
+        const Entry &entry = entries[key & mask];
+        std::uint64_t data = entry.data.load(std::memory_order_relaxed);
+        if ((entry.check.load(std::memory_order_relaxed) ^ data) != key || (int)(data & 0xff) != depth)
+            return false;
+        nodes = data >> 8;
+        return true;
+    }
+
+    void store(hashkey_t key, int depth, std::uint64_t nodes)
+    {
+        Entry &entry = entries[key & mask];
+        std::uint64_t data = (nodes << 8) | (std::uint64_t)depth;
+        entry.check.store(key ^ data, std::memory_order_relaxed);
+        entry.data.store(data, std::memory_order_relaxed);
+    }
+
+private:
+    struct Entry
+    {
+        std::atomic<std::uint64_t> check{0};
+        std::atomic<std::uint64_t> data{0};
+    };
+
+    std::vector<Entry> entries;
+    size_t mask;
+};
+
+static std::atomic<bool> verifyFailed(false);
+
+// Generates the moves of the side to move the slow way, piece by piece through Piece
+// (and its recursive getAllPossibleJumps), and checks Board's generator made the same ones.
+static void verifyMoves(const Board &board, const MoveList &moves)
+{
+    bool isWhite = board.isWhiteToMove();
+    std::vector<std::uint64_t> expected;
+    bool anyJump = false;
+
+    bitboard_t pieces = board.getPieceMask(isWhite);
+    while (pieces)
+    {
+        coords_t coords = Board::getCoordsFromSquare(popLowestSquare(pieces));
+        const Piece *piece = board.getValueAt(coords[0], coords[1]);
+
+        MoveList pieceMoves;
+        piece->getAllPossibleMoves(board, pieceMoves);
+
+        // the linked Move objects built from the same list must capture the same pieces
+        moves_t legacyMoves = piece->getAllPossibleMoves(board);
+        for (int i = 0; i < pieceMoves.size(); i++)
+        {
+            bitboard_t captured = 0;
+            std::vector<Piece *> jumpedPieces = legacyMoves[i]->getJumpedPieces(board);
+            for (Piece *jumped : jumpedPieces)
+            {
+                coords_t jumpedPos = jumped->getCoordinates();
+                captured |= squareMask(Board::getSquareFromCoords(jumpedPos[0], jumpedPos[1]));
+            }
+            coords_t end = legacyMoves[i]->getEndingPosition();
+            if (captured != pieceMoves[i].getCaptureMask() ||
+                Board::getSquareFromCoords(end[0], end[1]) != pieceMoves[i].getTo())
+                verifyFailed = true;
+        }
+
+        for (const CompactMove &move : pieceMoves)
+        {
+            expected.push_back(move.toBits());
+            anyJump = anyJump || move.isJump();
+        }
+    }
+
+    // captures are mandatory
+    if (anyJump)
+    {
+        expected.erase(std::remove_if(expected.begin(), expected.end(),
+                                      [](std::uint64_t bits) { return !CompactMove::fromBits(bits).isJump(); }),
+                       expected.end());
+    }
+
+    std::vector<std::uint64_t> generated;
+    for (const CompactMove &move : moves)
+        generated.push_back(move.toBits());
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(generated.begin(), generated.end());
+    if (expected != generated)
+        verifyFailed = true;
+}
+
+// (Piece only plays the 8x8 game, so there is nothing to check other boards against)
+template <class BoardType, class ListType>
+static void verifyMoves(const BoardType &, const ListType &)
+{
+}
+
+template <class BoardType>
+static std::uint64_t perft(BoardType &board, int depth, PerftTable &table, bool verify)
+{
+    std::uint64_t nodes = 0;
+    if (depth > 1 && table.enabled() && table.probe(board.getHash(), depth, nodes))
+        return nodes;
+
+    typename BoardType::move_list_type moves;
+    board.getAllLegalMoves(board.isWhiteToMove(), moves);
+    if (verify)
+        verifyMoves(board, moves);
+
+    // the moves at the last ply only need counting, not making
+    if (depth == 1)
+        return moves.size();
+
+    for (const typename BoardType::move_type &move : moves)
+    {
+        typename BoardType::undo_type undo = board.makeMove(move);
+        nodes += perft(board, depth - 1, table, verify);
+        board.unmakeMove(move, undo);
+    }
+
+    if (table.enabled())
+        table.store(board.getHash(), depth, nodes);
+    return nodes;
+}
+
+template <class Rules>
+static bool parsePosition(const std::string &text, typename Rules::bitboard_type &white, typename Rules::bitboard_type &black,
+                          typename Rules::bitboard_type &kings, bool &whiteToMove)
+{
+    if (text.size() != 2 + Rules::PLAYABLE_SQUARES || (text[0] != 'W' && text[0] != 'B') || text[1] != ':')
+        return false;
+
+    whiteToMove = text[0] == 'W';
+    white = black = kings = 0;
+    for (int square = 0; square < Rules::PLAYABLE_SQUARES; square++)
+    {
+        char c = text[2 + square];
+        if (c == '.')
+            continue;
+        if (!strchr("wbWB", c))
+            return false;
+        typename Rules::bitboard_type mask = (typename Rules::bitboard_type)1 << square;
+        if (c == 'w' || c == 'W')
+            white |= mask;
+        else
+            black |= mask;
+        if (c == 'W' || c == 'B')
+            kings |= mask;
+    }
+    return true;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: checkers_perft [depth] [--divide] [--threads N] [--hash MB] [--position POS]" << std::endl;
+    std::cout << "                      [--variant english|international] [--verify]" << std::endl;
+    std::cout << "  POS is W or B (side to move), ':', then 32 (or 50) squares of w/b (men), W/B (kings) or ." << std::endl;
+    std::cout << "  e.g. " << START_POSITION << std::endl;
+}
+
+// Counts the tree under a position (the starting one if none is given) with the board type of a rule set.
+template <class Rules, class BoardType>
+static int runPerft(const std::string &position, int depth, bool divide, bool verify, int threadCount, size_t hashMegabytes)
+{
+    BoardType root;
+    if (!position.empty())
+    {
+        typename Rules::bitboard_type white, black, kings;
+        bool whiteToMove;
+        if (!parsePosition<Rules>(position, white, black, kings, whiteToMove) || (white & black))
+        {
+            std::cout << "Invalid position: " << position << std::endl;
+            printUsage();
+            return 1;
+        }
+        root = BoardType(white, black, kings, whiteToMove);
+    }
+    typename BoardType::move_list_type rootMoves;
+    root.getAllLegalMoves(root.isWhiteToMove(), rootMoves);
+
+    PerftTable table(hashMegabytes);
+    std::vector<std::uint64_t> rootCounts(rootMoves.size(), 0);
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    // every thread takes the next unsearched root move, on a copy of the board of its own
+    std::atomic<int> nextRootMove(0);
+    auto worker = [&]()
+    {
+        BoardType board(root);
+        for (int i = nextRootMove++; i < rootMoves.size(); i = nextRootMove++)
+        {
+            typename BoardType::undo_type undo = board.makeMove(rootMoves[i]);
+            rootCounts[i] = depth == 1 ? 1 : perft(board, depth - 1, table, verify);
+            board.unmakeMove(rootMoves[i], undo);
+        }
+    };
+
+    if (verify)
+        verifyMoves(root, rootMoves);
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; i++)
+        threads.emplace_back(worker);
+    worker();
+    for (std::thread &thread : threads)
+        thread.join();
+
+    auto endTime = std::chrono::steady_clock::now();
+
+    std::uint64_t total = 0;
+    for (int i = 0; i < rootMoves.size(); i++)
+    {
+        total += rootCounts[i];
+        if (divide)
+        {
+            coords_t start = BoardType::getCoordsFromSquare(rootMoves[i].getFrom());
+            coords_t end = BoardType::getCoordsFromSquare(rootMoves[i].getTo());
+            std::cout << "(" << start[0] << "," << start[1] << ") -> (" << end[0] << "," << end[1] << ")"
+                      << (rootMoves[i].isJump() ? " [JUMP]" : "") << ": " << rootCounts[i] << std::endl;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(endTime - startTime).count();
+    std::cout << "Depth " << depth << ": " << total << " nodes in " << seconds << " s ("
+              << (std::uint64_t)(seconds > 0 ? total / seconds : 0) << " nodes/s, "
+              << threadCount << " thread" << (threadCount == 1 ? "" : "s")
+              << (table.enabled() ? ", hash table" : "") << ")" << std::endl;
+
+    if (verify)
+    {
+        std::cout << (verifyFailed ? "VERIFY FAILED: Piece and Board generate different moves"
+                                   : "Verify passed: Piece and Board generate the same moves") << std::endl;
+        return verifyFailed ? 2 : 0;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int depth = 6;
+    bool divide = false;
+    bool verify = false;
+    bool international = false;
+    int threadCount = 1;
+    size_t hashMegabytes = 0;
+    std::string position;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--divide")
+            divide = true;
+        else if (arg == "--verify")
+            verify = true;
+        else if (arg == "--threads" && i + 1 < argc)
+            threadCount = std::max(1, atoi(argv[++i]));
+        else if (arg == "--hash" && i + 1 < argc)
+            hashMegabytes = (size_t)std::max(0, atoi(argv[++i]));
+        else if (arg == "--position" && i + 1 < argc)
+            position = argv[++i];
+        else if (arg == "--variant" && i + 1 < argc && (std::string(argv[i + 1]) == "english" || std::string(argv[i + 1]) == "international"))
+            international = std::string(argv[++i]) == "international";
+        else if (!arg.empty() && isdigit((unsigned char)arg[0]))
+            depth = std::max(1, atoi(arg.c_str()));
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (international && verify)
+    {
+        std::cout << "--verify checks against Piece, which only plays the 8x8 game" << std::endl;
+        return 1;
+    }
+    if (international)
+        return runPerft<InternationalRules, BasicBoard<InternationalRules>>(position, depth, divide, verify, threadCount, hashMegabytes);
+    return runPerft<EnglishRules, Board>(position.empty() ? START_POSITION : position, depth, divide, verify, threadCount, hashMegabytes);
+}
@@ -0,0 +1,133 @@
+// server/tools/smpbench.cpp
+//
+// Measures how much faster the search reaches a fixed depth with more threads (see
+// GameLogic/ParallelSearch.h): every position is searched to the same depth with 1, 2, 4,
+// 8 and 16 threads (up to --max-threads), and the total time to depth is compared with one thread's.
+//
+// Usage: checkers_smpbench [options]
+//   --depth N         search every position to depth N (default 14)
+//   --positions N     search N positions (default 16)
+//   --max-threads N   stop at N threads (default 16)
+//   --hash MB         the size of the shared transposition table (default 64)
+//   --seed N          the seed for the random games the positions come from
+//
+// The positions are taken from random games played from the starting position, and the table
+// is cleared before every search, so each thread count searches exactly the same thing.
+
+#include "../GameLogic/BasicBoard.h"
+#include "../GameLogic/MoveList.h"
+#include "../GameLogic/ParallelSearch.h"
+#include "../GameLogic/TranspositionTable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// how far into a random game a position may be taken from, in moves
+static const int MIN_PLIES = 6;
+static const int MAX_PLIES = 30;
+
+// Plays random games, keeping one position from each that still has a choice of moves.
+static std::vector<BasicBoard<EnglishRules>> generatePositions(int count, unsigned seed)
+{
+    std::mt19937 random(seed);
+    std::vector<BasicBoard<EnglishRules>> positions;
+    while ((int)positions.size() < count)
+    {
+        BasicBoard<EnglishRules> board;
+        int plies = MIN_PLIES + (int)(random() % (MAX_PLIES - MIN_PLIES + 1));
+        bool finished = false;
+        for (int ply = 0; ply < plies && !finished; ply++)
+        {
+            MoveList moves;
+            board.getAllLegalMoves(board.isWhiteToMove(), moves);
+            if (moves.size() == 0)
+                finished = true;
+            else
+                board.makeMove(moves[random() % moves.size()]);
+        }
+
+        MoveList moves;
+        board.getAllLegalMoves(board.isWhiteToMove(), moves);
+        if (!finished && moves.size() > 1)
+            positions.push_back(board);
+    }
+    return positions;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: checkers_smpbench [--depth N] [--positions N] [--max-threads N] [--hash MB] [--seed N]" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    int depth = 14;
+    int count = 16;
+    int maxThreads = 16;
+    size_t hashMegabytes = 64;
+    unsigned seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--depth" && i + 1 < argc)
+            depth = std::max(1, atoi(argv[++i]));
+        else if (arg == "--positions" && i + 1 < argc)
+            count = std::max(1, atoi(argv[++i]));
+        else if (arg == "--max-threads" && i + 1 < argc)
+            maxThreads = std::max(1, atoi(argv[++i]));
+        else if (arg == "--hash" && i + 1 < argc)
+            hashMegabytes = (size_t)std::max(1, atoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = (unsigned)atoi(argv[++i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::vector<BasicBoard<EnglishRules>> positions = generatePositions(count, seed);
+    TranspositionTable table(hashMegabytes);
+    SearchLimits limits;
+    limits.maxDepth = depth;
+
+    std::cout << count << " positions to depth " << depth << ", " << hashMegabytes << " MB table" << std::endl;
+    // powers of two, then the largest count asked for if it isn't one
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    if (threadCounts.back() != maxThreads)
+        threadCounts.push_back(maxThreads);
+
+    double baseline = 0;
+    for (int threads : threadCounts)
+    {
+        ParallelSearch search(table, threads);
+        double seconds = 0;
+        std::uint64_t nodes = 0;
+        for (const BasicBoard<EnglishRules> &position : positions)
+        {
+            table.clear();
+            // timed here rather than by the search, so waiting for the helpers to stop counts too
+            auto startTime = std::chrono::steady_clock::now();
+            SearchResult result = search.run(position, limits, threads);
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            nodes += result.nodes;
+        }
+        if (threads == 1)
+            baseline = seconds;
+
+        std::cout << std::setw(2) << threads << " threads: " << std::fixed << std::setprecision(3) << seconds
+                  << " s to depth, " << nodes << " nodes (" << (std::uint64_t)(seconds > 0 ? nodes / seconds : 0)
+                  << " nodes/s), " << std::setprecision(2) << (seconds > 0 ? baseline / seconds : 0)
+                  << "x one thread" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,445 @@
+// server/tools/tune.cpp
+//
+// Fits the evaluation weights (see GameLogic/Evaluation.h) to the results of played games, and
+// writes them to a weights file the game and the server load at startup, so the evaluation can
+// be tuned without touching the code.
+//
+// Usage: checkers_tune [options] POSITIONS...
+//   --output FILE     the weights file to write (default eval.weights)
+//   --weights FILE    the weights to start from (default: the built-in ones)
+//   --epochs N        how many passes over the positions to make (default 200)
+//   --rate R          the most a weight moves per pass, in hundredths of a man (default 1)
+//   --threads N       the threads to work with (default: one per core)
+//
+// Each input is either an archive written by checkers_match, whose games are replayed with
+// every position after the random opening labelled with how its game ended, or a text file
+// with a labelled position per line: the result ("1-0" if white won, "0-1" if black won,
+// "1/2-1/2" for a draw), then the position the way ANALYZE takes it, e.g. "1-0 W:W9,10,K14:B22,23"
+// (the side to move, then each side's squares from 1 to 32, K for kings). Blank lines and lines
+// starting with '#' are skipped. Positions where the side to move has to capture, or can't move,
+// are left out: the evaluation is only ever asked about quiet positions.
+//
+// The weights are fitted the way Texel tuning does it: a position's score is turned into the
+// expected result for white by a logistic curve, and the weights are moved (by Adam, one step
+// per pass) to make the mean squared error between that and the real results as small as it
+// goes. The curve's scale is fitted first, to the starting weights, and the man's weight is
+// kept as it is, since it sets the scale of all the others. The best weights seen are written.
+//
+// The positions are dealt out to the threads, each of which keeps its share in flat arrays
+// (bitboards in a PositionBatch, and each unweighted term in an array of its own). Every pass,
+// each thread scores its positions with the batch evaluator and adds up its share of the error
+// and the gradient; since the evaluation is a weighted sum, a weight's gradient is its term
+// times how much the error changes with the score.
+
+#include "../GameLogic/BasicBoard.h"
+#include "../GameLogic/Evaluation.h"
+#include "../GameLogic/MoveList.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// the terms, each with the weight it is multiplied by
+static const int TERM_COUNT = 5;
+static const char *const TERM_NAMES[TERM_COUNT] = { "man", "king", "backRank", "mobility", "center" };
+static int EvalWeights::*const WEIGHTS[TERM_COUNT] = {
+    &EvalWeights::man, &EvalWeights::king, &EvalWeights::backRank, &EvalWeights::mobility, &EvalWeights::center
+};
+static int EvalTerms::*const TERMS[TERM_COUNT] = {
+    &EvalTerms::material, &EvalTerms::kings, &EvalTerms::backRank, &EvalTerms::mobility, &EvalTerms::center
+};
+// the term whose weight is never changed (the man's)
+static const int FIXED_TERM = 0;
+
+// the range the curve's scale is looked for in, per hundredth of a man
+static const double MIN_SCALE = 0.0005;
+static const double MAX_SCALE = 0.05;
+
+// Adam's decay rates for the mean of the gradient and of its square
+static const double MEAN_DECAY = 0.9;
+static const double SQUARE_DECAY = 0.999;
+
+// The positions one thread works on, each field in a flat array of its own.
+struct PositionShard
+{
+    PositionBatch positions;
+    // each unweighted term of each position (see EvalTerms)
+    std::vector<std::int8_t> terms[TERM_COUNT];
+    // how each position's game went for white, in half points (2 won, 1 drawn, 0 lost)
+    std::vector<std::uint8_t> results;
+    // each position's score with the weights being tried
+    std::vector<int> scores;
+
+    void add(const BasicBoard<EnglishRules> &board, int result)
+    {
+        positions.add(board);
+        EvalTerms positionTerms = Evaluator::getTerms(board.getPieceMask(true), board.getPieceMask(false),
+                                                      board.getKingMask(true) | board.getKingMask(false));
+        for (int term = 0; term < TERM_COUNT; term++)
+            terms[term].push_back((std::int8_t)(positionTerms.*TERMS[term]));
+        results.push_back((std::uint8_t)result);
+    }
+};
+
+// Every position read, dealt out to the threads' shards in turn.
+struct Dataset
+{
+    std::vector<PositionShard> shards;
+    std::uint64_t positions = 0;
+    // positions left out for not being quiet, and lines or games that couldn't be read
+    std::uint64_t skipped = 0;
+    std::uint64_t invalid = 0;
+
+    explicit Dataset(int threads) : shards(threads) {}
+
+    // Adds a position, if it is quiet.
+    void add(const BasicBoard<EnglishRules> &board, const MoveList &moves, int result)
+    {
+        if (moves.empty() || moves[0].isJump())
+        {
+            skipped++;
+            return;
+        }
+        shards[positions % shards.size()].add(board, result);
+        positions++;
+    }
+};
+
+// What a pass over the positions found.
+struct PassResult
+{
+    // the mean squared error of the expected results
+    double error = 0;
+    // the error's derivative by each weight
+    double gradient[TERM_COUNT] = {};
+};
+
+// Reads a checkers_match archive (see tools/match.cpp), replaying its games.
+static void readArchive(const std::vector<char> &data, Dataset &dataset)
+{
+    std::size_t offset = 8;
+    while (offset + 8 <= data.size())
+    {
+        const unsigned char *record = (const unsigned char *)data.data() + offset;
+        int outcome = record[4] & 0x7F;
+        int openingPlies = record[5];
+        int plies = record[6] | (record[7] << 8);
+        offset += 8;
+        if (outcome > 2 || offset + plies > data.size())
+        {
+            dataset.invalid++;
+            return;
+        }
+        // 0 white won, 1 drawn, 2 black won
+        int result = 2 - outcome;
+
+        BasicBoard<EnglishRules> board;
+        for (int ply = 0; ply < plies; ply++)
+        {
+            MoveList moves;
+            board.getAllLegalMoves(board.isWhiteToMove(), moves);
+            int index = record[8 + ply];
+            if (index >= moves.size())
+            {
+                dataset.invalid++;
+                return;
+            }
+            if (ply >= openingPlies)
+                dataset.add(board, moves, result);
+            board.makeMove(moves[index]);
+        }
+        offset += plies;
+    }
+}
+
+// Reads a position like "W:W9,10,K14:B22,23" (see the top of the file).
+static bool parsePosition(const std::string &text, BasicBoard<EnglishRules> &position)
+{
+    std::istringstream fields(text);
+    std::string field;
+    if (!std::getline(fields, field, ':') || (field != "W" && field != "B" && field != "w" && field != "b"))
+        return false;
+    bool whiteToMove = toupper(field[0]) == 'W';
+
+    bitboard_t pieces[2] = { 0, 0 };
+    bitboard_t kings = 0;
+    while (std::getline(fields, field, ':'))
+    {
+        if (field.empty() || (toupper(field[0]) != 'W' && toupper(field[0]) != 'B'))
+            return false;
+        bool isWhite = toupper(field[0]) == 'W';
+        std::istringstream squares(field.substr(1));
+        std::string square;
+        while (std::getline(squares, square, ','))
+        {
+            bool isKing = !square.empty() && toupper(square[0]) == 'K';
+            int number = atoi(square.c_str() + (isKing ? 1 : 0));
+            if (number < 1 || number > 32)
+                return false;
+            bitboard_t mask = (bitboard_t)1 << (number - 1);
+            if ((pieces[0] | pieces[1]) & mask)
+                return false;
+            pieces[isWhite ? 0 : 1] |= mask;
+            if (isKing)
+                kings |= mask;
+        }
+    }
+    position = BasicBoard<EnglishRules>(pieces[0], pieces[1], kings, whiteToMove);
+    return true;
+}
+
+// Reads a text file of labelled positions, one per line.
+static void readPositions(const std::vector<char> &data, Dataset &dataset)
+{
+    std::istringstream lines(std::string(data.begin(), data.end()));
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        std::istringstream fields(line);
+        std::string resultText;
+        std::string positionText;
+        if (!(fields >> resultText) || resultText[0] == '#')
+            continue;
+
+        int result = resultText == "1-0" ? 2 : resultText == "1/2-1/2" ? 1 : resultText == "0-1" ? 0 : -1;
+        BasicBoard<EnglishRules> board;
+        if (result < 0 || !(fields >> positionText) || !parsePosition(positionText, board))
+        {
+            dataset.invalid++;
+            continue;
+        }
+        MoveList moves;
+        board.getAllLegalMoves(board.isWhiteToMove(), moves);
+        dataset.add(board, moves, result);
+    }
+}
+
+// Reads an archive or a text file of positions, whichever it is.
+static bool readFile(const std::string &path, Dataset &dataset)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.size() >= 8 && std::string(data.data(), 8) == "CKMATCH1")
+        readArchive(data, dataset);
+    else
+        readPositions(data, dataset);
+    return true;
+}
+
+// The expected result for white of a score, from 0 to 1.
+static inline double expectedResult(int score, double scale)
+{
+    return 1 / (1 + std::exp(-scale * score));
+}
+
+// Scores one shard's positions and adds up its error and gradient.
+static void passShard(PositionShard &shard, const EvalWeights &weights, double scale, PassResult &result)
+{
+    shard.scores.resize(shard.positions.size());
+    Evaluator::evaluateBatch(shard.positions, weights, shard.scores.data());
+
+    int count = shard.positions.size();
+    const int *scores = shard.scores.data();
+    const std::uint8_t *results = shard.results.data();
+    for (int i = 0; i < count; i++)
+    {
+        double expected = expectedResult(scores[i], scale);
+        double difference = expected - results[i] * 0.5;
+        result.error += difference * difference;
+        // the error's derivative by the score
+        double slope = difference * expected * (1 - expected);
+        for (int term = 0; term < TERM_COUNT; term++)
+            result.gradient[term] += slope * shard.terms[term][i];
+    }
+}
+
+// Makes a pass over every position, a thread per shard.
+static PassResult runPass(Dataset &dataset, const EvalWeights &weights, double scale)
+{
+    std::vector<PassResult> results(dataset.shards.size());
+    std::vector<std::thread> workers;
+    for (std::size_t t = 1; t < dataset.shards.size(); t++)
+        workers.emplace_back(passShard, std::ref(dataset.shards[t]), std::cref(weights), scale, std::ref(results[t]));
+    passShard(dataset.shards[0], weights, scale, results[0]);
+    for (std::thread &worker : workers)
+        worker.join();
+
+    PassResult total;
+    for (const PassResult &result : results)
+    {
+        total.error += result.error;
+        for (int term = 0; term < TERM_COUNT; term++)
+            total.gradient[term] += result.gradient[term];
+    }
+    total.error /= dataset.positions;
+    for (int term = 0; term < TERM_COUNT; term++)
+        total.gradient[term] *= 2 * scale / dataset.positions;
+    return total;
+}
+
+// Finds the scale of the curve that fits the results best with the given weights (golden section search).
+static double fitScale(Dataset &dataset, const EvalWeights &weights)
+{
+    const double ratio = (std::sqrt(5.0) - 1) / 2;
+    double low = MIN_SCALE;
+    double high = MAX_SCALE;
+    while (high - low > MIN_SCALE / 100)
+    {
+        double left = high - ratio * (high - low);
+        double right = low + ratio * (high - low);
+        if (runPass(dataset, weights, left).error < runPass(dataset, weights, right).error)
+            high = right;
+        else
+            low = left;
+    }
+    return (low + high) / 2;
+}
+
+static EvalWeights roundWeights(const double *values)
+{
+    EvalWeights weights;
+    for (int term = 0; term < TERM_COUNT; term++)
+        weights.*WEIGHTS[term] = (int)std::lround(values[term]);
+    return weights;
+}
+
+static std::string describeWeights(const EvalWeights &weights)
+{
+    std::ostringstream text;
+    for (int term = 0; term < TERM_COUNT; term++)
+        text << (term > 0 ? " " : "") << TERM_NAMES[term] << " " << weights.*WEIGHTS[term];
+    return text.str();
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: checkers_tune [--output FILE] [--weights FILE] [--epochs N] [--rate R] [--threads N] POSITIONS..." << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string output = "eval.weights";
+    std::string startPath;
+    int epochs = 200;
+    double rate = 1;
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--output" && i + 1 < argc)
+            output = argv[++i];
+        else if (arg == "--weights" && i + 1 < argc)
+            startPath = argv[++i];
+        else if (arg == "--epochs" && i + 1 < argc)
+            epochs = std::max(0, atoi(argv[++i]));
+        else if (arg == "--rate" && i + 1 < argc)
+            rate = std::max(0.0, atof(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc)
+            threads = std::max(1, atoi(argv[++i]));
+        else if (arg.size() > 1 && arg[0] == '-')
+        {
+            printUsage();
+            return 1;
+        }
+        else
+            inputs.push_back(arg);
+    }
+    if (inputs.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    EvalWeights start;
+    if (!startPath.empty() && !Evaluator::readWeights(startPath, start))
+    {
+        std::cerr << "Could not read the weights file " << startPath << std::endl;
+        return 1;
+    }
+
+    auto loadStart = std::chrono::steady_clock::now();
+    Dataset dataset(threads);
+    for (const std::string &input : inputs)
+    {
+        if (!readFile(input, dataset))
+        {
+            std::cerr << "Could not read " << input << std::endl;
+            return 1;
+        }
+    }
+    double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count();
+    std::cout << "Read " << dataset.positions << " quiet positions (" << dataset.skipped << " left out, "
+              << dataset.invalid << " unreadable lines or games) in " << std::fixed << std::setprecision(2)
+              << loadSeconds << " s" << std::endl;
+    if (dataset.positions == 0)
+    {
+        std::cerr << "No positions to tune with" << std::endl;
+        return 1;
+    }
+
+    double scale = fitScale(dataset, start);
+    PassResult startPass = runPass(dataset, start, scale);
+    std::cout << "Scale " << std::setprecision(5) << scale << " per hundredth of a man, error " << std::setprecision(6)
+              << startPass.error << " with " << describeWeights(start) << " (" << Evaluator::getBackendName(Evaluator::getBestBackend())
+              << ", " << threads << " threads)" << std::endl;
+
+    // the weights being tried, as real numbers (they are rounded to be evaluated), and Adam's running means
+    double values[TERM_COUNT];
+    double meanGradient[TERM_COUNT] = {};
+    double meanSquare[TERM_COUNT] = {};
+    for (int term = 0; term < TERM_COUNT; term++)
+        values[term] = start.*WEIGHTS[term];
+    EvalWeights best = start;
+    double bestError = startPass.error;
+
+    for (int epoch = 1; epoch <= epochs; epoch++)
+    {
+        auto epochStart = std::chrono::steady_clock::now();
+        EvalWeights weights = roundWeights(values);
+        PassResult pass = runPass(dataset, weights, scale);
+        if (pass.error < bestError)
+        {
+            bestError = pass.error;
+            best = weights;
+        }
+
+        for (int term = 0; term < TERM_COUNT; term++)
+        {
+            if (term == FIXED_TERM)
+                continue;
+            meanGradient[term] = MEAN_DECAY * meanGradient[term] + (1 - MEAN_DECAY) * pass.gradient[term];
+            meanSquare[term] = SQUARE_DECAY * meanSquare[term] + (1 - SQUARE_DECAY) * pass.gradient[term] * pass.gradient[term];
+            double mean = meanGradient[term] / (1 - std::pow(MEAN_DECAY, epoch));
+            double square = meanSquare[term] / (1 - std::pow(SQUARE_DECAY, epoch));
+            values[term] -= rate * mean / (std::sqrt(square) + 1e-12);
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - epochStart).count();
+        std::cout << "Epoch " << std::setw(4) << epoch << "  error " << std::setprecision(6) << pass.error << "  "
+                  << describeWeights(weights) << "  " << std::setprecision(3) << seconds << " s" << std::endl;
+    }
+
+    if (!Evaluator::writeWeights(output, best))
+    {
+        std::cerr << "Could not write " << output << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << describeWeights(best) << " (error " << std::setprecision(6) << bestError << ") to "
+              << output << std::endl;
+    return 0;
+}